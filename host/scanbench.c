@@ -0,0 +1,305 @@
+/*
+ * SD Check host benchmark.
+ * Runs the Deep Check engine against a plain POSIX directory so engine-side
+ * throughput changes can be measured on a Linux box:
+ *
+ *   make host
+ *   ./sdcheck-host [key=value ...] <dir>
+ *   ./sdcheck-host --resume
+ *   ./sdcheck-host --manifest-dump [file]
+ *
+ * Keys are the same as in sdmc:/switch/sdcheck.cfg (e.g. full_read=1 pipeline_slots=0).
+ * The host build keeps the resume journal in the current directory; Ctrl-C leaves a
+ * checkpoint that --resume continues (with the settings it was started with).
+ * The manifest (sdcheck.manifest) also lives in the current directory; --manifest-dump
+ * prints it as tab-separated text, so one copied off a card can be read on the PC.
+ */
+#include "app.h"
+#include "util.h"
+#include "log.h"
+#include "config.h"
+#include "scan_engine.h"
+#include "crc32.h"
+#include "hash.h"
+#include "manifest.h"
+#include "scan_io.h"
+
+#include <signal.h>
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+static void on_sigint(int sig) {
+    (void)sig;
+    g_interrupted = 1;
+}
+
+static void bench_ui_update(ScanStats* st, PadState* pad, bool force) {
+    (void)pad;
+    if (g_interrupted) st->cancelled = true;
+
+    uint64_t now = now_ms();
+    if (!force && st->ui_last_ms && (now - st->ui_last_ms) < 1000) return;
+
+    uint64_t el = scan_stats_elapsed_ms(st, now);
+    double secs = (double)el / 1000.0;
+    double mibs = (secs > 0.0) ? ((double)st->bytes_read / 1048576.0 / secs) : 0.0;
+    fprintf(stderr, "\r%8.1f s  %10.2f MiB  %8.2f MiB/s  files %llu/%llu ",
+            secs, (double)st->bytes_read / 1048576.0, mibs,
+            (unsigned long long)st->files_read, (unsigned long long)st->files_total);
+    st->ui_last_ms = now;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [key=value ...] <dir>\n       %s --resume\n       %s --manifest-dump [file]\n", argv0, argv0, argv0);
+    fprintf(stderr, "keys: same as sdcheck.cfg (preset, full_read, chunk_mode, pipeline_slots, ...)\n");
+}
+
+static int manifest_dump(const char* path) {
+    Manifest m;
+    if (!manifest_load(&m, path)) {
+        fprintf(stderr, "%s: %s\n", path, errno == EILSEQ ? "not a valid manifest" : strerror(errno));
+        return 1;
+    }
+    printf("# %s: %llu entries, written %lld\n", path, (unsigned long long)m.count, (long long)m.hdr->created);
+    printf("# path\tsize\tmtime\tverified_at\tcrc32\thash\tdigest\n");
+    for (uint64_t i = 0; i < m.count; i++) {
+        const ManifestEntry* e = &m.ents[i];
+        HashDigest d;
+        memset(&d, 0, sizeof(d));
+        d.algo = (e->hash_algo < HASH_ALGO_COUNT) ? (HashAlgo)e->hash_algo : HASH_CRC32;
+        d.len = (uint8_t)hash_digest_len(d.algo);
+        memcpy(d.b, e->digest, d.len);
+        char hex[2 * HASH_DIGEST_MAX + 1];
+        hash_hex(hex, sizeof(hex), &d);
+        printf("%s\t%llu\t%lld\t%lld\t%08X\t%s\t%s\n", manifest_name(&m, e), (unsigned long long)e->size,
+               (long long)e->mtime, (long long)e->verified_at, (unsigned int)e->crc,
+               d.len ? hash_algo_name(d.algo) : "-", d.len ? hex : "-");
+    }
+    manifest_close(&m);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--manifest-dump") == 0) return manifest_dump(argc >= 3 ? argv[2] : MANIFEST_PATH);
+
+    cfg_reset_defaults();
+    log_clear();
+
+    const char* root = NULL;
+    bool resume = false;
+    ScanResumeInfo ri;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--resume") == 0) {
+            resume = true;
+            continue;
+        }
+        char kv[512];
+        snprintf(kv, sizeof(kv), "%s", argv[i]);
+        char* eq = strchr(kv, '=');
+        if (!eq) {
+            root = argv[i];
+            continue;
+        }
+        *eq = 0;
+        int preset = -1;
+        if (!cfg_apply_kv(&g_cfg, &g_ui, kv, eq + 1, &preset)) {
+            fprintf(stderr, "unknown key: %s\n", kv);
+            return 2;
+        }
+        if (preset >= 0) apply_preset(&g_cfg, (PresetMode)(preset > (int)PRESET_FORENSICS ? (int)PRESET_FORENSICS : preset));
+    }
+    if (resume) {
+        if (!scan_resume_peek(&ri)) {
+            fprintf(stderr, "nothing to resume (%s)\n", SCAN_RESUME_PATH);
+            return 2;
+        }
+        g_cfg = ri.cfg;
+        root = ri.root;
+    }
+    if (!root) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, on_sigint);
+
+    ScanStats* st = (ScanStats*)calloc(1, sizeof(ScanStats));
+    if (!st) return 1;
+    st->ui_active = true;
+    st->ui_start_ms = now_ms();
+    st->run_full_read = g_cfg.full_read;
+    st->run_large_limit = g_cfg.large_file_limit;
+    st->run_retries = g_cfg.read_retries;
+    st->run_consistency = g_cfg.consistency_check;
+    st->run_skip_folders = g_cfg.skip_known_folders;
+    st->run_skip_exts = g_cfg.skip_media_exts;
+    st->run_chunk = g_cfg.chunk_mode;
+
+    uint64_t t0 = armGetSystemTick();
+    bool ok = resume ? scan_engine_resume(st, NULL, bench_ui_update) : scan_engine_run(root, &g_cfg, st, NULL, bench_ui_update);
+    double secs = ticks_to_seconds(armGetSystemTick() - t0);
+    fprintf(stderr, "\n");
+
+    double mib = (double)st->bytes_read / 1048576.0;
+    printf("root:        %s\n", root);
+    printf("settings:    preset=%s full_read=%s chunk=%s pipeline_slots=%d lookahead=%d readers=%d retries=%d consistency=%s io=%s\n",
+           preset_name(g_cfg.preset), onoff(g_cfg.full_read), chunk_name(g_cfg.chunk_mode),
+           g_cfg.pipeline_slots, st->run_lookahead, st->run_readers, g_cfg.read_retries, onoff(g_cfg.consistency_check), st->run_io_backend);
+    printf("result:      %s%s\n", ok ? "completed" : "setup failed", st->cancelled ? " (cancelled)" : "");
+    if (st->resumes) {
+        printf("resumed:     %u time(s), %.1f s before this session\n", st->resumes, (double)st->resume_prior_ms / 1000.0);
+    }
+    printf("dirs/files:  %llu dirs, %llu/%llu files read\n",
+           (unsigned long long)st->dirs_total, (unsigned long long)st->files_read, (unsigned long long)st->files_total);
+    printf("read:        %.2f MiB in %.3f s = %.2f MiB/s\n", mib, secs, (secs > 0.0) ? mib / secs : 0.0);
+    printf("metadata:    stat() calls %llu, avoided %llu\n",
+           (unsigned long long)st->stats_performed, (unsigned long long)st->stats_avoided);
+    printf("enumeration: %llu dirs, %llu entries in %.3f ms (%.2f us/entry); file reads %.3f ms\n",
+           (unsigned long long)st->dir_enum_dirs, (unsigned long long)st->dir_enum_entries,
+           (double)st->dir_enum_us / 1000.0,
+           st->dir_enum_entries ? (double)st->dir_enum_us / (double)st->dir_enum_entries : 0.0,
+           (double)st->read_io_us / 1000.0);
+    printf("look-ahead:  depth %d, reader waited %.3f ms for the walker\n",
+           st->run_lookahead, (double)st->walk_wait_us / 1000.0);
+    printf("range reads: %llu files (range_threads %d, from %d MiB)\n",
+           (unsigned long long)st->ranged_files, g_cfg.range_threads, g_cfg.range_min_mib);
+    printf("hash:        %s, hasher %.2f MiB in %.3f ms, readers waited %.3f ms\n",
+           hash_algo_name(g_cfg.hash_algo), (double)st->hash_bytes / 1048576.0, (double)st->hash_us / 1000.0,
+           (double)st->hash_wait_us / 1000.0);
+    printf("sampling:    %llu files, %llu regions, %.2f MiB of %.2f MiB, seed %llu\n",
+           (unsigned long long)st->sample_files, (unsigned long long)st->sample_regions,
+           (double)st->sample_bytes / 1048576.0, (double)st->sample_span_bytes / 1048576.0,
+           (unsigned long long)st->sample_seed);
+    printf("verified:    %.2f MiB of %.2f MiB (%.2f%%)\n", (double)st->bytes_read / 1048576.0,
+           (double)st->bytes_total / 1048576.0, st->bytes_total ? 100.0 * (double)st->bytes_read / (double)st->bytes_total : 100.0);
+    if (st->budget_on) {
+        printf("budget:      %d min, %.1f s left; pre-pass %llu files in %llu ms; full %llu, sampled %llu, skipped %llu; share %.2f%%, keep %.1f%%, %u re-plans\n",
+               g_cfg.time_budget_min, (double)st->budget_left_ms / 1000.0,
+               (unsigned long long)st->budget_pre_files, (unsigned long long)st->budget_pre_ms,
+               (unsigned long long)st->budget_full, (unsigned long long)st->budget_sampled,
+               (unsigned long long)st->budget_skipped, st->budget_frac * 100.0, st->budget_keep * 100.0, st->budget_solves);
+        uint64_t kept = st->budget_full + st->budget_sampled;
+        if (kept > 0)
+            printf("coverage:    per file read mean %.1f%%, lowest %.2f%%\n",
+                   100.0 * st->budget_share_sum / (double)kept, st->budget_share_min * 100.0);
+    }
+    if (st->manifest_on) {
+        printf("manifest:    %llu loaded, %llu written%s; new %llu, changed %llu, stale %llu, unchanged %llu (%.2f MiB%s)\n",
+               (unsigned long long)st->manifest_loaded, (unsigned long long)st->manifest_written,
+               st->manifest_write_ok ? "" : " (write failed)",
+               (unsigned long long)st->manifest_new, (unsigned long long)st->manifest_changed,
+               (unsigned long long)st->manifest_stale, (unsigned long long)st->manifest_unchanged,
+               (double)st->manifest_unchanged_bytes / 1048576.0, st->incremental_on ? ", skipped" : "");
+        printf("bit-rot:     %llu of %llu checked file(s) changed (%.2f MiB)\n", (unsigned long long)st->bitrot_files,
+               (unsigned long long)st->bitrot_checked, (double)st->bitrot_bytes / 1048576.0);
+    }
+    if (st->tune_chunk) {
+        printf("chunk tuner: %u KiB chosen, %u round(s)\n", st->tune_chunk / 1024u, st->tune_rounds);
+        for (int i = 0; i < TUNE_SIZES; i++) {
+            printf("  %5u KiB: %8.2f MiB/s  %10.1f MiB\n", 64u << i, st->tune_mib_s[i], (double)st->tune_bytes[i] / 1048576.0);
+        }
+    }
+    for (int i = 0; i < st->run_readers; i++) {
+        double wmib = (double)st->worker_bytes[i] / 1048576.0;
+        printf("reader %d:    %llu files, %.2f MiB, %.2f MiB/s, busy %.0f%%\n", i + 1,
+               (unsigned long long)st->worker_files[i], wmib, (secs > 0.0) ? wmib / secs : 0.0,
+               (secs > 0.0) ? 100.0 * (double)st->worker_busy_us[i] / 1e6 / secs : 0.0);
+    }
+    printf("errors:      read=%llu (transient %llu) open=%llu stat=%llu path=%llu consistency=%llu\n",
+           (unsigned long long)st->read_errors, (unsigned long long)st->read_errors_transient,
+           (unsigned long long)st->open_errors, (unsigned long long)st->stat_errors,
+           (unsigned long long)st->path_errors, (unsigned long long)st->consistency_errors);
+    if (st->bisect_recovered > 0)
+        printf("bisection:   %llu KiB of failed spans read fine block by block\n", (unsigned long long)(st->bisect_recovered / 1024));
+    if (st->bad_files > 0) {
+        printf("bad regions: %llu file(s), %llu extent(s), %llu KiB unreadable; %llu bisection reads (%.2f MiB)\n",
+               (unsigned long long)st->bad_files, (unsigned long long)st->bad_extents,
+               (unsigned long long)(st->bad_bytes / 1024), (unsigned long long)st->bisect_reads,
+               (double)st->bisect_bytes / 1048576.0);
+        for (int i = 0; i < st->bad_count; i++) {
+            const BadFileEntry* b = &st->bad[i];
+            printf("  %s: %u extent(s), %llu KiB:", b->path, b->extents, (unsigned long long)(b->bad_bytes / 1024));
+            for (uint32_t k = 0; k < b->shown; k++)
+                printf(" %llu+%llu", (unsigned long long)b->ext[k].off, (unsigned long long)b->ext[k].len);
+            printf("\n");
+        }
+    }
+    if (st->stalls.count > 0) {
+        const StallStats* sl = &st->stalls;
+        printf("stalls:      %llu op(s), %llu ms, longest %llu ms (%s %s)\n             ", (unsigned long long)sl->count,
+               (unsigned long long)sl->total_ms, (unsigned long long)sl->max_ms, op_kind_name(sl->max_kind), sl->max_path);
+        for (int b = 0; b < STALL_BUCKETS; b++) printf(" %s:%llu", stall_bucket_name(b), (unsigned long long)sl->hist[b]);
+        printf("\n");
+    }
+    printf("latency:     %-8s %10s %9s %9s %9s %9s %9s\n", "op", "count", "p50", "p90", "p99", "p99.9", "max");
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        LatSummary l;
+        lat_summarize(&st->lat[k], &l);
+        if (!l.count) continue;
+        char p[LAT_PCTS][16], mx[16];
+        for (int i = 0; i < LAT_PCTS; i++) lat_format(p[i], sizeof(p[i]), l.p_us[i]);
+        lat_format(mx, sizeof(mx), l.max_us);
+        printf("             %-8s %10llu %9s %9s %9s %9s %9s\n", op_kind_name((OpKind)k), (unsigned long long)l.count,
+               p[0], p[1], p[2], p[3], mx);
+    }
+    uint64_t ph[PHASE_COUNT];
+    scan_phase_times(st, ph);
+    printf("phases:     ");
+    for (int k = 0; k < PHASE_COUNT; k++)
+        if (ph[k]) printf(" %s=%.1fms", scan_phase_name((ScanPhase)k), (double)ph[k] / 1000.0);
+    printf("\n");
+    SlowEntry se[SLOW_MAX];
+    int sn = slow_sorted(&st->slow_rate, se);
+    for (int i = 0; i < sn; i++)
+        printf("%s %8.2f MiB/s %8.1f MiB  %s\n", i ? "            " : "slow rate:  ", slow_mib_s(&se[i]), (double)se[i].n / 1048576.0, se[i].path);
+    sn = slow_sorted(&st->slow_time, se);
+    for (int i = 0; i < sn; i++)
+        printf("%s %8.1f ms %8.1f MiB  %s\n", i ? "            " : "slow time:  ", (double)se[i].us / 1000.0, (double)se[i].n / 1048576.0, se[i].path);
+    sn = slow_sorted(&st->slow_dirs, se);
+    for (int i = 0; i < sn; i++)
+        printf("%s %8llu us/entry %6llu  %s\n", i ? "            " : "slow dirs:  ", (unsigned long long)se[i].key, (unsigned long long)se[i].n, se[i].path);
+    if (st->timeline_samples > 0)
+        printf("timeline:    %u sample(s) of %u s -> %s%s\n", st->timeline_samples, st->timeline_interval_s, TIMELINE_PATH,
+               st->timeline_write_ok ? "" : " (write failed)");
+    if (st->trace_events > 0)
+        printf("trace:       %llu event(s), %llu dropped -> %s%s\n", (unsigned long long)st->trace_events,
+               (unsigned long long)st->trace_dropped, TRACE_PATH, st->trace_write_ok ? "" : " (write failed)");
+    if (st->read_timeouts > 0)
+        printf("timeouts:    %llu read(s) given up, %d still hanging\n", (unsigned long long)st->read_timeouts, io_reads_hanging());
+    if (st->retry_deferred > 0) {
+        printf("retry queue: %llu deferred, %llu read back\n", (unsigned long long)st->retry_deferred,
+               (unsigned long long)st->retry_recovered);
+    }
+    if (st->first_fail_set) {
+        printf("first fail:  %s errno=%d %s\n", st->first_fail_kind, st->first_fail_errno, st->first_fail_path);
+    }
+    printf("crc32:      ");
+    for (int i = 0; i < crc32_kernel_count(); i++) {
+        const Crc32KernelInfo* k = crc32_kernel_info(i);
+        if (!k->available) continue;
+        printf(" %s%s=%.0f", k->name, strcmp(k->name, crc32_kernel_name()) == 0 ? "*" : "",
+               k->verified ? k->mib_s : -1.0);
+    }
+    printf(" MiB/s\n");
+    hash_init();
+    printf("hash kernels:");
+    for (int i = 0; i < hash_kernel_count(); i++) {
+        const HashKernelInfo* k = hash_kernel_info(i);
+        if (!k->available) continue;
+        printf(" %s%s=%.0f", k->name, strcmp(k->name, hash_kernel_name(k->algo)) == 0 ? "*" : "",
+               k->verified ? k->mib_s : -1.0);
+    }
+    printf(" MiB/s\n");
+    printf("perf:        ops=%llu stalls=%llu longest=%llu ms\n",
+           (unsigned long long)st->perf_ops, (unsigned long long)st->perf_stalls,
+           (unsigned long long)st->perf_longest_ms);
+
+    int n = log_ring_count();
+    for (int i = 0; i < n; i++) {
+        const char* line = log_ring_line(i);
+        if (line && (strstr(line, "ERROR") || strstr(line, "WARN"))) fprintf(stderr, "%s\n", line);
+    }
+
+    free(st);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Manifest record counts across runs that read, sample or skip files (make host-test).
+#   1. a full read records every file
+#   2. a run that samples the large files keeps their records (it still prunes)
+#   3. a full read after a delete drops that file's record
+set -e
+BIN=$(cd "$(dirname "$0")/.." && pwd)/sdcheck-host
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+mkdir tree
+i=1
+while [ $i -le 20 ]; do
+    head -c $((4096 * i)) /dev/zero > tree/small$i.bin
+    i=$((i + 1))
+done
+for n in 1 2 3; do truncate -s 20M tree/large$n.bin; done   # above large_file_limit_mib=16
+
+records() {
+    "$BIN" --manifest-dump sdcheck.manifest | head -n 1 | sed 's/.*: \([0-9]*\) entries.*/\1/'
+}
+
+check() {
+    if [ "$2" != "$3" ]; then
+        echo "FAIL: $1: $2 records, expected $3"
+        exit 1
+    fi
+    echo "ok:   $1: $2 records"
+}
+
+"$BIN" manifest=1 full_read=1 tree > /dev/null 2>&1
+check "full read" "$(records)" 23
+
+"$BIN" manifest=1 full_read=0 large_file_limit_mib=16 tree > /dev/null 2>&1
+check "large files sampled" "$(records)" 23
+
+rm tree/small1.bin
+"$BIN" manifest=1 full_read=1 tree > /dev/null 2>&1
+check "full read after a delete" "$(records)" 22
@@ -1,8 +1,12 @@
 #pragma once
 
+#ifdef __SWITCH__
 #include <switch.h>
 #include <switch/runtime/pad.h>
 #include <switch/services/hid.h>
+#else
+#include "host_compat.h"
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -49,12 +53,38 @@
 
 #define LARGEST_MAX     10
 #define FAIL_MAX        5
+#define BITROT_MAX      5
+#define BADFILE_MAX     5
+#define BADEXT_SHOWN    4
 
 typedef struct {
     uint64_t size;
     char path[256];
 } LargestEntry;
 
+/* A file whose content no longer matches its recorded CRC */
+typedef struct {
+    uint32_t crc;            /* this run */
+    uint32_t recorded;       /* manifest */
+    int64_t  verified_at;    /* when the recorded CRC was taken */
+    uint64_t size;
+    char path[256];
+} BitrotEntry;
+
+/* A file with unreadable extents, located by bisecting its failed reads */
+typedef struct {
+    uint64_t off;
+    uint64_t len;
+} BadExtent;
+
+typedef struct {
+    uint64_t  bad_bytes;
+    uint32_t  extents;                 /* found (adjacent ones merged) */
+    uint32_t  shown;                   /* the first BADEXT_SHOWN are kept */
+    BadExtent ext[BADEXT_SHOWN];
+    char path[256];
+} BadFileEntry;
+
 /* Sample regions */
 #define SAMPLE_REGION   (64u * 1024u)
 
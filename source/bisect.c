@@ -0,0 +1,142 @@
+#include "bisect.h"
+#include "util.h"
+#include "log.h"
+
+#define BADEXT_LOG_MAX 16            /* extents listed in the log per file */
+
+static void bad_extent_log(BadFileAcc* acc) {
+    if (acc->last.len == 0) return;
+    if (acc->logged == 0) log_pushf("ERROR", "Unreadable extents in %.150s:", acc->e.path);
+    if (acc->logged < BADEXT_LOG_MAX)
+        log_pushf("ERROR", "  @ %llu, %llu KiB", (unsigned long long)acc->last.off, (unsigned long long)(acc->last.len / 1024));
+    acc->logged++;
+}
+
+static void bad_extent_add(BadFileAcc* acc, const char* path, uint64_t off, uint64_t len) {
+    if (acc->e.extents == 0) snprintf(acc->e.path, sizeof(acc->e.path), "%.250s", path ? path : "");
+    acc->e.bad_bytes += len;
+    if (acc->last.len > 0 && acc->last.off + acc->last.len == off) {
+        acc->last.len += len;
+        if (acc->e.extents <= BADEXT_SHOWN) acc->e.ext[acc->e.extents - 1].len += len;
+        return;
+    }
+    bad_extent_log(acc);
+    acc->last.off = off;
+    acc->last.len = len;
+    if (acc->e.shown < BADEXT_SHOWN) acc->e.ext[acc->e.shown++] = acc->last;
+    acc->e.extents++;
+}
+
+void bad_file_flush(ScanStats* st, BadFileAcc* acc) {
+    if (acc->e.extents == 0) return;
+    bad_extent_log(acc);
+    if (acc->logged > BADEXT_LOG_MAX) log_pushf("ERROR", "  ... %u more", acc->logged - BADEXT_LOG_MAX);
+    log_pushf("ERROR", "  %u extent(s), %llu KiB unreadable", acc->e.extents, (unsigned long long)(acc->e.bad_bytes / 1024));
+
+    st->bad_extents += acc->e.extents;
+    st->bad_bytes += acc->e.bad_bytes;
+    BadFileEntry* dst = NULL;
+    for (int i = 0; i < st->bad_count; i++) {
+        if (strcmp(st->bad[i].path, acc->e.path) == 0) dst = &st->bad[i];
+    }
+    if (dst) {
+        for (uint32_t k = 0; k < acc->e.shown && dst->shown < BADEXT_SHOWN; k++) dst->ext[dst->shown++] = acc->e.ext[k];
+        dst->extents += acc->e.extents;
+        dst->bad_bytes += acc->e.bad_bytes;
+    } else {
+        st->bad_files++;
+        if (st->bad_count < BADFILE_MAX) st->bad[st->bad_count++] = acc->e;
+    }
+    memset(acc, 0, sizeof(*acc));
+}
+
+bool bisect_init(Bisect* b, IoFile* f, const char* path, const ScanConfig* cfg, ScanStats* st, BadFileAcc* acc, ReadGuard* guard, uint8_t** bufp, size_t cap) {
+    if (!cfg || cfg->bisect_min_kib <= 0 || !acc || !bufp || !*bufp || cap == 0) return false;
+    b->f = f;
+    b->path = path;
+    b->st = st;
+    b->acc = acc;
+    b->guard = guard;
+    b->bufp = bufp;
+    b->cap = cap;
+    b->block = (uint64_t)cfg->bisect_min_kib * 1024u;
+    b->gone = false;
+    return true;
+}
+
+/* One attempt at [off, off + len), no retry. */
+static bool bisect_read(Bisect* b, uint64_t off, uint64_t len) {
+    while (len > 0) {
+        size_t want = (len < b->cap) ? (size_t)len : b->cap;
+        size_t r = 0;
+        bool ok = guarded_pread(b->guard, b->f, b->path, b->bufp, b->cap, want, off, &r);
+        if (read_abandoned(b->st, b->f, b->path, off, want, "bisection")) {
+            b->gone = true;
+            return false;
+        }
+        b->st->bisect_reads++;
+        b->st->bisect_bytes += r;
+        if (!ok || r == 0) return false;
+        off += r;
+        len -= r;
+    }
+    return true;
+}
+
+static void bisect_find(Bisect* b, uint64_t off, uint64_t len, bool known_bad) {
+    if (len == 0 || b->st->cancelled || b->gone) return;
+    if (off / b->block == (off + len - 1) / b->block) {
+        /* A leaf is read even when its span is known bad: the fault may be elsewhere or gone. */
+        if (bisect_read(b, off, len)) b->st->bisect_recovered += len;
+        else if (!b->gone) bad_extent_add(b->acc, b->path, off, len);
+        return;
+    }
+    if (!known_bad && bisect_read(b, off, len)) return;
+    if (b->gone) return;
+
+    /* Split at a block boundary near the middle: both halves are non-empty. */
+    uint64_t mid = (off + len / 2) / b->block * b->block;
+    if (mid <= off) mid += b->block;
+    uint64_t llen = mid - off;
+    if (bisect_read(b, off, llen)) {
+        bisect_find(b, mid, len - llen, true);
+    } else {
+        bisect_find(b, off, llen, true);
+        bisect_find(b, mid, len - llen, false);
+    }
+}
+
+void bisect_salvage(Bisect* b, uint64_t off, uint64_t len, uint64_t bad_len, uint64_t* done) {
+    if (bad_len > len) bad_len = len;
+    bisect_find(b, off, bad_len, true);
+    if (done) *done += bad_len;
+    off += bad_len;
+    len -= bad_len;
+    while (len > 0 && !b->st->cancelled && !b->gone) {
+        size_t want = (len < b->cap) ? (size_t)len : b->cap;
+        size_t r = 0;
+        uint64_t t0 = now_us();
+        bool ok = guarded_pread(b->guard, b->f, b->path, b->bufp, b->cap, want, off, &r);
+        uint64_t dt = now_us() - t0;
+        if (read_abandoned(b->st, b->f, b->path, off, want, "bisection")) {
+            b->gone = true;
+            break;
+        }
+        if (r > 0) {
+            perf_record(b->st, r, dt, off, b->path);
+            b->st->bytes_read += r;
+            if (done) *done += r;
+            off += r;
+            len -= r;
+            want -= r;
+        }
+        if (ok) {
+            if (r > 0) continue;
+            break;                      /* EOF inside the listed size: the file shrank */
+        }
+        bisect_find(b, off, want, true);
+        if (done) *done += want;
+        off += want;
+        len -= want;
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "scan_internal.h"
+
+/*
+ * A read that failed for good is narrowed down instead of written off at chunk size: the
+ * failed span is split at bisect_min_kib-aligned offsets and only the halves still in question
+ * are read. When the left half reads, the failure is in the right one, which is split without
+ * being read whole; one bad block in a 1 MiB chunk costs about log2(chunk / block) reads of
+ * shrinking size. Every block is read once itself before it is recorded as bad; one that reads
+ * counts as recovered (an intermittent fault, or a span that was not bad as a whole). These
+ * reads only locate: they are not hashed and not counted in bytes_read. The rest of the file is
+ * then read on past the bad extents.
+ */
+
+/* Unreadable extents of the file being read; flushed into ScanStats once it is done. */
+typedef struct {
+    BadFileEntry e;
+    BadExtent    last;               /* grows while adjacent blocks fail */
+    uint32_t     logged;
+} BadFileAcc;
+
+typedef struct {
+    IoFile*     f;
+    const char* path;
+    ScanStats*  st;
+    BadFileAcc* acc;
+    ReadGuard*  guard;
+    uint8_t**   bufp;
+    size_t      cap;
+    uint64_t    block;
+    bool        gone;      /* a read was given up: f is closed, stop */
+} Bisect;
+
+/* False: bisection off (bisect_min_kib 0) or nowhere to record. */
+bool bisect_init(Bisect* b, IoFile* f, const char* path, const ScanConfig* cfg, ScanStats* st, BadFileAcc* acc, ReadGuard* guard, uint8_t** bufp, size_t cap);
+/* [off, off + len) after a failed read of its first bad_len bytes: locates the bad extents in
+   those, then reads on to the end, bisecting each chunk that fails. done: progress to advance. */
+void bisect_salvage(Bisect* b, uint64_t off, uint64_t len, uint64_t bad_len, uint64_t* done);
+/* File done: its extents go into the summary (merged with an earlier part of the same file). */
+void bad_file_flush(ScanStats* st, BadFileAcc* acc);
@@ -0,0 +1,167 @@
+#include "budget.h"
+#include "util.h"
+
+void plan_init(BudgetPlan* p, const ScanConfig* cfg, int readers, uint64_t start_us) {
+    memset(p, 0, sizeof(*p));
+    pthread_mutex_init(&p->lock, NULL);
+    p->deadline_us = start_us + (uint64_t)cfg->time_budget_min * 60ull * 1000000ull;
+    p->readers = readers > 0 ? readers : 1;
+    p->region = (double)cfg->sample_region_kib * 1024.0;
+    p->consistency = cfg->consistency_check;
+    p->frac = 1.0;
+    p->keep = 1.0;
+}
+
+void plan_free(BudgetPlan* p) {
+    pthread_mutex_destroy(&p->lock);
+}
+
+static int plan_bucket(uint64_t size) {
+    int b = 0;
+    while (size > 1 && b < PLAN_BUCKETS - 1) {
+        size >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void plan_add(BudgetPlan* p, uint64_t size) {
+    int b = plan_bucket(size);
+    p->hist_n[b]++;
+    p->hist_bytes[b] += size;
+    p->pre_files++;
+    p->pre_bytes += size;
+}
+
+/* Bytes read from a file of 'size' at share f (samples never go below head + tail). */
+static double plan_read_cost(const BudgetPlan* p, double size, double f) {
+    double min = 2.0 * p->region;
+    if (size <= min || f >= 1.0) return size;
+    double r = f * size;
+    if (r < min) r = min;
+    if (r >= size) return size;
+    return p->consistency ? 2.0 * r : r;
+}
+
+/* Expected time (us) of the files not reached yet at share f, all of them kept. */
+static double plan_rest_cost(const BudgetPlan* p, double f, double bytes_per_us, double file_us) {
+    double t = 0.0;
+    for (int b = 0; b < PLAN_BUCKETS; b++) {
+        if (!p->hist_n[b]) continue;
+        double n = (double)p->hist_n[b];
+        double mean = (double)p->hist_bytes[b] / n;
+        t += n * (file_us + plan_read_cost(p, mean, f) / bytes_per_us);
+    }
+    return t;
+}
+
+/* Re-solves frac/keep for the time left. Called with the lock held. */
+static void plan_solve(BudgetPlan* p, uint64_t now) {
+    p->last_us = now;
+    if (p->done_io_us < PLAN_WARMUP_US || p->done_bytes == 0) return;   /* warm-up: plan_decide() */
+    double per_reader_io = (double)p->done_io_us / (double)p->readers;
+    double bytes_per_us = (double)p->done_bytes / per_reader_io;
+    double file_us = PLAN_DEFAULT_FILE_US;
+    if (p->done_files >= PLAN_MEASURE_FILES && now > p->scan_start_us) {
+        double other = (double)(now - p->scan_start_us) - per_reader_io;
+        file_us = (other > 0.0 ? other : 0.0) / (double)p->done_files;
+    }
+
+    uint64_t rest_files = (p->pre_files > p->seen_files) ? p->pre_files - p->seen_files : 0;
+    double scale = p->pre_files ? (double)rest_files / (double)p->pre_files : 0.0;
+    double queued = (double)(p->decided_files - p->done_files) * file_us +
+                    (double)(p->decided_bytes > p->done_planned ? p->decided_bytes - p->done_planned : 0) / bytes_per_us;
+    double avail = (double)((int64_t)p->deadline_us - (int64_t)now) - queued - (double)p->pre_enum_us * scale;
+
+    double lo = 0.0, hi = 1.0;
+    if (plan_rest_cost(p, 1.0, bytes_per_us, file_us) <= avail) {
+        p->frac = 1.0;
+        p->keep = 1.0;
+    } else {
+        double floor_cost = plan_rest_cost(p, 0.0, bytes_per_us, file_us);
+        if (floor_cost > avail) {
+            p->frac = 0.0;
+            p->keep = (avail > 0.0 && floor_cost > 0.0) ? avail / floor_cost : 0.0;
+        } else {
+            for (int i = 0; i < 24; i++) {
+                double mid = 0.5 * (lo + hi);
+                if (plan_rest_cost(p, mid, bytes_per_us, file_us) <= avail) lo = mid;
+                else hi = mid;
+            }
+            p->frac = lo;
+            p->keep = 1.0;
+        }
+    }
+    p->solves++;
+}
+
+PlanChoice plan_decide(BudgetPlan* p, const ScanConfig* cfg, const char* path, uint64_t size, double* pct, uint64_t* bytes) {
+    pthread_mutex_lock(&p->lock);
+    uint64_t now = now_us();
+    if (now - p->last_us >= PLAN_RECALC_US || p->solves == 0) plan_solve(p, now);
+
+    /* Warm-up (never solved): the floor rate stands in for the measured one. */
+    bool fits_floor = true;
+    if (p->solves == 0) {
+        double bytes_per_us = PLAN_FLOOR_MIB_S * 1048576.0 / 1e6;
+        double queued = (double)(p->decided_files - p->done_files) * PLAN_DEFAULT_FILE_US +
+                        (double)(p->decided_bytes > p->done_planned ? p->decided_bytes - p->done_planned : 0) / bytes_per_us;
+        double need = queued + (double)size / bytes_per_us + plan_rest_cost(p, 0.0, bytes_per_us, PLAN_DEFAULT_FILE_US);
+        fits_floor = need <= (double)((int64_t)p->deadline_us - (int64_t)now);
+        if (!fits_floor && p->decided_files > p->done_files &&
+            (double)plan_read_cost(p, (double)size, 0.0) < (double)size) {
+            pthread_mutex_unlock(&p->lock);
+            return PLAN_HOLD;
+        }
+    }
+
+    p->seen_files++;
+    int b = plan_bucket(size);
+    if (p->hist_n[b]) {
+        p->hist_n[b]--;
+        p->hist_bytes[b] -= (size < p->hist_bytes[b]) ? size : p->hist_bytes[b];
+    }
+
+    PlanChoice ch = PLAN_FULL;
+    if (p->keep < 1.0) {
+        uint64_t h = 1469598103934665603ull;   /* FNV-1a */
+        for (const char* c = path; *c; c++) h = (h ^ (uint8_t)*c) * 1099511628211ull;
+        if ((double)(mix64(h) >> 11) * (1.0 / 9007199254740992.0) >= p->keep) ch = PLAN_SKIP;
+    }
+
+    *pct = -1.0;
+    *bytes = 0;
+    if (ch != PLAN_SKIP) {
+        *bytes = size;
+        double frac = fits_floor ? p->frac : 0.0;
+        if ((double)plan_read_cost(p, (double)size, frac) < (double)size) {
+            SamplePlan sp;
+            ch = PLAN_SAMPLE;
+            *pct = frac * 100.0;
+            sample_plan(&sp, size, cfg, path, *pct);
+            *bytes = sample_planned_bytes(&sp);
+        }
+        p->decided_files++;
+        p->decided_bytes += *bytes;
+    }
+    pthread_mutex_unlock(&p->lock);
+    return ch;
+}
+
+void plan_note(BudgetPlan* p, uint64_t planned, uint64_t bytes, uint64_t io_us) {
+    pthread_mutex_lock(&p->lock);
+    p->done_files++;
+    p->done_planned += planned;
+    p->done_bytes += bytes;
+    p->done_io_us += io_us;
+    pthread_mutex_unlock(&p->lock);
+}
+
+void plan_publish(BudgetPlan* p, ScanStats* st) {
+    pthread_mutex_lock(&p->lock);
+    st->budget_frac = p->frac;
+    st->budget_keep = p->keep;
+    st->budget_solves = p->solves;
+    st->budget_left_ms = ((int64_t)p->deadline_us - (int64_t)now_us()) / 1000;
+    pthread_mutex_unlock(&p->lock);
+}
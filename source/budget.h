@@ -0,0 +1,73 @@
+#pragma once
+#include "scan_internal.h"
+
+/*
+ * With time_budget_min set, a metadata pre-pass (listing only) sorts the size of every file
+ * the scan would read into log2 buckets. During the scan a reader asks the planner what to do
+ * with each file just before reading it: read it fully, sample a share 'frac' of it (at least
+ * head and tail), or skip it (files whose path hash falls outside the share 'keep'). Every
+ * PLAN_RECALC_US the planner solves frac/keep again so that the files not reached yet, plus
+ * those being read, fit in the time left, using the throughput and per-file overhead measured
+ * so far. Until PLAN_WARMUP_US of reads were timed there is no rate to solve with: a file is
+ * read fully when it, the reads already decided and head and tail of the rest fit the time
+ * left at PLAN_FLOOR_MIB_S, a rate any card sustains. A larger one is held while other readers
+ * have reads in flight (their times may end the warm-up) and gets head and tail only when none
+ * are left. Reading big files is cheaper per byte, so a shrinking budget turns them into
+ * samples first.
+ */
+#define PLAN_BUCKETS         48
+#define PLAN_RECALC_US       250000ull
+#define PLAN_WARMUP_US       200000ull
+#define PLAN_FLOOR_MIB_S     2.0
+#define PLAN_DEFAULT_FILE_US 3000.0    /* until PLAN_MEASURE_FILES were read */
+#define PLAN_MEASURE_FILES   16
+
+typedef enum {
+    PLAN_FULL = 0,
+    PLAN_SAMPLE,
+    PLAN_SKIP,
+    PLAN_HOLD      /* warm-up: ask again once the reads in flight are timed */
+} PlanChoice;
+
+struct BudgetPlan {
+    pthread_mutex_t lock;
+    uint64_t deadline_us;
+    uint64_t scan_start_us;   /* end of the pre-pass */
+    int      readers;
+    double   region;
+    bool     consistency;
+
+    /* Pre-pass */
+    uint64_t pre_files;
+    uint64_t pre_bytes;
+    uint64_t pre_enum_us;
+    uint64_t hist_n[PLAN_BUCKETS];
+    uint64_t hist_bytes[PLAN_BUCKETS];
+
+    /* Walker side: files decided and the bytes they will read */
+    uint64_t seen_files;
+    uint64_t decided_files;
+    uint64_t decided_bytes;
+
+    /* Reader side */
+    uint64_t done_files;
+    uint64_t done_planned;
+    uint64_t done_bytes;
+    uint64_t done_io_us;
+
+    double   frac;
+    double   keep;
+    uint64_t last_us;
+    uint32_t solves;
+};
+
+void plan_init(BudgetPlan* p, const ScanConfig* cfg, int readers, uint64_t start_us);
+void plan_free(BudgetPlan* p);
+/* Pre-pass: one file the scan would read. */
+void plan_add(BudgetPlan* p, uint64_t size);
+/* Walker: policy for one file; *pct is the sample coverage and *bytes what it will read. */
+PlanChoice plan_decide(BudgetPlan* p, const ScanConfig* cfg, const char* path, uint64_t size, double* pct, uint64_t* bytes);
+/* Reader: a decided file is done. */
+void plan_note(BudgetPlan* p, uint64_t planned, uint64_t bytes, uint64_t io_us);
+/* UI thread: current policy into the stats shown on screen. */
+void plan_publish(BudgetPlan* p, ScanStats* st);
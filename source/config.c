@@ -1,6 +1,7 @@
 #include "config.h"
 #include "util.h"
 #include "log.h"
+#include "trace.h"
 
 static const char CFG_DIR_PATH[]  = "sdmc:/switch";
 static const char CFG_FILE_PATH[] = "sdmc:/switch/sdcheck.cfg";
@@ -24,10 +25,35 @@ const char* chunk_name(ChunkMode m) {
         case CHUNK_256K: return "256 KiB";
         case CHUNK_512K: return "512 KiB";
         case CHUNK_1M:   return "1 MiB";
+        case CHUNK_2M:   return "2 MiB";
+        case CHUNK_4M:   return "4 MiB";
+        case CHUNK_8M:   return "8 MiB";
         default:         return "Auto";
     }
 }
 
+const char* io_backend_mode_name(IoBackendMode m) {
+    switch (m) {
+        case IO_BACKEND_STDIO:  return "stdio";
+        case IO_BACKEND_NATIVE: return "native";
+        case IO_BACKEND_POSIX:  return "posix";
+        default:                return "Auto";
+    }
+}
+
+const char* sample_mode_name(SampleMode m) {
+    return (m == SAMPLE_RANDOM) ? "Random" : "Even";
+}
+
+const char* hash_algo_name(HashAlgo a) {
+    switch (a) {
+        case HASH_XXH3_64:  return "xxh3-64";
+        case HASH_XXH3_128: return "xxh3-128";
+        case HASH_SHA256:   return "sha256";
+        default:            return "crc32";
+    }
+}
+
 const char* target_name(ScanTarget t) {
     switch (t) {
         case SCAN_TARGET_NINTENDO:   return "Nintendo";
@@ -93,8 +119,32 @@ const ScanConfig g_cfg_defaults = {
     .full_read = false,
     .large_file_limit = 256ull * 1024ull * 1024ull,
     .read_retries = 1,
+    .retry_defer = true,
+    .retry_backoff_ms = 30,
+    .bisect_min_kib = 4,
+    .read_deadline_s = 10,
+    .stall_ms = 500,
+    .timeline_sec = 1,
+    .trace_mib = 0,
     .consistency_check = false,
     .chunk_mode = CHUNK_AUTO,
+    .pipeline_slots = 4,
+    .io_backend = IO_BACKEND_AUTO,
+    .lookahead_depth = 8,
+    .reader_threads = 1,
+    .range_threads = 2,
+    .range_min_mib = 1024,
+    .sample_mode = SAMPLE_EVEN,
+    .sample_region_kib = 64,
+    .sample_coverage_pct = 0.5,
+    .sample_budget_mib = 0,
+    .sample_seed = 0,
+    .time_budget_min = 0,
+    .checkpoint_sec = 5,
+    .manifest = true,
+    .incremental = false,
+    .stale_days = 30,
+    .hash_algo = HASH_CRC32,
     .skip_known_folders = false,
     .skip_media_exts = false,
     .deep_target = SCAN_TARGET_ALL,
@@ -137,6 +187,7 @@ void apply_preset(ScanConfig* cfg, PresetMode mode) {
         cfg->chunk_mode = CHUNK_AUTO;
         cfg->skip_known_folders = false;
         cfg->skip_media_exts = false;
+        cfg->incremental = false;
     }
 }
 
@@ -164,8 +215,32 @@ bool cfg_save_to_sd(const ScanConfig* cfg, const UiConfig* ui) {
     fprintf(f, "full_read=%d\n", cfg->full_read ? 1 : 0);
     fprintf(f, "large_file_limit_mib=%llu\n", (unsigned long long)(cfg->large_file_limit / (1024ull*1024ull)));
     fprintf(f, "read_retries=%d\n", cfg->read_retries);
+    fprintf(f, "retry_defer=%d\n", cfg->retry_defer ? 1 : 0);
+    fprintf(f, "retry_backoff_ms=%d\n", cfg->retry_backoff_ms);
+    fprintf(f, "bisect_min_kib=%d\n", cfg->bisect_min_kib);
+    fprintf(f, "read_deadline_s=%d\n", cfg->read_deadline_s);
+    fprintf(f, "stall_ms=%d\n", cfg->stall_ms);
+    fprintf(f, "timeline_sec=%d\n", cfg->timeline_sec);
+    fprintf(f, "trace_mib=%d\n", cfg->trace_mib);
     fprintf(f, "consistency_check=%d\n", cfg->consistency_check ? 1 : 0);
     fprintf(f, "chunk_mode=%d\n", (int)cfg->chunk_mode);
+    fprintf(f, "pipeline_slots=%d\n", cfg->pipeline_slots);
+    fprintf(f, "io_backend=%d\n", (int)cfg->io_backend);
+    fprintf(f, "lookahead_depth=%d\n", cfg->lookahead_depth);
+    fprintf(f, "reader_threads=%d\n", cfg->reader_threads);
+    fprintf(f, "range_threads=%d\n", cfg->range_threads);
+    fprintf(f, "range_min_mib=%d\n", cfg->range_min_mib);
+    fprintf(f, "sample_mode=%d\n", (int)cfg->sample_mode);
+    fprintf(f, "sample_region_kib=%d\n", cfg->sample_region_kib);
+    fprintf(f, "sample_coverage=%.2f\n", cfg->sample_coverage_pct);
+    fprintf(f, "sample_budget_mib=%d\n", cfg->sample_budget_mib);
+    fprintf(f, "sample_seed=%llu\n", (unsigned long long)cfg->sample_seed);
+    fprintf(f, "time_budget_min=%d\n", cfg->time_budget_min);
+    fprintf(f, "checkpoint_sec=%d\n", cfg->checkpoint_sec);
+    fprintf(f, "manifest=%d\n", cfg->manifest ? 1 : 0);
+    fprintf(f, "incremental=%d\n", cfg->incremental ? 1 : 0);
+    fprintf(f, "stale_days=%d\n", cfg->stale_days);
+    fprintf(f, "hash_algo=%d\n", (int)cfg->hash_algo);
     fprintf(f, "skip_known_folders=%d\n", cfg->skip_known_folders ? 1 : 0);
     fprintf(f, "skip_media_exts=%d\n", cfg->skip_media_exts ? 1 : 0);
     fprintf(f, "deep_target=%d\n", (int)cfg->deep_target);
@@ -205,6 +280,184 @@ bool cfg_save_to_sd(const ScanConfig* cfg, const UiConfig* ui) {
     return true;
 }
 
+bool cfg_apply_kv(ScanConfig* cfg, UiConfig* ui, const char* key, const char* val, int* preset_out) {
+    if (!cfg || !ui || !key || !val) return false;
+    if (!key[0]) return false;
+
+    if (strcmp(key, "preset") == 0) {
+        int p = atoi(val);
+        if (p < (int)PRESET_CUSTOM) p = (int)PRESET_CUSTOM;
+        if (preset_out) *preset_out = p;
+    }
+    else if (strcmp(key, "full_read") == 0) cfg->full_read = parse_bool(val, cfg->full_read) != 0;
+    else if (strcmp(key, "large_file_limit_mib") == 0) {
+        unsigned long long mib = strtoull(val, NULL, 10);
+        if (mib < 16) mib = 16;
+        if (mib > 8192) mib = 8192;
+        cfg->large_file_limit = (uint64_t)mib * 1024ull * 1024ull;
+    }
+    else if (strcmp(key, "read_retries") == 0) {
+        int r = atoi(val);
+        if (r < 0) r = 0;
+        if (r > 3) r = 3;
+        cfg->read_retries = r;
+    }
+    else if (strcmp(key, "retry_defer") == 0) cfg->retry_defer = parse_bool(val, cfg->retry_defer) != 0;
+    else if (strcmp(key, "retry_backoff_ms") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 5000) n = 5000;
+        cfg->retry_backoff_ms = n;
+    }
+    else if (strcmp(key, "bisect_min_kib") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 0 && n < 4) n = 4;
+        if (n > 4096) n = 4096;
+        cfg->bisect_min_kib = n & ~3;
+    }
+    else if (strcmp(key, "read_deadline_s") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 600) n = 600;
+        cfg->read_deadline_s = n;
+    }
+    else if (strcmp(key, "stall_ms") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 0 && n < 50) n = 50;
+        if (n > 60000) n = 60000;
+        cfg->stall_ms = n;
+    }
+    else if (strcmp(key, "timeline_sec") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 60) n = 60;
+        cfg->timeline_sec = n;
+    }
+    else if (strcmp(key, "trace_mib") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > TRACE_MIB_MAX) n = TRACE_MIB_MAX;
+        cfg->trace_mib = n;
+    }
+    else if (strcmp(key, "consistency_check") == 0) cfg->consistency_check = parse_bool(val, cfg->consistency_check) != 0;
+    else if (strcmp(key, "chunk_mode") == 0) {
+        int cm = atoi(val);
+        if (cm < 0) cm = 0;
+        if (cm > (int)CHUNK_8M) cm = (int)CHUNK_8M;
+        cfg->chunk_mode = (ChunkMode)cm;
+    }
+    else if (strcmp(key, "pipeline_slots") == 0) {
+        int n = atoi(val);
+        if (n < 2) n = 0;
+        if (n > PIPELINE_SLOTS_MAX) n = PIPELINE_SLOTS_MAX;
+        cfg->pipeline_slots = n;
+    }
+    else if (strcmp(key, "io_backend") == 0) {
+        int b = atoi(val);
+        if (b < 0) b = 0;
+        if (b > (int)IO_BACKEND_POSIX) b = (int)IO_BACKEND_AUTO;
+        cfg->io_backend = (IoBackendMode)b;
+    }
+    else if (strcmp(key, "lookahead_depth") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > LOOKAHEAD_MAX) n = LOOKAHEAD_MAX;
+        cfg->lookahead_depth = n;
+    }
+    else if (strcmp(key, "reader_threads") == 0) {
+        int n = atoi(val);
+        if (n < 1) n = 1;
+        if (n > READERS_MAX) n = READERS_MAX;
+        cfg->reader_threads = n;
+    }
+    else if (strcmp(key, "range_threads") == 0) {
+        int n = atoi(val);
+        if (n < 1) n = 1;
+        if (n > RANGE_THREADS_MAX) n = RANGE_THREADS_MAX;
+        cfg->range_threads = n;
+    }
+    else if (strcmp(key, "range_min_mib") == 0) {
+        int n = atoi(val);
+        if (n < 64) n = 64;
+        cfg->range_min_mib = n;
+    }
+    else if (strcmp(key, "sample_mode") == 0) {
+        int m = atoi(val);
+        cfg->sample_mode = (m == (int)SAMPLE_RANDOM) ? SAMPLE_RANDOM : SAMPLE_EVEN;
+    }
+    else if (strcmp(key, "sample_region_kib") == 0) {
+        int n = atoi(val);
+        if (n < 4) n = 4;
+        if (n > SAMPLE_REGION_MAX_KIB) n = SAMPLE_REGION_MAX_KIB;
+        cfg->sample_region_kib = n & ~3;
+    }
+    else if (strcmp(key, "sample_coverage") == 0) {
+        double pct = strtod(val, NULL);
+        if (!(pct >= 0.0)) pct = 0.0;
+        if (pct > 100.0) pct = 100.0;
+        cfg->sample_coverage_pct = pct;
+    }
+    else if (strcmp(key, "sample_budget_mib") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        cfg->sample_budget_mib = n;
+    }
+    else if (strcmp(key, "sample_seed") == 0) cfg->sample_seed = strtoull(val, NULL, 10);
+    else if (strcmp(key, "time_budget_min") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 1440) n = 1440;
+        cfg->time_budget_min = n;
+    }
+    else if (strcmp(key, "checkpoint_sec") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 600) n = 600;
+        cfg->checkpoint_sec = n;
+    }
+    else if (strcmp(key, "manifest") == 0) cfg->manifest = parse_bool(val, cfg->manifest) != 0;
+    else if (strcmp(key, "incremental") == 0) cfg->incremental = parse_bool(val, cfg->incremental) != 0;
+    else if (strcmp(key, "stale_days") == 0) {
+        int n = atoi(val);
+        if (n < 0) n = 0;
+        if (n > 3650) n = 3650;
+        cfg->stale_days = n;
+    }
+    else if (strcmp(key, "hash_algo") == 0) {
+        int a = atoi(val);
+        if (a < 0 || a >= (int)HASH_ALGO_COUNT) a = (int)HASH_CRC32;
+        cfg->hash_algo = (HashAlgo)a;
+    }
+    else if (strcmp(key, "skip_known_folders") == 0) cfg->skip_known_folders = parse_bool(val, cfg->skip_known_folders) != 0;
+    else if (strcmp(key, "skip_media_exts") == 0) cfg->skip_media_exts = parse_bool(val, cfg->skip_media_exts) != 0;
+    else if (strcmp(key, "deep_target") == 0) {
+        int t = atoi(val);
+        if (t < 0) t = 0;
+        if (t > (int)SCAN_TARGET_CUSTOM_CFG) t = (int)SCAN_TARGET_CUSTOM_CFG;
+        cfg->deep_target = (ScanTarget)t;
+    }
+    else if (strcmp(key, "custom_root") == 0) {
+        snprintf(cfg->custom_root, sizeof(cfg->custom_root), "%s", val);
+        if (!sanitize_custom_root(cfg->custom_root, sizeof(cfg->custom_root))) {
+            set_default_custom_root(cfg->custom_root, sizeof(cfg->custom_root));
+        }
+    }
+    else if (strcmp(key, "write_test") == 0) cfg->write_test = parse_bool(val, cfg->write_test) != 0;
+    else if (strcmp(key, "list_root") == 0) cfg->list_root = parse_bool(val, cfg->list_root) != 0;
+    else if (strcmp(key, "ui_top_margin") == 0) {
+        int tm = atoi(val);
+        if (tm < 0) tm = 0;
+        if (tm > 2) tm = 2;
+        ui->top_margin = tm;
+    }
+    else if (strcmp(key, "ui_compact_mode") == 0) ui->compact_mode = parse_bool(val, ui->compact_mode) != 0;
+    else return false;
+
+    return true;
+}
+
 bool cfg_load_from_sd(ScanConfig* cfg, UiConfig* ui) {
     if (!cfg || !ui) return false;
     if (access(CFG_FILE_PATH, F_OK) != 0) return false;
@@ -212,8 +465,7 @@ bool cfg_load_from_sd(ScanConfig* cfg, UiConfig* ui) {
     FILE* f = fopen(CFG_FILE_PATH, "rb");
     if (!f) return false;
 
-    bool have_preset = false;
-    int preset = (int)cfg->preset;
+    int preset = -1; /* -1: no preset key in file */
 
     char line[256];
     while (fgets(line, sizeof(line), f)) {
@@ -229,58 +481,12 @@ bool cfg_load_from_sd(ScanConfig* cfg, UiConfig* ui) {
         trim_ws(key);
         trim_ws(val);
 
-        if (!key[0]) continue;
-
-        if (strcmp(key, "preset") == 0) { preset = atoi(val); have_preset = true; }
-        else if (strcmp(key, "full_read") == 0) cfg->full_read = parse_bool(val, cfg->full_read) != 0;
-        else if (strcmp(key, "large_file_limit_mib") == 0) {
-            unsigned long long mib = strtoull(val, NULL, 10);
-            if (mib < 16) mib = 16;
-            if (mib > 8192) mib = 8192;
-            cfg->large_file_limit = (uint64_t)mib * 1024ull * 1024ull;
-        }
-        else if (strcmp(key, "read_retries") == 0) {
-            int r = atoi(val);
-            if (r < 0) r = 0;
-            if (r > 3) r = 3;
-            cfg->read_retries = r;
-        }
-        else if (strcmp(key, "consistency_check") == 0) cfg->consistency_check = parse_bool(val, cfg->consistency_check) != 0;
-        else if (strcmp(key, "chunk_mode") == 0) {
-            int cm = atoi(val);
-            if (cm < 0) cm = 0;
-            if (cm > (int)CHUNK_1M) cm = (int)CHUNK_1M;
-            cfg->chunk_mode = (ChunkMode)cm;
-        }
-        else if (strcmp(key, "skip_known_folders") == 0) cfg->skip_known_folders = parse_bool(val, cfg->skip_known_folders) != 0;
-        else if (strcmp(key, "skip_media_exts") == 0) cfg->skip_media_exts = parse_bool(val, cfg->skip_media_exts) != 0;
-        else if (strcmp(key, "deep_target") == 0) {
-            int t = atoi(val);
-            if (t < 0) t = 0;
-            if (t > (int)SCAN_TARGET_CUSTOM_CFG) t = (int)SCAN_TARGET_CUSTOM_CFG;
-            cfg->deep_target = (ScanTarget)t;
-        }
-        else if (strcmp(key, "custom_root") == 0) {
-            snprintf(cfg->custom_root, sizeof(cfg->custom_root), "%s", val);
-            if (!sanitize_custom_root(cfg->custom_root, sizeof(cfg->custom_root))) {
-                set_default_custom_root(cfg->custom_root, sizeof(cfg->custom_root));
-            }
-        }
-        else if (strcmp(key, "write_test") == 0) cfg->write_test = parse_bool(val, cfg->write_test) != 0;
-        else if (strcmp(key, "list_root") == 0) cfg->list_root = parse_bool(val, cfg->list_root) != 0;
-        else if (strcmp(key, "ui_top_margin") == 0) {
-            int tm = atoi(val);
-            if (tm < 0) tm = 0;
-            if (tm > 2) tm = 2;
-            ui->top_margin = tm;
-        }
-        else if (strcmp(key, "ui_compact_mode") == 0) ui->compact_mode = parse_bool(val, ui->compact_mode) != 0;
+        (void)cfg_apply_kv(cfg, ui, key, val, &preset);
     }
 
     fclose(f);
 
-    if (have_preset) {
-        if (preset < (int)PRESET_CUSTOM) preset = (int)PRESET_CUSTOM;
+    if (preset >= 0) {
         if (preset > (int)PRESET_FORENSICS) preset = (int)PRESET_FORENSICS;
 
         if (preset != (int)PRESET_CUSTOM) apply_preset(cfg, (PresetMode)preset);
@@ -12,9 +12,40 @@ typedef enum {
     CHUNK_128K,
     CHUNK_256K,
     CHUNK_512K,
-    CHUNK_1M
+    CHUNK_1M,
+    CHUNK_2M,
+    CHUNK_4M,
+    CHUNK_8M
 } ChunkMode;
 
+typedef enum {
+    SAMPLE_EVEN = 0,          /* regions evenly spaced from head to tail */
+    SAMPLE_RANDOM             /* one region at a seeded random offset per stratum */
+} SampleMode;
+
+typedef enum {
+    HASH_CRC32 = 0,           /* CRC-32 only (always computed) */
+    HASH_XXH3_64,
+    HASH_XXH3_128,
+    HASH_SHA256,
+    HASH_ALGO_COUNT
+} HashAlgo;
+
+#define SAMPLE_REGION_MAX_KIB 4096
+
+#define PIPELINE_SLOTS_MAX 8
+#define LOOKAHEAD_MAX      32
+#define READERS_MAX        4
+#define RANGE_THREADS_MAX  4
+#define TUNE_SIZES         8    /* chunk auto-tuner ladder: 64 KiB .. 8 MiB */
+
+typedef enum {
+    IO_BACKEND_AUTO = 0,      /* native on Switch, posix on host */
+    IO_BACKEND_STDIO,         /* fopen/fread (newlib FILE buffering) */
+    IO_BACKEND_NATIVE,        /* libnx fsFileRead (Switch only) */
+    IO_BACKEND_POSIX          /* open/pread (host only) */
+} IoBackendMode;
+
 typedef enum {
     SCAN_TARGET_ALL = 0,      /* sdmc:/ */
     SCAN_TARGET_NINTENDO,     /* sdmc:/Nintendo */
@@ -25,6 +56,9 @@ typedef enum {
 
 const char* preset_name(PresetMode p);
 const char* chunk_name(ChunkMode m);
+const char* io_backend_mode_name(IoBackendMode m);
+const char* sample_mode_name(SampleMode m);
+const char* hash_algo_name(HashAlgo a);
 const char* target_name(ScanTarget t);
 
 typedef struct {
@@ -34,9 +68,38 @@ typedef struct {
     uint64_t large_file_limit;  /* bytes */
 
     int      read_retries;      /* 0..3 */
+    bool     retry_defer;       /* queue failed regions and retry them after the rest of the scan */
+    int      retry_backoff_ms;  /* wait before a retry, doubled per attempt */
+    int      bisect_min_kib;    /* failed reads are bisected down to this to find the unreadable extents; 0 = off */
+    int      read_deadline_s;   /* a read still blocked after this is given up and its file skipped; 0 = off */
+    int      stall_ms;          /* I/O in flight longer than this is flagged live and logged; 0 = off */
+    int      timeline_sec;      /* throughput timeline interval (CSV next to the log); 0 = off */
+    int      trace_mib;         /* trace mode: event buffer for a Chrome trace JSON; 0 = off */
     bool     consistency_check; /* read same region twice and compare CRC */
 
     ChunkMode chunk_mode;
+    int      pipeline_slots;    /* full-read chunk ring (reader/hasher); 0 = serial read+hash */
+    IoBackendMode io_backend;
+    int      lookahead_depth;   /* files listed and opened ahead of the reader; 0 = serial walk */
+    int      reader_threads;    /* 1..READERS_MAX files read concurrently */
+    int      range_threads;     /* full reads of large files: 1..RANGE_THREADS_MAX parallel ranges (1 = off) */
+    int      range_min_mib;     /* files at least this large are read as ranges */
+
+    /* Sample mode (files above large_file_limit without full read) */
+    SampleMode sample_mode;
+    int      sample_region_kib;   /* 4..SAMPLE_REGION_MAX_KIB, multiple of 4 */
+    double   sample_coverage_pct; /* share of each file to read; 0 = head and tail only */
+    int      sample_budget_mib;   /* per-file cap on sampled bytes; 0 = none */
+    uint64_t sample_seed;         /* random mode; 0 = new seed each run */
+
+    int      time_budget_min;     /* Deep Check time budget; 0 = off (read per full_read/threshold) */
+    int      checkpoint_sec;      /* Deep Check resume journal interval; 0 = off */
+
+    /* File manifest (path, size, mtime, verified time, CRC) written after each Deep Check */
+    bool     manifest;
+    bool     incremental;         /* read only new, changed or stale files (needs the manifest) */
+    int      stale_days;          /* incremental: re-read files verified longer ago; 0 = never stale */
+    HashAlgo hash_algo;           /* content hash of full reads, next to the CRC-32 */
 
     bool     skip_known_folders;
     bool     skip_media_exts;
@@ -67,4 +130,7 @@ void cfg_reset_defaults(void);
 /* Persistent config (sdmc:/switch/sdcheck.cfg) */
 bool cfg_save_to_sd(const ScanConfig* cfg, const UiConfig* ui);
 bool cfg_load_from_sd(ScanConfig* cfg, UiConfig* ui);
+/* Applies one key=value pair (same keys as the cfg file). Returns false for unknown keys.
+   'preset' is not applied here; it is returned via preset_out for the caller to apply last. */
+bool cfg_apply_kv(ScanConfig* cfg, UiConfig* ui, const char* key, const char* val, int* preset_out);
 const char* cfg_file_path(void);
@@ -0,0 +1,548 @@
+#include "crc32.h"
+#include "log.h"
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/*
+ * All kernels work on the raw register (no pre/post inversion);
+ * crc32_update() applies the standard conditioning around them.
+ */
+typedef uint32_t (*Crc32Kernel)(uint32_t raw, const uint8_t* p, size_t len);
+
+#define CRC32_POLY 0xEDB88320u
+
+static uint32_t crc_tab[16][256];   /* slicing tables; [0] is the classic byte table */
+static uint32_t crc_x2n[32];        /* x^(2^n) mod P, for shifts/combine */
+static bool     crc_ready = false;
+
+/* --------------------------------------------------------------------------
+   GF(2) helpers (zlib-style): multiply mod P, x^(n*2^k) mod P
+----------------------------------------------------------------------------*/
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) break;
+        }
+        m >>= 1;
+        b = (b & 1) ? ((b >> 1) ^ CRC32_POLY) : (b >> 1);
+    }
+    return p;
+}
+
+static uint32_t x2nmodp(uint64_t n, unsigned k) {
+    uint32_t p = 1u << 31; /* x^0 */
+    while (n) {
+        if (n & 1) p = multmodp(crc_x2n[k & 31], p);
+        n >>= 1;
+        k++;
+    }
+    return p;
+}
+
+static inline uint32_t load_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* --------------------------------------------------------------------------
+   Portable kernels: byte table (reference), slicing-by-8, slicing-by-16
+----------------------------------------------------------------------------*/
+static uint32_t crc_raw_table(uint32_t c, const uint8_t* p, size_t len) {
+    while (len--) c = crc_tab[0][(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return c;
+}
+
+static uint32_t crc_raw_slice8(uint32_t c, const uint8_t* p, size_t len) {
+    while (len && ((uintptr_t)p & 3)) { c = crc_tab[0][(c ^ *p++) & 0xFF] ^ (c >> 8); len--; }
+    while (len >= 8) {
+        uint32_t a = load_le32(p) ^ c;
+        uint32_t b = load_le32(p + 4);
+        c = crc_tab[7][a & 0xFF] ^ crc_tab[6][(a >> 8) & 0xFF] ^ crc_tab[5][(a >> 16) & 0xFF] ^ crc_tab[4][a >> 24] ^
+            crc_tab[3][b & 0xFF] ^ crc_tab[2][(b >> 8) & 0xFF] ^ crc_tab[1][(b >> 16) & 0xFF] ^ crc_tab[0][b >> 24];
+        p += 8;
+        len -= 8;
+    }
+    return crc_raw_table(c, p, len);
+}
+
+static uint32_t crc_raw_slice16(uint32_t c, const uint8_t* p, size_t len) {
+    while (len && ((uintptr_t)p & 3)) { c = crc_tab[0][(c ^ *p++) & 0xFF] ^ (c >> 8); len--; }
+    while (len >= 16) {
+        uint32_t a = load_le32(p) ^ c;
+        uint32_t b = load_le32(p + 4);
+        uint32_t d = load_le32(p + 8);
+        uint32_t e = load_le32(p + 12);
+        c = crc_tab[15][a & 0xFF] ^ crc_tab[14][(a >> 8) & 0xFF] ^ crc_tab[13][(a >> 16) & 0xFF] ^ crc_tab[12][a >> 24] ^
+            crc_tab[11][b & 0xFF] ^ crc_tab[10][(b >> 8) & 0xFF] ^ crc_tab[9][(b >> 16) & 0xFF]  ^ crc_tab[8][b >> 24] ^
+            crc_tab[7][d & 0xFF]  ^ crc_tab[6][(d >> 8) & 0xFF]  ^ crc_tab[5][(d >> 16) & 0xFF]  ^ crc_tab[4][d >> 24] ^
+            crc_tab[3][e & 0xFF]  ^ crc_tab[2][(e >> 8) & 0xFF]  ^ crc_tab[1][(e >> 16) & 0xFF]  ^ crc_tab[0][e >> 24];
+        p += 16;
+        len -= 16;
+    }
+    return crc_raw_slice8(c, p, len);
+}
+
+/* --------------------------------------------------------------------------
+   ARMv8 kernels: CRC32 instructions over 3 interleaved streams; PMULL folding
+----------------------------------------------------------------------------*/
+#if defined(__aarch64__)
+
+#define CRC3_BLK 1024u  /* bytes per stream per round */
+
+/* Table form of "advance the register over N zero bytes" (linear in the register). */
+typedef uint32_t CrcShiftTable[4][256];
+
+static void crc_shift_table_build(CrcShiftTable t, uint64_t nbytes) {
+    uint32_t op = x2nmodp(nbytes, 3);
+    for (int j = 0; j < 4; j++) {
+        for (uint32_t v = 0; v < 256; v++) t[j][v] = multmodp(op, v << (8 * j));
+    }
+}
+
+static inline uint32_t crc_shift(const CrcShiftTable t, uint32_t c) {
+    return t[0][c & 0xFF] ^ t[1][(c >> 8) & 0xFF] ^ t[2][(c >> 16) & 0xFF] ^ t[3][c >> 24];
+}
+
+static inline uint64_t load_u64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static CrcShiftTable crc_shift_1blk;   /* advance over CRC3_BLK bytes */
+static CrcShiftTable crc_shift_2blk;   /* advance over 2*CRC3_BLK bytes */
+
+/* crc32x has 3-cycle latency but 1/cycle throughput: three independent streams keep it busy. */
+__attribute__((target("+crc")))
+static uint32_t crc_raw_armv8_3way(uint32_t c, const uint8_t* p, size_t len) {
+    while (len && ((uintptr_t)p & 7)) { c = __crc32b(c, *p++); len--; }
+
+    while (len >= 3 * CRC3_BLK) {
+        uint32_t c1 = 0, c2 = 0;
+        for (size_t i = 0; i < CRC3_BLK; i += 8) {
+            c  = __crc32d(c,  load_u64(p + i));
+            c1 = __crc32d(c1, load_u64(p + CRC3_BLK + i));
+            c2 = __crc32d(c2, load_u64(p + 2 * CRC3_BLK + i));
+        }
+        c = crc_shift(crc_shift_2blk, c) ^ crc_shift(crc_shift_1blk, c1) ^ c2;
+        p += 3 * CRC3_BLK;
+        len -= 3 * CRC3_BLK;
+    }
+
+    while (len >= 8) {
+        c = __crc32d(c, load_u64(p));
+        p += 8;
+        len -= 8;
+    }
+    while (len--) c = __crc32b(c, *p++);
+    return c;
+}
+
+__attribute__((target("+crypto")))
+static inline uint64x2_t clmul_lo(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(a, 0), (poly64_t)vgetq_lane_u64(b, 0)));
+}
+
+__attribute__((target("+crypto")))
+static inline uint64x2_t clmul_hi(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(a, 1), (poly64_t)vgetq_lane_u64(b, 1)));
+}
+
+__attribute__((target("+crypto")))
+static inline uint64x2_t clmul_lo_hi(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(a, 0), (poly64_t)vgetq_lane_u64(b, 1)));
+}
+
+/*
+ * Carry-less multiply folding (Intel "Fast CRC Computation Using PCLMULQDQ", bit-reflected
+ * constants). len >= 64 and a multiple of 16.
+ */
+__attribute__((target("+crypto")))
+static uint32_t crc_fold_pmull(uint32_t c, const uint8_t* p, size_t len) {
+    static const uint64_t k1k2[2] = { 0x0154442bd4ull, 0x01c6e41596ull };
+    static const uint64_t k3k4[2] = { 0x01751997d0ull, 0x00ccaa009eull };
+    static const uint64_t k5k0[2] = { 0x0163cd6124ull, 0x0000000000ull };
+    static const uint64_t poly[2] = { 0x01db710641ull, 0x01f7011641ull };
+    static const uint32_t mask32[4] = { ~0u, 0u, ~0u, 0u };
+
+    const uint8x16_t zero = vdupq_n_u8(0);
+
+    uint64x2_t x1 = vreinterpretq_u64_u8(vld1q_u8(p + 0x00));
+    uint64x2_t x2 = vreinterpretq_u64_u8(vld1q_u8(p + 0x10));
+    uint64x2_t x3 = vreinterpretq_u64_u8(vld1q_u8(p + 0x20));
+    uint64x2_t x4 = vreinterpretq_u64_u8(vld1q_u8(p + 0x30));
+    x1 = veorq_u64(x1, vreinterpretq_u64_u32(vsetq_lane_u32(c, vdupq_n_u32(0), 0)));
+
+    uint64x2_t x0 = vld1q_u64(k1k2);
+    p += 64;
+    len -= 64;
+
+    while (len >= 64) {
+        uint64x2_t x5 = clmul_lo(x1, x0);
+        uint64x2_t x6 = clmul_lo(x2, x0);
+        uint64x2_t x7 = clmul_lo(x3, x0);
+        uint64x2_t x8 = clmul_lo(x4, x0);
+
+        x1 = clmul_hi(x1, x0);
+        x2 = clmul_hi(x2, x0);
+        x3 = clmul_hi(x3, x0);
+        x4 = clmul_hi(x4, x0);
+
+        x1 = veorq_u64(veorq_u64(x1, x5), vreinterpretq_u64_u8(vld1q_u8(p + 0x00)));
+        x2 = veorq_u64(veorq_u64(x2, x6), vreinterpretq_u64_u8(vld1q_u8(p + 0x10)));
+        x3 = veorq_u64(veorq_u64(x3, x7), vreinterpretq_u64_u8(vld1q_u8(p + 0x20)));
+        x4 = veorq_u64(veorq_u64(x4, x8), vreinterpretq_u64_u8(vld1q_u8(p + 0x30)));
+
+        p += 64;
+        len -= 64;
+    }
+
+    /* Fold 4x128 into 128 bits. */
+    x0 = vld1q_u64(k3k4);
+    uint64x2_t x5 = clmul_lo(x1, x0);
+    x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), x2), x5);
+    x5 = clmul_lo(x1, x0);
+    x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), x3), x5);
+    x5 = clmul_lo(x1, x0);
+    x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), x4), x5);
+
+    while (len >= 16) {
+        x2 = vreinterpretq_u64_u8(vld1q_u8(p));
+        x5 = clmul_lo(x1, x0);
+        x1 = veorq_u64(veorq_u64(clmul_hi(x1, x0), x2), x5);
+        p += 16;
+        len -= 16;
+    }
+
+    /* 128 -> 64 bits. */
+    x2 = clmul_lo_hi(x1, x0);
+    x3 = vreinterpretq_u64_u32(vld1q_u32(mask32));
+    x1 = vreinterpretq_u64_u8(vextq_u8(vreinterpretq_u8_u64(x1), zero, 8));
+    x1 = veorq_u64(x1, x2);
+
+    x0 = vld1q_u64(k5k0);
+    x2 = vreinterpretq_u64_u8(vextq_u8(vreinterpretq_u8_u64(x1), zero, 4));
+    x1 = vandq_u64(x1, x3);
+    x1 = clmul_lo(x1, x0);
+    x1 = veorq_u64(x1, x2);
+
+    /* Barrett reduction to 32 bits. */
+    x0 = vld1q_u64(poly);
+    x2 = vandq_u64(x1, x3);
+    x2 = clmul_lo_hi(x2, x0);
+    x2 = vandq_u64(x2, x3);
+    x2 = clmul_lo(x2, x0);
+    x1 = veorq_u64(x1, x2);
+
+    return vgetq_lane_u32(vreinterpretq_u32_u64(x1), 1);
+}
+
+__attribute__((target("+crypto")))
+static uint32_t crc_raw_pmull(uint32_t c, const uint8_t* p, size_t len) {
+    if (len >= 64) {
+        size_t n = len & ~(size_t)15;
+        c = crc_fold_pmull(c, p, n);
+        p += n;
+        len -= n;
+    }
+    return crc_raw_slice8(c, p, len);
+}
+
+#ifndef HWCAP_PMULL
+#define HWCAP_PMULL (1 << 4)
+#endif
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+
+static void crc_cpu_features(bool* have_crc, bool* have_pmull) {
+#if defined(__SWITCH__)
+    /* Tegra X1 (Cortex-A57) implements both CRC32 and the Crypto extension. */
+    *have_crc = true;
+    *have_pmull = true;
+#elif defined(__linux__)
+    unsigned long hw = getauxval(AT_HWCAP);
+    *have_crc = (hw & HWCAP_CRC32) != 0;
+    *have_pmull = (hw & HWCAP_PMULL) != 0;
+#else
+#if defined(__ARM_FEATURE_CRC32)
+    *have_crc = true;
+#else
+    *have_crc = false;
+#endif
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)
+    *have_pmull = true;
+#else
+    *have_pmull = false;
+#endif
+#endif
+}
+
+#endif /* __aarch64__ */
+
+/* --------------------------------------------------------------------------
+   x86-64 kernel: PCLMULQDQ folding
+----------------------------------------------------------------------------*/
+#if defined(__x86_64__)
+
+/* Same algorithm and constants as the PMULL kernel. len >= 64 and a multiple of 16. */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc_fold_pclmul(uint32_t c, const uint8_t* p, size_t len) {
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596ll, 0x0154442bd4ll);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009ell, 0x01751997d0ll);
+    const __m128i k5k0 = _mm_set_epi64x(0x0000000000ll, 0x0163cd6124ll);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641ll, 0x01db710641ll);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+    __m128i x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)c));
+
+    __m128i x0 = k1k2;
+    p += 64;
+    len -= 64;
+
+    while (len >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+
+        p += 64;
+        len -= 64;
+    }
+
+    x0 = k3k4;
+    __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x4), x5);
+
+    while (len >= 16) {
+        x2 = _mm_loadu_si128((const __m128i*)p);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x11), x2), x5);
+        p += 16;
+        len -= 16;
+    }
+
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = k5k0;
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = poly;
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc_raw_pclmul(uint32_t c, const uint8_t* p, size_t len) {
+    if (len >= 64) {
+        size_t n = len & ~(size_t)15;
+        c = crc_fold_pclmul(c, p, n);
+        p += n;
+        len -= n;
+    }
+    return crc_raw_slice8(c, p, len);
+}
+
+#endif /* __x86_64__ */
+
+/* --------------------------------------------------------------------------
+   Dispatch
+----------------------------------------------------------------------------*/
+typedef struct {
+    Crc32KernelInfo info;
+    Crc32Kernel     fn;
+} Crc32KernelEntry;
+
+static Crc32KernelEntry g_kernels[] = {
+    { { "table",         true,  false, 0.0 }, crc_raw_table },
+    { { "slice8",        true,  false, 0.0 }, crc_raw_slice8 },
+    { { "slice16",       true,  false, 0.0 }, crc_raw_slice16 },
+#if defined(__aarch64__)
+    { { "armv8-crc32x3", false, false, 0.0 }, crc_raw_armv8_3way },
+    { { "pmull-fold",    false, false, 0.0 }, crc_raw_pmull },
+#endif
+#if defined(__x86_64__)
+    { { "pclmul-fold",   false, false, 0.0 }, crc_raw_pclmul },
+#endif
+};
+
+#define CRC_KERNEL_COUNT ((int)(sizeof(g_kernels) / sizeof(g_kernels[0])))
+
+static Crc32Kernel g_crc_fn = crc_raw_table;
+static const char* g_crc_name = "table";
+
+static void crc_tables_build(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? (CRC32_POLY ^ (c >> 1)) : (c >> 1);
+        crc_tab[0][i] = c;
+    }
+    for (int t = 1; t < 16; t++) {
+        for (int i = 0; i < 256; i++) crc_tab[t][i] = (crc_tab[t - 1][i] >> 8) ^ crc_tab[0][crc_tab[t - 1][i] & 0xFF];
+    }
+
+    uint32_t p = 1u << 30; /* x^1 */
+    crc_x2n[0] = p;
+    for (int n = 1; n < 32; n++) crc_x2n[n] = p = multmodp(p, p);
+
+#if defined(__aarch64__)
+    crc_shift_table_build(crc_shift_1blk, CRC3_BLK);
+    crc_shift_table_build(crc_shift_2blk, 2 * CRC3_BLK);
+#endif
+}
+
+static void crc_mark_available(void) {
+#if defined(__aarch64__)
+    bool have_crc = false, have_pmull = false;
+    crc_cpu_features(&have_crc, &have_pmull);
+    for (int i = 0; i < CRC_KERNEL_COUNT; i++) {
+        if (g_kernels[i].fn == crc_raw_armv8_3way) g_kernels[i].info.available = have_crc;
+        if (g_kernels[i].fn == crc_raw_pmull) g_kernels[i].info.available = have_pmull;
+    }
+#endif
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    bool have_clmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    for (int i = 0; i < CRC_KERNEL_COUNT; i++) {
+        if (g_kernels[i].fn == crc_raw_pclmul) g_kernels[i].info.available = have_clmul;
+    }
+#endif
+}
+
+/* Compares a kernel against the byte table over assorted lengths, alignments and seeds. */
+static bool crc_kernel_selftest(Crc32Kernel fn, const uint8_t* buf, size_t buf_len) {
+    static const size_t lens[] = { 0, 1, 3, 7, 8, 15, 16, 17, 63, 64, 65, 127, 128, 129, 255, 1000, 3071, 3072, 3073, 6151, 9216, 20000 };
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        for (size_t off = 0; off < 8; off++) {
+            if (lens[i] + off > buf_len) continue;
+            uint32_t seed = 0xFFFFFFFFu ^ (uint32_t)(i * 0x9E3779B9u + off);
+            if (fn(seed, buf + off, lens[i]) != crc_raw_table(seed, buf + off, lens[i])) return false;
+        }
+    }
+    return true;
+}
+
+static double crc_kernel_bench(Crc32Kernel fn, const uint8_t* buf, size_t len) {
+    volatile uint32_t sink = 0;
+    uint64_t bytes = 0;
+    uint64_t t0 = armGetSystemTick();
+    uint64_t ns = 0;
+    for (int rep = 0; rep < 256; rep++) {
+        sink ^= fn(sink, buf, len);
+        bytes += len;
+        ns = armTicksToNs(armGetSystemTick() - t0);
+        if (ns >= 2000000ull) break;  /* ~2 ms per kernel */
+    }
+    (void)sink;
+    if (ns == 0) ns = 1;
+    return ((double)bytes / 1048576.0) / ((double)ns / 1e9);
+}
+
+void crc32_init(void) {
+    if (crc_ready) return;
+    crc_tables_build();
+    crc_mark_available();
+
+    const size_t buf_len = 64u * 1024u;
+    uint8_t* buf = (uint8_t*)malloc(buf_len);
+    if (!buf) {
+        g_crc_fn = crc_raw_slice8;
+        g_crc_name = "slice8";
+        crc_ready = true;
+        return;
+    }
+    uint32_t x = 0x12345678u;
+    for (size_t i = 0; i < buf_len; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+
+    int best = 0;
+    for (int i = 0; i < CRC_KERNEL_COUNT; i++) {
+        Crc32KernelEntry* k = &g_kernels[i];
+        if (!k->info.available) continue;
+        k->info.verified = (i == 0) ? true : crc_kernel_selftest(k->fn, buf, buf_len);
+        if (!k->info.verified) {
+            log_pushf("WARN", "CRC32 kernel %s failed self-test; not used.", k->info.name);
+            continue;
+        }
+        k->info.mib_s = crc_kernel_bench(k->fn, buf, buf_len);
+        if (k->info.mib_s > g_kernels[best].info.mib_s) best = i;
+    }
+    free(buf);
+
+    g_crc_fn = g_kernels[best].fn;
+    g_crc_name = g_kernels[best].info.name;
+    crc_ready = true;
+
+    log_pushf("INFO", "CRC32 kernel: %s (%.0f MiB/s)", g_crc_name, g_kernels[best].info.mib_s);
+}
+
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+    if (!crc_ready) crc32_init();
+    return ~g_crc_fn(~crc, (const uint8_t*)data, len);
+}
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2) {
+    if (!crc_ready) crc32_init();
+    return multmodp(x2nmodp(len2, 3), crc1) ^ crc2;
+}
+
+uint32_t crc32_zeros(uint64_t len) {
+    if (!crc_ready) crc32_init();
+    /* The register starts at all ones; each zero byte multiplies it by x^8. */
+    return ~multmodp(x2nmodp(len, 3), 0xFFFFFFFFu);
+}
+
+const char* crc32_kernel_name(void) {
+    return g_crc_name;
+}
+
+int crc32_kernel_count(void) {
+    return CRC_KERNEL_COUNT;
+}
+
+const Crc32KernelInfo* crc32_kernel_info(int idx) {
+    if (idx < 0 || idx >= CRC_KERNEL_COUNT) return NULL;
+    return &g_kernels[idx].info;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "app.h"
+
+/*
+ * CRC-32 (IEEE 802.3, reflected 0xEDB88320; same values as zlib's crc32()).
+ * Several kernels sit behind one API; crc32_init() verifies the ones this CPU supports
+ * against the reference table kernel, times them and selects the fastest.
+ */
+
+/* Selects the kernel. Idempotent; called once at startup (and defensively by the engine). */
+void crc32_init(void);
+
+/* Standard CRC-32 update: crc = 0 for a new stream; returns the finalized value. */
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+
+/* CRC of A||B from crc(A), crc(B) and len(B). */
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+/* CRC of len zero bytes, without reading them. */
+uint32_t crc32_zeros(uint64_t len);
+
+typedef struct {
+    const char* name;
+    bool        available;   /* supported by this CPU/build */
+    bool        verified;    /* matched the reference on the self-test vectors */
+    double      mib_s;       /* startup micro-benchmark, 0 if not run */
+} Crc32KernelInfo;
+
+const char* crc32_kernel_name(void);
+int crc32_kernel_count(void);
+const Crc32KernelInfo* crc32_kernel_info(int idx);
@@ -0,0 +1,797 @@
+#include "hash.h"
+#include "log.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+static inline uint32_t rd32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t rd64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void put_be64(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+/* --------------------------------------------------------------------------
+   XXH3 (default secret, seed 0)
+----------------------------------------------------------------------------*/
+#define XXH_PRIME32_1 0x9E3779B1u
+#define XXH_PRIME32_2 0x85EBCA77u
+#define XXH_PRIME32_3 0xC2B2AE3Du
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+#define XXH_STRIPE        64
+#define XXH_SECRET_SIZE   192
+#define XXH_CONSUME_RATE  8
+#define XXH_STRIPES_BLOCK ((XXH_SECRET_SIZE - XXH_STRIPE) / XXH_CONSUME_RATE)
+#define XXH_BUF_STRIPES   ((int)(sizeof(((Xxh3State*)0)->buf) / XXH_STRIPE))
+#define XXH_MIDSIZE_MAX   240
+
+static const uint8_t xxh_secret[XXH_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const uint64_t xxh_init_acc[8] = {
+    XXH_PRIME32_3, XXH_PRIME64_1, XXH_PRIME64_2, XXH_PRIME64_3,
+    XXH_PRIME64_4, XXH_PRIME32_2, XXH_PRIME64_5, XXH_PRIME32_1
+};
+
+static inline uint64_t xxh_fold64(uint64_t a, uint64_t b) {
+    unsigned __int128 p = (unsigned __int128)a * b;
+    return (uint64_t)p ^ (uint64_t)(p >> 64);
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh3_avalanche(uint64_t h) {
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ull;
+    h ^= h >> 32;
+    return h;
+}
+
+static inline uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len) {
+    h ^= ((h << 49) | (h >> 15)) ^ ((h << 24) | (h >> 40));
+    h *= 0x9FB21C651E98DF25ull;
+    h ^= (h >> 35) + len;
+    h *= 0x9FB21C651E98DF25ull;
+    h ^= h >> 28;
+    return h;
+}
+
+static inline uint64_t xxh3_mix16(const uint8_t* in, const uint8_t* sec) {
+    return xxh_fold64(rd64(in) ^ rd64(sec), rd64(in + 8) ^ rd64(sec + 8));
+}
+
+static inline void xxh3_mix32(uint64_t* lo, uint64_t* hi, const uint8_t* in1, const uint8_t* in2, const uint8_t* sec) {
+    *lo += xxh3_mix16(in1, sec);
+    *lo ^= rd64(in2) + rd64(in2 + 8);
+    *hi += xxh3_mix16(in2, sec + 16);
+    *hi ^= rd64(in1) + rd64(in1 + 8);
+}
+
+/* Short inputs (the whole stream is in the state buffer). */
+static uint64_t xxh3_64_short(const uint8_t* in, size_t len) {
+    const uint8_t* s = xxh_secret;
+    if (len == 0) return xxh64_avalanche(rd64(s + 56) ^ rd64(s + 64));
+    if (len <= 3) {
+        uint32_t combo = ((uint32_t)in[0] << 16) | ((uint32_t)in[len >> 1] << 24) | (uint32_t)in[len - 1] | ((uint32_t)len << 8);
+        return xxh64_avalanche((uint64_t)combo ^ (uint64_t)(rd32(s) ^ rd32(s + 4)));
+    }
+    if (len <= 8) {
+        uint64_t in64 = (uint64_t)rd32(in + len - 4) + ((uint64_t)rd32(in) << 32);
+        return xxh3_rrmxmx(in64 ^ (rd64(s + 8) ^ rd64(s + 16)), len);
+    }
+    if (len <= 16) {
+        uint64_t lo = rd64(in) ^ (rd64(s + 24) ^ rd64(s + 32));
+        uint64_t hi = rd64(in + len - 8) ^ (rd64(s + 40) ^ rd64(s + 48));
+        return xxh3_avalanche(len + __builtin_bswap64(lo) + hi + xxh_fold64(lo, hi));
+    }
+
+    uint64_t acc = len * XXH_PRIME64_1;
+    if (len <= 128) {
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) {
+                    acc += xxh3_mix16(in + 48, s + 96);
+                    acc += xxh3_mix16(in + len - 64, s + 112);
+                }
+                acc += xxh3_mix16(in + 32, s + 64);
+                acc += xxh3_mix16(in + len - 48, s + 80);
+            }
+            acc += xxh3_mix16(in + 16, s + 32);
+            acc += xxh3_mix16(in + len - 32, s + 48);
+        }
+        acc += xxh3_mix16(in, s);
+        acc += xxh3_mix16(in + len - 16, s + 16);
+        return xxh3_avalanche(acc);
+    }
+
+    size_t rounds = len / 16;
+    for (size_t i = 0; i < 8; i++) acc += xxh3_mix16(in + 16 * i, s + 16 * i);
+    acc = xxh3_avalanche(acc);
+    for (size_t i = 8; i < rounds; i++) acc += xxh3_mix16(in + 16 * i, s + 16 * (i - 8) + 3);
+    acc += xxh3_mix16(in + len - 16, s + 136 - 17);
+    return xxh3_avalanche(acc);
+}
+
+static void xxh3_128_short(const uint8_t* in, size_t len, uint64_t* out_lo, uint64_t* out_hi) {
+    const uint8_t* s = xxh_secret;
+    if (len == 0) {
+        *out_lo = xxh64_avalanche(rd64(s + 64) ^ rd64(s + 72));
+        *out_hi = xxh64_avalanche(rd64(s + 80) ^ rd64(s + 88));
+        return;
+    }
+    if (len <= 3) {
+        uint32_t lo = ((uint32_t)in[0] << 16) | ((uint32_t)in[len >> 1] << 24) | (uint32_t)in[len - 1] | ((uint32_t)len << 8);
+        uint32_t hi = __builtin_bswap32(lo);
+        hi = (hi << 13) | (hi >> 19);
+        *out_lo = xxh64_avalanche((uint64_t)lo ^ (uint64_t)(rd32(s) ^ rd32(s + 4)));
+        *out_hi = xxh64_avalanche((uint64_t)hi ^ (uint64_t)(rd32(s + 8) ^ rd32(s + 12)));
+        return;
+    }
+    if (len <= 8) {
+        uint64_t in64 = (uint64_t)rd32(in) + ((uint64_t)rd32(in + len - 4) << 32);
+        uint64_t keyed = in64 ^ (rd64(s + 16) ^ rd64(s + 24));
+        unsigned __int128 m = (unsigned __int128)keyed * (XXH_PRIME64_1 + ((uint64_t)len << 2));
+        uint64_t lo = (uint64_t)m, hi = (uint64_t)(m >> 64);
+        hi += lo << 1;
+        lo ^= hi >> 3;
+        lo ^= lo >> 35;
+        lo *= 0x9FB21C651E98DF25ull;
+        lo ^= lo >> 28;
+        *out_lo = lo;
+        *out_hi = xxh3_avalanche(hi);
+        return;
+    }
+    if (len <= 16) {
+        uint64_t flip_lo = rd64(s + 32) ^ rd64(s + 40);
+        uint64_t flip_hi = rd64(s + 48) ^ rd64(s + 56);
+        uint64_t in_lo = rd64(in);
+        uint64_t in_hi = rd64(in + len - 8);
+        unsigned __int128 m = (unsigned __int128)(in_lo ^ in_hi ^ flip_lo) * XXH_PRIME64_1;
+        uint64_t m_lo = (uint64_t)m, m_hi = (uint64_t)(m >> 64);
+        m_lo += (uint64_t)(len - 1) << 54;
+        in_hi ^= flip_hi;
+        m_hi += in_hi + (uint64_t)(uint32_t)in_hi * (XXH_PRIME32_2 - 1);
+        m_lo ^= __builtin_bswap64(m_hi);
+        unsigned __int128 r = (unsigned __int128)m_lo * XXH_PRIME64_2;
+        uint64_t r_lo = (uint64_t)r, r_hi = (uint64_t)(r >> 64);
+        r_hi += m_hi * XXH_PRIME64_2;
+        *out_lo = xxh3_avalanche(r_lo);
+        *out_hi = xxh3_avalanche(r_hi);
+        return;
+    }
+
+    uint64_t lo = len * XXH_PRIME64_1, hi = 0;
+    if (len <= 128) {
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) xxh3_mix32(&lo, &hi, in + 48, in + len - 64, s + 96);
+                xxh3_mix32(&lo, &hi, in + 32, in + len - 48, s + 64);
+            }
+            xxh3_mix32(&lo, &hi, in + 16, in + len - 32, s + 32);
+        }
+        xxh3_mix32(&lo, &hi, in, in + len - 16, s);
+    } else {
+        size_t rounds = len / 32;
+        for (size_t i = 0; i < 4; i++) xxh3_mix32(&lo, &hi, in + 32 * i, in + 32 * i + 16, s + 32 * i);
+        lo = xxh3_avalanche(lo);
+        hi = xxh3_avalanche(hi);
+        for (size_t i = 4; i < rounds; i++) xxh3_mix32(&lo, &hi, in + 32 * i, in + 32 * i + 16, s + 3 + 32 * (i - 4));
+        xxh3_mix32(&lo, &hi, in + len - 16, in + len - 32, s + 136 - 17 - 16);
+    }
+    *out_lo = xxh3_avalanche(lo + hi);
+    *out_hi = 0 - xxh3_avalanche(lo * XXH_PRIME64_1 + hi * XXH_PRIME64_4 + len * XXH_PRIME64_2);
+}
+
+/* Long inputs: 8 accumulators over 64-byte stripes; the kernels differ only here. */
+typedef void (*Xxh3AccFn)(uint64_t* acc, const uint8_t* in, const uint8_t* sec, size_t nb_stripes);
+typedef void (*Xxh3ScrambleFn)(uint64_t* acc, const uint8_t* sec);
+
+static void xxh3_acc_scalar(uint64_t* acc, const uint8_t* in, const uint8_t* sec, size_t nb_stripes) {
+    for (size_t n = 0; n < nb_stripes; n++, in += XXH_STRIPE, sec += XXH_CONSUME_RATE) {
+        for (int i = 0; i < 8; i++) {
+            uint64_t v = rd64(in + 8 * i);
+            uint64_t k = v ^ rd64(sec + 8 * i);
+            acc[i ^ 1] += v;
+            acc[i] += (uint64_t)(uint32_t)k * (k >> 32);
+        }
+    }
+}
+
+static void xxh3_scramble_scalar(uint64_t* acc, const uint8_t* sec) {
+    for (int i = 0; i < 8; i++) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= rd64(sec + 8 * i);
+        acc[i] = a * XXH_PRIME32_1;
+    }
+}
+
+#if defined(__aarch64__)
+static void xxh3_acc_neon(uint64_t* acc, const uint8_t* in, const uint8_t* sec, size_t nb_stripes) {
+    uint64x2_t a[4];
+    for (int i = 0; i < 4; i++) a[i] = vld1q_u64(acc + 2 * i);
+    for (size_t n = 0; n < nb_stripes; n++, in += XXH_STRIPE, sec += XXH_CONSUME_RATE) {
+        for (int i = 0; i < 4; i++) {
+            uint64x2_t v = vreinterpretq_u64_u8(vld1q_u8(in + 16 * i));
+            uint64x2_t k = veorq_u64(v, vreinterpretq_u64_u8(vld1q_u8(sec + 16 * i)));
+            a[i] = vaddq_u64(a[i], vextq_u64(v, v, 1));
+            a[i] = vmlal_u32(a[i], vmovn_u64(k), vshrn_n_u64(k, 32));
+        }
+    }
+    for (int i = 0; i < 4; i++) vst1q_u64(acc + 2 * i, a[i]);
+}
+
+static void xxh3_scramble_neon(uint64_t* acc, const uint8_t* sec) {
+    const uint32x2_t prime = vdup_n_u32(XXH_PRIME32_1);
+    for (int i = 0; i < 4; i++) {
+        uint64x2_t a = vld1q_u64(acc + 2 * i);
+        a = veorq_u64(a, vshrq_n_u64(a, 47));
+        a = veorq_u64(a, vreinterpretq_u64_u8(vld1q_u8(sec + 16 * i)));
+        uint64x2_t hi = vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32);
+        vst1q_u64(acc + 2 * i, vmlal_u32(hi, vmovn_u64(a), prime));
+    }
+}
+#endif
+
+#if defined(__x86_64__)
+static void xxh3_acc_sse2(uint64_t* acc, const uint8_t* in, const uint8_t* sec, size_t nb_stripes) {
+    __m128i a[4];
+    for (int i = 0; i < 4; i++) a[i] = _mm_loadu_si128((const __m128i*)(acc + 2 * i));
+    for (size_t n = 0; n < nb_stripes; n++, in += XXH_STRIPE, sec += XXH_CONSUME_RATE) {
+        for (int i = 0; i < 4; i++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(in + 16 * i));
+            __m128i k = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)(sec + 16 * i)));
+            __m128i prod = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+            a[i] = _mm_add_epi64(a[i], _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+            a[i] = _mm_add_epi64(a[i], prod);
+        }
+    }
+    for (int i = 0; i < 4; i++) _mm_storeu_si128((__m128i*)(acc + 2 * i), a[i]);
+}
+
+static void xxh3_scramble_sse2(uint64_t* acc, const uint8_t* sec) {
+    const __m128i prime = _mm_set1_epi32((int)XXH_PRIME32_1);
+    for (int i = 0; i < 4; i++) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + 2 * i));
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i*)(sec + 16 * i)));
+        __m128i lo = _mm_mul_epu32(a, prime);
+        __m128i hi = _mm_mul_epu32(_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128((__m128i*)(acc + 2 * i), _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+    }
+}
+#endif
+
+static Xxh3AccFn      g_xxh_acc = xxh3_acc_scalar;
+static Xxh3ScrambleFn g_xxh_scramble = xxh3_scramble_scalar;
+
+/* nb_stripes more stripes into acc; scrambles at the end of each block. */
+static void xxh3_consume(uint64_t* acc, uint32_t* nb_acc, const uint8_t* in, size_t nb_stripes) {
+    size_t to_end = XXH_STRIPES_BLOCK - *nb_acc;
+    if (to_end <= nb_stripes) {
+        g_xxh_acc(acc, in, xxh_secret + *nb_acc * XXH_CONSUME_RATE, to_end);
+        g_xxh_scramble(acc, xxh_secret + XXH_SECRET_SIZE - XXH_STRIPE);
+        g_xxh_acc(acc, in + to_end * XXH_STRIPE, xxh_secret, nb_stripes - to_end);
+        *nb_acc = (uint32_t)(nb_stripes - to_end);
+    } else {
+        g_xxh_acc(acc, in, xxh_secret + *nb_acc * XXH_CONSUME_RATE, nb_stripes);
+        *nb_acc += (uint32_t)nb_stripes;
+    }
+}
+
+static void xxh3_update(Xxh3State* s, const uint8_t* in, size_t len) {
+    const size_t cap = sizeof(s->buf);
+    s->total += len;
+    if (s->buffered + len <= cap) {
+        memcpy(s->buf + s->buffered, in, len);
+        s->buffered += (uint32_t)len;
+        return;
+    }
+    if (s->buffered) {
+        size_t fill = cap - s->buffered;
+        memcpy(s->buf + s->buffered, in, fill);
+        in += fill;
+        len -= fill;
+        xxh3_consume(s->acc, &s->nb_stripes, s->buf, XXH_BUF_STRIPES);
+        s->buffered = 0;
+    }
+    /* Keep at least one byte back: the last stripe is handled at digest time. */
+    if (len > cap) {
+        do {
+            xxh3_consume(s->acc, &s->nb_stripes, in, XXH_BUF_STRIPES);
+            in += cap;
+            len -= cap;
+        } while (len > cap);
+        memcpy(s->buf + cap - XXH_STRIPE, in - XXH_STRIPE, XXH_STRIPE);
+    }
+    memcpy(s->buf, in, len);
+    s->buffered = (uint32_t)len;
+}
+
+static uint64_t xxh3_merge(const uint64_t* acc, const uint8_t* sec, uint64_t start) {
+    uint64_t r = start;
+    for (int i = 0; i < 4; i++) r += xxh_fold64(acc[2 * i] ^ rd64(sec + 16 * i), acc[2 * i + 1] ^ rd64(sec + 16 * i + 8));
+    return xxh3_avalanche(r);
+}
+
+/* Long digest: finishes a copy of the accumulators. */
+static void xxh3_long_acc(const Xxh3State* s, uint64_t acc[8]) {
+    memcpy(acc, s->acc, sizeof(s->acc));
+    const uint8_t* last_sec = xxh_secret + XXH_SECRET_SIZE - XXH_STRIPE - 7;
+    if (s->buffered >= XXH_STRIPE) {
+        uint32_t nb_acc = s->nb_stripes;
+        xxh3_consume(acc, &nb_acc, s->buf, (s->buffered - 1) / XXH_STRIPE);
+        g_xxh_acc(acc, s->buf + s->buffered - XXH_STRIPE, last_sec, 1);
+    } else {
+        uint8_t last[XXH_STRIPE];
+        size_t catchup = XXH_STRIPE - s->buffered;
+        memcpy(last, s->buf + sizeof(s->buf) - catchup, catchup);
+        memcpy(last + catchup, s->buf, s->buffered);
+        g_xxh_acc(acc, last, last_sec, 1);
+    }
+}
+
+static void xxh3_digest(const Xxh3State* s, bool wide, HashDigest* out) {
+    uint64_t lo, hi = 0;
+    if (s->total <= XXH_MIDSIZE_MAX) {
+        if (wide) xxh3_128_short(s->buf, (size_t)s->total, &lo, &hi);
+        else lo = xxh3_64_short(s->buf, (size_t)s->total);
+    } else {
+        uint64_t acc[8];
+        xxh3_long_acc(s, acc);
+        lo = xxh3_merge(acc, xxh_secret + 11, s->total * XXH_PRIME64_1);
+        if (wide) hi = xxh3_merge(acc, xxh_secret + XXH_SECRET_SIZE - 64 - 11, ~(s->total * XXH_PRIME64_2));
+    }
+    if (wide) {
+        put_be64(out->b, hi);
+        put_be64(out->b + 8, lo);
+        out->len = 16;
+    } else {
+        put_be64(out->b, lo);
+        out->len = 8;
+    }
+}
+
+/* --------------------------------------------------------------------------
+   SHA-256
+----------------------------------------------------------------------------*/
+typedef void (*Sha256BlocksFn)(uint32_t* h, const uint8_t* p, size_t nblocks);
+
+static const uint32_t sha_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint32_t sha_init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static inline uint32_t ror32(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha256_blocks_portable(uint32_t* h, const uint8_t* p, size_t nblocks) {
+    for (; nblocks; nblocks--, p += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) w[i] = __builtin_bswap32(rd32(p + 4 * i));
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = ror32(w[i - 15], 7) ^ ror32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = ror32(w[i - 2], 17) ^ ror32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = hh + (ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25)) + ((e & f) ^ (~e & g)) + sha_k[i] + w[i];
+            uint32_t t2 = (ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+    }
+}
+
+#if defined(__aarch64__)
+/* ARMv8 Crypto Extension: 4 rounds per SHA256H/SHA256H2 pair, schedule with SHA256SU0/SU1. */
+__attribute__((target("+crypto")))
+static void sha256_blocks_armv8(uint32_t* h, const uint8_t* p, size_t nblocks) {
+    uint32x4_t abcd = vld1q_u32(h);
+    uint32x4_t efgh = vld1q_u32(h + 4);
+    for (; nblocks; nblocks--, p += 64) {
+        uint32x4_t abcd0 = abcd, efgh0 = efgh;
+        uint32x4_t m[4];
+        for (int i = 0; i < 4; i++) m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p + 16 * i)));
+        for (int i = 0; i < 16; i++) {
+            uint32x4_t wk = vaddq_u32(m[i & 3], vld1q_u32(sha_k + 4 * i));
+            uint32x4_t t = abcd;
+            abcd = vsha256hq_u32(abcd, efgh, wk);
+            efgh = vsha256h2q_u32(efgh, t, wk);
+            if (i < 12) m[i & 3] = vsha256su1q_u32(vsha256su0q_u32(m[i & 3], m[(i + 1) & 3]), m[(i + 2) & 3], m[(i + 3) & 3]);
+        }
+        abcd = vaddq_u32(abcd, abcd0);
+        efgh = vaddq_u32(efgh, efgh0);
+    }
+    vst1q_u32(h, abcd);
+    vst1q_u32(h + 4, efgh);
+}
+#endif
+
+static Sha256BlocksFn g_sha_blocks = sha256_blocks_portable;
+
+static void sha256_update(Sha256State* s, const uint8_t* in, size_t len) {
+    s->total += len;
+    if (s->buffered) {
+        size_t n = 64 - s->buffered;
+        if (n > len) n = len;
+        memcpy(s->buf + s->buffered, in, n);
+        s->buffered += (uint32_t)n;
+        in += n;
+        len -= n;
+        if (s->buffered < 64) return;
+        g_sha_blocks(s->h, s->buf, 1);
+        s->buffered = 0;
+    }
+    if (len >= 64) {
+        g_sha_blocks(s->h, in, len / 64);
+        in += len & ~(size_t)63;
+        len &= 63;
+    }
+    memcpy(s->buf, in, len);
+    s->buffered = (uint32_t)len;
+}
+
+static void sha256_digest(const Sha256State* s, HashDigest* out) {
+    uint32_t h[8];
+    uint8_t tail[128];
+    memcpy(h, s->h, sizeof(h));
+    size_t n = s->buffered;
+    memcpy(tail, s->buf, n);
+    tail[n++] = 0x80;
+    size_t blocks = (n + 8 <= 64) ? 1 : 2;
+    memset(tail + n, 0, blocks * 64 - n);
+    put_be64(tail + blocks * 64 - 8, s->total * 8);
+    g_sha_blocks(h, tail, blocks);
+    for (int i = 0; i < 8; i++) {
+        out->b[4 * i + 0] = (uint8_t)(h[i] >> 24);
+        out->b[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out->b[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        out->b[4 * i + 3] = (uint8_t)h[i];
+    }
+    out->len = 32;
+}
+
+/* --------------------------------------------------------------------------
+   API
+----------------------------------------------------------------------------*/
+void hash_begin(HashState* h, HashAlgo algo) {
+    h->algo = algo;
+    if (algo == HASH_XXH3_64 || algo == HASH_XXH3_128) {
+        Xxh3State* s = &h->u.x;
+        memcpy(s->acc, xxh_init_acc, sizeof(s->acc));
+        s->buffered = 0;
+        s->nb_stripes = 0;
+        s->total = 0;
+    } else if (algo == HASH_SHA256) {
+        Sha256State* s = &h->u.s;
+        memcpy(s->h, sha_init, sizeof(s->h));
+        s->buffered = 0;
+        s->total = 0;
+    }
+}
+
+void hash_update(HashState* h, const void* data, size_t len) {
+    if (h->algo == HASH_XXH3_64 || h->algo == HASH_XXH3_128) xxh3_update(&h->u.x, (const uint8_t*)data, len);
+    else if (h->algo == HASH_SHA256) sha256_update(&h->u.s, (const uint8_t*)data, len);
+}
+
+void hash_final(const HashState* h, HashDigest* out) {
+    memset(out, 0, sizeof(*out));
+    out->algo = h->algo;
+    if (h->algo == HASH_XXH3_64) xxh3_digest(&h->u.x, false, out);
+    else if (h->algo == HASH_XXH3_128) xxh3_digest(&h->u.x, true, out);
+    else if (h->algo == HASH_SHA256) sha256_digest(&h->u.s, out);
+}
+
+size_t hash_digest_len(HashAlgo algo) {
+    switch (algo) {
+        case HASH_XXH3_64:  return 8;
+        case HASH_XXH3_128: return 16;
+        case HASH_SHA256:   return 32;
+        default:            return 0;
+    }
+}
+
+void hash_hex(char* out, size_t cap, const HashDigest* d) {
+    static const char hx[] = "0123456789abcdef";
+    size_t n = 0;
+    for (size_t i = 0; i < d->len && n + 2 < cap; i++) {
+        out[n++] = hx[d->b[i] >> 4];
+        out[n++] = hx[d->b[i] & 15];
+    }
+    if (cap) out[n] = 0;
+}
+
+/* --------------------------------------------------------------------------
+   Kernels: self-test, benchmark, selection
+----------------------------------------------------------------------------*/
+typedef struct {
+    HashKernelInfo info;
+    Xxh3AccFn      acc;        /* XXH3 */
+    Xxh3ScrambleFn scramble;
+    Sha256BlocksFn blocks;     /* SHA-256 */
+} HashKernelEntry;
+
+static HashKernelEntry g_kernels[] = {
+    { { "xxh3-scalar",     HASH_XXH3_64, true,  false, 0.0 }, xxh3_acc_scalar, xxh3_scramble_scalar, NULL },
+#if defined(__aarch64__)
+    { { "xxh3-neon",       HASH_XXH3_64, true,  false, 0.0 }, xxh3_acc_neon, xxh3_scramble_neon, NULL },
+#endif
+#if defined(__x86_64__)
+    { { "xxh3-sse2",       HASH_XXH3_64, true,  false, 0.0 }, xxh3_acc_sse2, xxh3_scramble_sse2, NULL },
+#endif
+    { { "sha256-portable", HASH_SHA256,  true,  false, 0.0 }, NULL, NULL, sha256_blocks_portable },
+#if defined(__aarch64__)
+    { { "sha256-armv8",    HASH_SHA256,  false, false, 0.0 }, NULL, NULL, sha256_blocks_armv8 },
+#endif
+};
+
+#define HASH_KERNEL_COUNT ((int)(sizeof(g_kernels) / sizeof(g_kernels[0])))
+
+static int  g_sel_xxh = 0;
+static int  g_sel_sha = 0;
+static bool hash_ready = false;
+
+#if defined(__aarch64__)
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+
+static bool hash_have_sha2(void) {
+#if defined(__SWITCH__)
+    return true;   /* Cortex-A57: Crypto extension */
+#elif defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#elif defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+    return true;
+#else
+    return false;
+#endif
+}
+#endif
+
+static void hash_use(const HashKernelEntry* k) {
+    if (k->info.algo == HASH_SHA256) {
+        g_sha_blocks = k->blocks;
+    } else {
+        g_xxh_acc = k->acc;
+        g_xxh_scramble = k->scramble;
+    }
+}
+
+/* Known answers for the portable kernels: the test buffer's first 'len' bytes. */
+typedef struct {
+    size_t      len;
+    const char* xxh64;
+    const char* xxh128;
+    const char* sha256;
+} HashVector;
+
+static const HashVector g_vectors[] = {
+    { 0,    "2d06800538d394c2", "99aa06d3014798d86001c324468d497f",
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { 3,    "8136d69cc9fcbe16", "6c2ecb29ed35e0208136d69cc9fcbe16",
+            "c70406763cd0f149b4caf62c4e1ffdb8c0c3402ac386569e09e701eb2779b6a7" },
+    { 6,    "7fa5e2d0edd6e73d", "cf8ffae50f172ea30d940f2ce8349471",
+            "0ca7086b0621b21b6eaf26d3daf51272243902c72e351e198bd34a1c45a2df6b" },
+    { 12,   "356534fb234ce97f", "3db13ab539999d8721311a6c9ee387ad",
+            "efa468783703f087d808048af37d4724e6294feeafdc67d131ebe188e81a3752" },
+    { 100,  "70cafcc2e3b73b5b", "bab84159bfc2d5b85c846f5f23f7f8d9",
+            "2df613f509e6a20b2f3c05f690661931d1dace425a0faa95a3def8860fd8623c" },
+    { 200,  "bae898155909ba33", "e955a39f0497514166ec6a1b22b7df5d",
+            "d31ee5c04cdb4871577cd030766854f2e36b3e75cd54ecf0e2a8822e51d98557" },
+    { 5000, "912d518e8fa40cc7", "3779c74d6db39d9c912d518e8fa40cc7",
+            "5ec0413b9953804b6f044d5719a854ac4f7673a5361c713c98c1445bbea08d3a" },
+};
+
+/* Hashes buf[0..len) fed in uneven pieces, so the streaming paths are covered too. */
+static void hash_pieces(HashAlgo algo, const uint8_t* buf, size_t len, size_t piece, HashDigest* out) {
+    HashState h;
+    hash_begin(&h, algo);
+    size_t off = 0;
+    while (off < len) {
+        size_t n = (len - off < piece) ? len - off : piece;
+        hash_update(&h, buf + off, n);
+        off += n;
+        piece = piece * 3 + 1;
+    }
+    hash_final(&h, out);
+}
+
+static bool hash_check_vectors(HashAlgo algo, const uint8_t* buf) {
+    for (size_t i = 0; i < sizeof(g_vectors) / sizeof(g_vectors[0]); i++) {
+        const HashVector* v = &g_vectors[i];
+        const char* want = (algo == HASH_SHA256) ? v->sha256 : (algo == HASH_XXH3_128) ? v->xxh128 : v->xxh64;
+        for (size_t piece = 1; piece <= 4096; piece *= 64) {
+            HashDigest d;
+            char hex[2 * HASH_DIGEST_MAX + 1];
+            hash_pieces(algo, buf, v->len, piece, &d);
+            hash_hex(hex, sizeof(hex), &d);
+            if (strcmp(hex, want) != 0) return false;
+        }
+    }
+    return true;
+}
+
+/* The kernel in use against the portable one (ref) over assorted lengths and alignments. */
+static bool hash_kernel_selftest(const HashKernelEntry* k, const HashKernelEntry* ref, const uint8_t* buf, size_t buf_len) {
+    static const size_t lens[] = { 63, 64, 65, 239, 240, 241, 255, 256, 257, 1023, 1024, 1025, 4095, 4096, 4097, 20000 };
+    HashAlgo algos[2] = { k->info.algo, (k->info.algo == HASH_XXH3_64) ? HASH_XXH3_128 : k->info.algo };
+    for (int a = 0; a < 2; a++) {
+        for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            for (size_t off = 0; off < 8; off += 3) {
+                if (lens[i] + off > buf_len) continue;
+                HashDigest d1, d2;
+                hash_use(ref);
+                hash_pieces(algos[a], buf + off, lens[i], 7 + i, &d1);
+                hash_use(k);
+                hash_pieces(algos[a], buf + off, lens[i], 100 + off, &d2);
+                if (d1.len != d2.len || memcmp(d1.b, d2.b, d1.len) != 0) return false;
+            }
+        }
+    }
+    return true;
+}
+
+static double hash_kernel_bench(HashAlgo algo, const uint8_t* buf, size_t len) {
+    HashState h;
+    hash_begin(&h, algo);
+    uint64_t bytes = 0;
+    uint64_t t0 = armGetSystemTick();
+    uint64_t ns = 0;
+    for (int rep = 0; rep < 256; rep++) {
+        hash_update(&h, buf, len);
+        bytes += len;
+        ns = armTicksToNs(armGetSystemTick() - t0);
+        if (ns >= 2000000ull) break;  /* ~2 ms per kernel */
+    }
+    HashDigest d;
+    hash_final(&h, &d);
+    if (ns == 0) ns = 1;
+    return ((double)bytes / 1048576.0) / ((double)ns / 1e9);
+}
+
+void hash_init(void) {
+    if (hash_ready) return;
+#if defined(__aarch64__)
+    for (int i = 0; i < HASH_KERNEL_COUNT; i++) {
+        if (g_kernels[i].blocks == sha256_blocks_armv8) g_kernels[i].info.available = hash_have_sha2();
+    }
+#endif
+
+    const size_t buf_len = 64u * 1024u;
+    uint8_t* buf = (uint8_t*)malloc(buf_len);
+    if (!buf) {
+        hash_ready = true;   /* portable kernels */
+        return;
+    }
+    uint32_t x = 0x12345678u;
+    for (size_t i = 0; i < buf_len; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+
+    /* The first kernel of each algorithm is the portable reference. */
+    int ref[HASH_ALGO_COUNT] = { -1, -1, -1, -1 };
+    for (int i = 0; i < HASH_KERNEL_COUNT; i++) {
+        HashKernelEntry* k = &g_kernels[i];
+        if (!k->info.available) continue;
+        HashAlgo a = k->info.algo;
+        if (ref[a] < 0) {
+            ref[a] = i;
+            hash_use(k);
+            k->info.verified = hash_check_vectors(a, buf) && (a != HASH_XXH3_64 || hash_check_vectors(HASH_XXH3_128, buf));
+        } else {
+            k->info.verified = g_kernels[ref[a]].info.verified && hash_kernel_selftest(k, &g_kernels[ref[a]], buf, buf_len);
+        }
+        if (!k->info.verified) {
+            log_pushf("WARN", "Hash kernel %s failed self-test; not used.", k->info.name);
+            continue;
+        }
+        hash_use(k);
+        k->info.mib_s = hash_kernel_bench(a, buf, buf_len);
+    }
+    free(buf);
+
+    int* sel[2] = { &g_sel_xxh, &g_sel_sha };
+    HashAlgo algos[2] = { HASH_XXH3_64, HASH_SHA256 };
+    for (int s = 0; s < 2; s++) {
+        int best = ref[algos[s]];
+        for (int i = 0; i < HASH_KERNEL_COUNT; i++) {
+            const HashKernelEntry* k = &g_kernels[i];
+            if (k->info.algo == algos[s] && k->info.verified && k->info.mib_s > g_kernels[best].info.mib_s) best = i;
+        }
+        *sel[s] = best;
+        hash_use(&g_kernels[best]);
+        if (!g_kernels[best].info.verified) log_pushf("WARN", "Hash: %s reference failed its test vectors.", hash_algo_name(algos[s]));
+    }
+    hash_ready = true;
+
+    log_pushf("INFO", "Hash kernels: %s (%.0f MiB/s), %s (%.0f MiB/s)",
+              g_kernels[g_sel_xxh].info.name, g_kernels[g_sel_xxh].info.mib_s,
+              g_kernels[g_sel_sha].info.name, g_kernels[g_sel_sha].info.mib_s);
+}
+
+static const HashKernelEntry* hash_selected(HashAlgo algo) {
+    if (algo == HASH_XXH3_64 || algo == HASH_XXH3_128) return &g_kernels[g_sel_xxh];
+    if (algo == HASH_SHA256) return &g_kernels[g_sel_sha];
+    return NULL;
+}
+
+const char* hash_kernel_name(HashAlgo algo) {
+    const HashKernelEntry* k = hash_selected(algo);
+    return k ? k->info.name : "-";
+}
+
+double hash_kernel_mib_s(HashAlgo algo) {
+    const HashKernelEntry* k = hash_selected(algo);
+    return k ? k->info.mib_s : 0.0;
+}
+
+int hash_kernel_count(void) {
+    return HASH_KERNEL_COUNT;
+}
+
+const HashKernelInfo* hash_kernel_info(int idx) {
+    if (idx < 0 || idx >= HASH_KERNEL_COUNT) return NULL;
+    return &g_kernels[idx].info;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "app.h"
+#include "config.h"
+
+/*
+ * Content hashes for full reads, next to the CRC-32: XXH3-64, XXH3-128 (default secret, seed 0;
+ * same values as the reference xxhash library) and SHA-256. Like crc32.c, each algorithm has a
+ * portable kernel and SIMD/crypto kernels; hash_init() checks them against the portable one,
+ * times them and selects the fastest per algorithm.
+ */
+#define HASH_DIGEST_MAX 32
+
+typedef struct {
+    uint64_t acc[8];
+    uint8_t  buf[256];
+    uint32_t buffered;
+    uint32_t nb_stripes;         /* stripes accumulated in the current block */
+    uint64_t total;
+} Xxh3State;
+
+typedef struct {
+    uint32_t h[8];
+    uint8_t  buf[64];
+    uint32_t buffered;
+    uint64_t total;
+} Sha256State;
+
+typedef struct {
+    HashAlgo algo;
+    union {
+        Xxh3State   x;
+        Sha256State s;
+    } u;
+} HashState;
+
+/* Canonical (big-endian) digest, as xxhsum / sha256sum print it. len 0: CRC-32 only. */
+typedef struct {
+    HashAlgo algo;
+    uint8_t  len;
+    uint8_t  b[HASH_DIGEST_MAX];
+} HashDigest;
+
+/* Selects the kernels. Idempotent; called once at startup (and defensively by the engine). */
+void hash_init(void);
+
+void hash_begin(HashState* h, HashAlgo algo);
+void hash_update(HashState* h, const void* data, size_t len);
+/* Does not change h; the stream can go on. */
+void hash_final(const HashState* h, HashDigest* out);
+
+size_t hash_digest_len(HashAlgo algo);
+/* Lower-case hex; out must hold 2 * HASH_DIGEST_MAX + 1. */
+void hash_hex(char* out, size_t cap, const HashDigest* d);
+
+typedef struct {
+    const char* name;
+    HashAlgo    algo;
+    bool        available;   /* supported by this CPU/build */
+    bool        verified;    /* matched the portable kernel (and the portable one the test vectors) */
+    double      mib_s;       /* startup micro-benchmark, 0 if not run */
+} HashKernelInfo;
+
+/* Selected kernel of an algorithm ("-" for HASH_CRC32) and its benchmark. */
+const char* hash_kernel_name(HashAlgo algo);
+double hash_kernel_mib_s(HashAlgo algo);
+int hash_kernel_count(void);
+const HashKernelInfo* hash_kernel_info(int idx);
@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+ * Minimal libnx stand-ins for host (Linux/POSIX) builds.
+ * Only what the scan engine and its helpers use; the UI (main.c) stays Switch-only.
+ */
+#ifndef __SWITCH__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <sched.h>
+
+typedef uint32_t Result;
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define R_FAILED(rc)    ((rc) != 0)
+
+/* The engine only passes the pad through to the UI callback. */
+typedef struct {
+    uint64_t unused;
+} PadState;
+
+/* Host "system tick" is CLOCK_MONOTONIC in nanoseconds. */
+static inline uint64_t armGetSystemTick(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t armGetSystemTickFreq(void) { return 1000000000ull; }
+static inline uint64_t armTicksToNs(uint64_t ticks) { return ticks; }
+
+/* As on the console, a zero/negative timeout just yields the core. */
+static inline void svcSleepThread(int64_t ns) {
+    if (ns <= 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000ll);
+    ts.tv_nsec = (long)(ns % 1000000000ll);
+    nanosleep(&ts, NULL);
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "journal.h"
+#include "util.h"
+#include "log.h"
+#include "crc32.h"
+#include "trace.h"
+
+void resume_cursor_take(ResumeCursor* c, const WorkItem* it) {
+    c->set = true;
+    c->seq = it->seq;
+    c->enter = it->entered;
+    c->end = (it->kind == WORK_END);
+    c->busy = false;
+    c->started = false;
+    c->mtime_ok = it->mtime_ok;
+    c->mtime = it->mtime;
+    c->size = it->size;
+    c->counts = it->counts;
+    snprintf(c->path, sizeof(c->path), "%s", it->path ? it->path : "");
+}
+
+ScanJournal* journal_create(const char* root, const ScanConfig* cfg, const ResumeImage* resume, ScanUiUpdateFn ui_update) {
+    ScanJournal* j = (ScanJournal*)calloc(1, sizeof(*j));
+    if (!j) return NULL;
+    snprintf(j->img.root, sizeof(j->img.root), "%s", root);
+    j->img.cfg = *cfg;
+    j->ui_update = ui_update;
+    j->interval_ms = (uint64_t)cfg->checkpoint_sec * 1000ull;
+    j->last_ms = now_ms();
+    j->prior_ms = resume ? resume->elapsed_ms : 0;
+    return j;
+}
+
+bool journal_due(const ScanJournal* j) {
+    return !j->failed && now_ms() - j->last_ms >= j->interval_ms;
+}
+
+void journal_collect_begin(ScanJournal* j) {
+    j->img.cursor_set = false;
+    j->img.nfiles = 0;
+    j->cursor_seq = 0;
+}
+
+void journal_collect(ScanJournal* j, const ResumeCursor* cur, const ScanStats* cst) {
+    ResumeImage* im = &j->img;
+    if (!cur->set) return;
+    if (!im->cursor_set || cur->seq > j->cursor_seq) {
+        im->cursor_set = true;
+        im->cursor_enter = cur->enter;
+        im->cursor_end = cur->end;
+        memcpy(im->cursor, cur->path, sizeof(im->cursor));
+        j->cursor_seq = cur->seq;
+        j->cursor_counts = cur->counts;
+    }
+    if (!cur->busy || im->nfiles >= READERS_MAX) return;
+    ResumeFile* rf = &im->files[im->nfiles++];
+    memset(rf, 0, sizeof(*rf));
+    memcpy(rf->path, cur->path, sizeof(rf->path));
+    rf->size = cur->size;
+    rf->started = cur->started;
+    rf->sample = cst->current_sample;
+    if (cur->started && cst->current_seq_read && cst->current_crc_off > 0 && cur->mtime_ok) {
+        /* The hasher may trail the reads: continue where it got, the rest is read again. */
+        rf->off = cst->current_crc_off;
+        rf->undo = cst->current_done - cst->current_crc_off;
+        rf->crc = cst->current_crc;
+        rf->crc_set = true;
+        rf->mtime = cur->mtime;
+    } else if (cur->started && cst->current_seq_read) rf->off = cst->current_done;
+    else if (cur->started) rf->undo = cst->current_done;
+}
+
+/* The counters and header of a checkpoint, on the thread that owns st. */
+static void journal_fill(ScanJournal* j, const ScanStats* st) {
+    ResumeImage* im = &j->img;
+    memcpy(im->magic, RESUME_MAGIC, sizeof(im->magic));
+    im->format = RESUME_FORMAT_VERSION;
+    snprintf(im->version, sizeof(im->version), "%s", SDCHECK_VERSION);
+    im->size = (uint32_t)sizeof(*im);
+    im->saved_at = (int64_t)time(NULL);
+    im->elapsed_ms = j->prior_ms + scan_stats_elapsed_ms(st, now_ms());
+    im->st = *st;
+    im->st.journal = NULL;
+    if (im->cursor_set) walk_counts_apply(&im->st, &j->cursor_counts);
+    j->last_ms = now_ms();
+}
+
+/* Writes a filled record (one thread at a time: the writer thread or, without it, the caller). */
+static bool journal_store(ScanJournal* j, ResumeImage* im) {
+    uint64_t t0 = now_us();
+    im->crc = 0;
+    im->crc = crc32_update(0, im, sizeof(*im));
+
+    FILE* f = fopen(RESUME_TMP_PATH, "wb");
+    bool ok = f && fwrite(im, sizeof(*im), 1, f) == 1;
+    if (f && fclose(f) != 0) ok = false;
+    if (ok) {
+        remove(SCAN_RESUME_PATH);
+        ok = (rename(RESUME_TMP_PATH, SCAN_RESUME_PATH) == 0);
+    }
+    if (!ok) {
+        log_pushf("WARN", "Resume journal: write failed (%s); no further checkpoints this run.", strerror(errno));
+        remove(RESUME_TMP_PATH);
+    }
+    j->writes++;
+    j->write_us += now_us() - t0;
+    return ok;
+}
+
+void journal_write(ScanJournal* j, const ScanStats* st) {
+    journal_fill(j, st);
+    if (!journal_store(j, &j->img)) j->failed = true;
+}
+
+static void journal_writer_main(void* arg) {
+    ScanJournal* j = (ScanJournal*)arg;
+    trace_thread("journal");
+    pthread_mutex_lock(&j->lock);
+    for (;;) {
+        while (!j->pending && !j->stop) pthread_cond_wait(&j->cv, &j->lock);
+        if (!j->pending) break;
+        memcpy(&j->out, &j->img, sizeof(j->out));
+        j->pending = false;
+        pthread_mutex_unlock(&j->lock);
+
+        bool ok = journal_store(j, &j->out);
+
+        pthread_mutex_lock(&j->lock);
+        if (!ok) j->write_failed = true;
+    }
+    pthread_mutex_unlock(&j->lock);
+}
+
+void journal_writer_start(ScanJournal* j) {
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->cv, NULL);
+    j->threaded = worker_start(&j->thread, journal_writer_main, j, 2, 0x10000);
+    if (!j->threaded) {
+        pthread_cond_destroy(&j->cv);
+        pthread_mutex_destroy(&j->lock);
+    }
+}
+
+void journal_writer_stop(ScanJournal* j) {
+    if (!j->threaded) return;
+    pthread_mutex_lock(&j->lock);
+    j->stop = true;
+    pthread_cond_signal(&j->cv);
+    pthread_mutex_unlock(&j->lock);
+    worker_join(&j->thread);
+    j->threaded = false;
+    if (j->write_failed) j->failed = true;
+    pthread_cond_destroy(&j->cv);
+    pthread_mutex_destroy(&j->lock);
+}
+
+void journal_checkpoint_self(ScanJournal* j, const ScanStats* st) {
+    if (!j->threaded) {
+        journal_collect_begin(j);
+        journal_collect(j, &j->self, st);
+        journal_write(j, st);
+        return;
+    }
+    pthread_mutex_lock(&j->lock);
+    if (j->write_failed) {
+        j->failed = true;
+    } else {
+        journal_collect_begin(j);
+        journal_collect(j, &j->self, st);
+        journal_fill(j, st);
+        j->pending = true;
+        pthread_cond_signal(&j->cv);
+    }
+    pthread_mutex_unlock(&j->lock);
+}
+
+void journal_ui_tick(ScanStats* st, PadState* pad, bool force) {
+    ScanJournal* j = st->journal;
+    if (j->ui_update) j->ui_update(st, pad, force);
+    if (journal_due(j)) journal_checkpoint_self(j, st);
+}
+
+static bool resume_load_file(const char* path, ResumeImage* im) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    bool ok = (fread(im, sizeof(*im), 1, f) == 1);
+    fclose(f);
+    if (!ok) return false;
+    if (memcmp(im->magic, RESUME_MAGIC, sizeof(im->magic)) != 0 || im->size != (uint32_t)sizeof(*im)) return false;
+    if (im->format != RESUME_FORMAT_VERSION) return false;
+    if (strncmp(im->version, SDCHECK_VERSION, sizeof(im->version)) != 0) return false;
+    uint32_t crc = im->crc;
+    im->crc = 0;
+    ok = (crc32_update(0, im, sizeof(*im)) == crc);
+    im->crc = crc;
+    im->root[sizeof(im->root) - 1] = 0;
+    im->cursor[sizeof(im->cursor) - 1] = 0;
+    if (im->nfiles > READERS_MAX) im->nfiles = READERS_MAX;
+    for (uint32_t i = 0; i < im->nfiles; i++) im->files[i].path[RESUME_PATH_MAX - 1] = 0;
+    return ok;
+}
+
+bool resume_load(ResumeImage* im) {
+    return resume_load_file(SCAN_RESUME_PATH, im) || resume_load_file(RESUME_TMP_PATH, im);
+}
+
+bool scan_resume_peek(ScanResumeInfo* out) {
+    ResumeImage* im = (ResumeImage*)malloc(sizeof(*im));
+    if (!im) return false;
+    bool ok = resume_load(im);
+    if (ok && out) {
+        memset(out, 0, sizeof(*out));
+        snprintf(out->root, sizeof(out->root), "%s", im->root);
+        out->cfg = im->cfg;
+        out->files_read = im->st.files_read;
+        out->bytes_read = im->st.bytes_read;
+        out->bytes_total = im->st.bytes_total;
+        out->elapsed_ms = im->elapsed_ms;
+        out->saved_at = im->saved_at;
+    }
+    free(im);
+    return ok;
+}
+
+void scan_resume_discard(void) {
+    remove(SCAN_RESUME_PATH);
+    remove(RESUME_TMP_PATH);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "scan_internal.h"
+
+/*
+ * Each consumer of work items keeps a ResumeCursor: the last item it took and whether that
+ * item's file is still being read. Items are taken in traversal order, so everything up to the
+ * newest cursor was taken, and everything taken is finished except the files in flight. A
+ * checkpoint is the newest cursor path, the in-flight files with their offsets and the counters
+ * (which include the in-flight progress). A resumed walk re-queues the in-flight files first,
+ * then descends to the cursor by name and goes on after it. Files read front to back continue
+ * at the offset the hasher had reached, from its CRC, so the whole-file CRC can still go into the
+ * manifest; samples and range reads start over, their partial bytes taken off the counters.
+ *
+ * The journal is one fixed-size record (about 29 KiB, most of it the ScanStats a resumed scan
+ * starts from), written to a temp file that is renamed over the previous one. A pool writes it
+ * from pool_merge on the UI thread; a single reader only fills it in and hands the file I/O to
+ * a writer thread, so checkpoints do not stall the reads.
+ */
+#define RESUME_PATH_MAX 769            /* FS_MAX_PATH */
+#define RESUME_MAGIC    "SDCKJRN1"
+#define RESUME_FORMAT_VERSION 2        /* bump with any layout change of ResumeImage, ScanConfig or ScanStats */
+#define RESUME_TMP_PATH SCAN_RESUME_DIR "/sdcheck.resume.tmp"
+
+struct ResumeCursor {
+    uint64_t seq;
+    bool     set;        /* an item was taken */
+    bool     enter;      /* the item is a directory the walk went into (partial listing) */
+    bool     end;        /* the item was the end of the walk */
+    bool     busy;       /* its file is in flight */
+    bool     started;    /* ... and counted in files_read */
+    bool     mtime_ok;
+    int64_t  mtime;
+    uint64_t size;
+    WalkCounts counts;   /* walker totals as of the item */
+    char     path[RESUME_PATH_MAX];
+};
+
+typedef struct {
+    char     path[RESUME_PATH_MAX];
+    uint64_t size;
+    uint64_t off;        /* continue here; 0 = read again from the start */
+    uint64_t undo;       /* restarted read: bytes to take off the counters */
+    int64_t  mtime;
+    uint32_t crc;        /* crc_set: CRC-32 of the bytes before off, the file at mtime */
+    bool     crc_set;
+    bool     sample;
+    bool     started;
+} ResumeFile;
+
+typedef struct {
+    char       magic[8];
+    char       version[32];
+    uint32_t   size;
+    uint32_t   crc;      /* of the record with crc = 0 */
+    uint32_t   format;   /* RESUME_FORMAT_VERSION */
+    uint32_t   reserved;
+    int64_t    saved_at;
+    uint64_t   elapsed_ms;
+    char       root[256];
+    ScanConfig cfg;
+    ScanStats  st;
+    bool       cursor_set;
+    bool       cursor_enter;
+    bool       cursor_end;
+    char       cursor[RESUME_PATH_MAX];
+    uint32_t   nfiles;
+    ResumeFile files[READERS_MAX];
+} ResumeImage;
+
+/* The record is raw structs: a layout change of the same size would load as garbage. When this
+   fails, bump RESUME_FORMAT_VERSION and update the size. */
+_Static_assert(sizeof(ResumeImage) == 29232, "ResumeImage changed: bump RESUME_FORMAT_VERSION");
+
+struct ScanJournal {
+    ResumeImage    img;
+    uint64_t       cursor_seq;
+    WalkCounts     cursor_counts;
+    ResumeCursor   self;         /* single reader: the UI thread's cursor */
+    ScanUiUpdateFn ui_update;    /* caller's hook; single reader runs through journal_ui_tick */
+    uint64_t       interval_ms;
+    uint64_t       last_ms;
+    uint64_t       prior_ms;     /* scan time of earlier sessions */
+    uint32_t       writes;
+    uint64_t       write_us;
+    bool           failed;       /* a write failed: no more checkpoints this run */
+
+    /* Single reader: the writer thread copies img to out and writes that. */
+    pthread_mutex_t lock;
+    pthread_cond_t  cv;
+    ResumeImage     out;
+    bool            pending;     /* img holds a checkpoint not taken yet */
+    bool            stop;
+    bool            write_failed;  /* writer -> reading thread (becomes failed) */
+    WorkerThread    thread;
+    bool            threaded;
+};
+typedef struct ScanJournal ScanJournal;
+
+/* Items are taken in order: c becomes it (not in flight yet). */
+void resume_cursor_take(ResumeCursor* c, const WorkItem* it);
+
+ScanJournal* journal_create(const char* root, const ScanConfig* cfg, const ResumeImage* resume, ScanUiUpdateFn ui_update);
+/* A checkpoint is due (checkpoint_sec passed, no write failed). */
+bool journal_due(const ScanJournal* j);
+/* A pool checkpoint on the UI thread: begin, collect each reader, write. */
+void journal_collect_begin(ScanJournal* j);
+/* One consumer's cursor and stats (the stats it was reading with, for the in-flight offset). */
+void journal_collect(ScanJournal* j, const ResumeCursor* cur, const ScanStats* cst);
+void journal_write(ScanJournal* j, const ScanStats* st);
+/* Single reader: the writer thread (core 2, with the walker); without it, writes stay inline. */
+void journal_writer_start(ScanJournal* j);
+/* Writes a checkpoint still pending and joins the writer. */
+void journal_writer_stop(ScanJournal* j);
+/* Single reader: checkpoint from the reading thread's own cursor; the writer thread does the I/O. */
+void journal_checkpoint_self(ScanJournal* j, const ScanStats* st);
+/* ui_update hook of single-reader runs: the caller's hook, then a checkpoint when due. */
+void journal_ui_tick(ScanStats* st, PadState* pad, bool force);
+/* The journal, or the temp file when power went between the remove and the rename. */
+bool resume_load(ResumeImage* im);
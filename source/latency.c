@@ -0,0 +1,61 @@
+#include "latency.h"
+
+const char* op_kind_name(OpKind k) {
+    switch (k) {
+        case OP_OPENDIR: return "opendir";
+        case OP_READDIR: return "readdir";
+        case OP_STAT:    return "stat";
+        case OP_OPEN:    return "open";
+        case OP_READ:    return "read";
+        case OP_CLOSE:   return "close";
+        default:         return "?";
+    }
+}
+
+void lat_merge(LatHist* dst, const LatHist* src) {
+    if (src->count == 0) return;
+    dst->count += src->count;
+    dst->total_us += src->total_us;
+    if (src->max_us > dst->max_us) dst->max_us = src->max_us;
+    for (uint32_t i = 0; i < LAT_BUCKETS; i++) dst->b[i] += src->b[i];
+}
+
+/* Highest value that lands in bucket i. */
+static uint64_t lat_bucket_hi(uint32_t i) {
+    if (i < LAT_SUB) return i;
+    uint32_t shift = i / LAT_SUB - 1;
+    uint64_t lo = (uint64_t)(i % LAT_SUB + LAT_SUB) << shift;
+    return lo + ((1ull << shift) - 1);
+}
+
+static const double k_pcts[LAT_PCTS] = { 0.50, 0.90, 0.99, 0.999 };
+
+const char* lat_pct_name(int i) {
+    static const char* names[LAT_PCTS] = { "p50", "p90", "p99", "p99.9" };
+    return (i >= 0 && i < LAT_PCTS) ? names[i] : "?";
+}
+
+void lat_summarize(const LatHist* h, LatSummary* out) {
+    memset(out, 0, sizeof(*out));
+    out->count = h->count;
+    out->max_us = h->max_us;
+    if (h->count == 0) return;
+    out->mean_us = h->total_us / h->count;
+
+    uint64_t seen = 0;
+    uint32_t i = 0;
+    for (int p = 0; p < LAT_PCTS; p++) {
+        /* Rank of the percentile (1-based, rounded up). */
+        uint64_t rank = (uint64_t)(k_pcts[p] * (double)h->count + 0.999999);
+        if (rank < 1) rank = 1;
+        while (i < LAT_BUCKETS && seen + h->b[i] < rank) seen += h->b[i++];
+        uint64_t v = (i < LAT_BUCKETS) ? lat_bucket_hi(i) : h->max_us;
+        out->p_us[p] = (v < h->max_us) ? v : h->max_us;
+    }
+}
+
+void lat_format(char* out, size_t cap, uint64_t us) {
+    if (us < 1000) snprintf(out, cap, "%llu us", (unsigned long long)us);
+    else if (us < 1000000) snprintf(out, cap, "%.1f ms", (double)us / 1000.0);
+    else snprintf(out, cap, "%.2f s", (double)us / 1000000.0);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "app.h"
+
+/*
+ * Latency histograms of the engine's file-system operations, one per kind. Buckets are
+ * log-linear (HDR style): 8 sub-buckets per power of two of microseconds, so a value is off by
+ * at most 1/8 of itself, from 1 us to hours. Recording is a count-leading-zeros and an
+ * increment: no allocation, no lock (each histogram has one writer; threads merge at the end).
+ */
+typedef enum {
+    OP_OPENDIR = 0,
+    OP_READDIR,           /* one batch of entries */
+    OP_STAT,
+    OP_OPEN,
+    OP_READ,
+    OP_CLOSE,
+    OP_KIND_COUNT
+} OpKind;
+
+const char* op_kind_name(OpKind k);
+
+#define LAT_SUB_BITS 3
+#define LAT_SUB      (1u << LAT_SUB_BITS)
+#define LAT_BUCKETS  (LAT_SUB * 34u)      /* exact below 8 us, then up to 2^36 us (19 h) */
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint32_t b[LAT_BUCKETS];
+} LatHist;
+
+static inline void lat_record(LatHist* h, uint64_t us) {
+    uint32_t i;
+    if (us < LAT_SUB) {
+        i = (uint32_t)us;
+    } else {
+        uint32_t shift = (uint32_t)(63 - __builtin_clzll(us)) - LAT_SUB_BITS;
+        i = (shift + 1) * LAT_SUB + (uint32_t)(us >> shift) - LAT_SUB;
+        if (i >= LAT_BUCKETS) i = LAT_BUCKETS - 1;
+    }
+    h->b[i]++;
+    h->count++;
+    h->total_us += us;
+    if (us > h->max_us) h->max_us = us;
+}
+
+void lat_merge(LatHist* dst, const LatHist* src);
+
+/* Percentiles reported: p50, p90, p99, p99.9. */
+#define LAT_PCTS 4
+
+typedef struct {
+    uint64_t count;
+    uint64_t mean_us;
+    uint64_t p_us[LAT_PCTS];   /* highest value of the percentile's bucket, capped at max */
+    uint64_t max_us;
+} LatSummary;
+
+void lat_summarize(const LatHist* h, LatSummary* out);
+const char* lat_pct_name(int i);
+/* "850 us", "12.3 ms", "2.41 s" */
+void lat_format(char* out, size_t cap, uint64_t us);
@@ -1,17 +1,22 @@
 #include "log.h"
 
+#include <pthread.h>
+
 typedef struct {
     char lines[LOG_RING_MAX][256];
     int  count;
 } LogRing;
 
 static LogRing g_log;
+static pthread_mutex_t g_log_lock = PTHREAD_MUTEX_INITIALIZER;   /* Deep Check readers log too */
 static LogSaveStatus g_log_save = {0};
 static char g_log_context[64] = "Menu";
 static const char LOG_FILE_PATH[] = "sdmc:/sdcheck.log";
 
 void log_clear(void) {
+    pthread_mutex_lock(&g_log_lock);
     memset(&g_log, 0, sizeof(g_log));
+    pthread_mutex_unlock(&g_log_lock);
 }
 
 void log_save_status_set(bool ok, const char* note) {
@@ -55,9 +60,11 @@ void log_push(const char* level, const char* msg) {
     snprintf(line, sizeof(line), "[%02d:%02d:%02d] %s: %s",
              tmv.tm_hour, tmv.tm_min, tmv.tm_sec, level, msg);
 
+    pthread_mutex_lock(&g_log_lock);
     int idx = g_log.count % LOG_RING_MAX;
     snprintf(g_log.lines[idx], sizeof(g_log.lines[idx]), "%s", line);
     g_log.count++;
+    pthread_mutex_unlock(&g_log_lock);
 }
 
 void log_pushf(const char* level, const char* fmt, ...) {
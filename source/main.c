@@ -4,6 +4,10 @@
 #include "config.h"
 #include "sleep_guard.h"
 #include "scan_engine.h"
+#include "crc32.h"
+#include "hash.h"
+#include "scan_io.h"
+#include "manifest.h"
 
 /* --------------------------------------------------------------------------
    Sleep guard
@@ -123,6 +127,7 @@ static void ui_draw_header(const char* screen_title, const char* hint_lines) {
 static void ui_log(PadState* pad);
 static void ui_settings(PadState* pad);
 static void ui_help(PadState* pad);
+static void deep_run(PadState* pad, const char* deep_root, const ScanConfig* run_cfg, bool resume);
 
 static bool ui_confirm_cancel(PadState* pad, const char* what) {
 redraw:
@@ -255,15 +260,46 @@ static void log_write_header(FILE* f, const ScanConfig* cfg) {
             tmv.tm_year + 1900, tmv.tm_mon + 1, tmv.tm_mday,
             tmv.tm_hour, tmv.tm_min, tmv.tm_sec);
     fprintf(f, "Context: %s\n", log_get_context());
+    fprintf(f, "CRC32 kernel: %s\n", crc32_kernel_name());
 
     if (cfg) {
         fprintf(f, "Preset: %s\n", preset_name(cfg->preset));
-        fprintf(f, "Settings: Full read=%s, Large-file threshold=%llu MiB, Retries=%d, Consistency=%s, Chunk=%s\n",
+        fprintf(f, "Settings: Full read=%s, Large-file threshold=%llu MiB, Retries=%d, Consistency=%s, Chunk=%s, Pipeline=%d slots, Look-ahead=%d, Readers=%d, I/O=%s\n",
                 cfg->full_read ? "ON" : "OFF",
                 (unsigned long long)(cfg->large_file_limit / (1024ull * 1024ull)),
                 cfg->read_retries,
                 cfg->consistency_check ? "ON" : "OFF",
-                chunk_name(cfg->chunk_mode));
+                chunk_name(cfg->chunk_mode),
+                cfg->pipeline_slots,
+                cfg->lookahead_depth,
+                cfg->reader_threads,
+                io_backend_name(io_backend_select(cfg->io_backend)));
+        fprintf(f, "Sampling: %s, region=%d KiB, coverage=%.2f%%, budget=%d MiB/file (0 = none), seed=%llu\n",
+                sample_mode_name(cfg->sample_mode), cfg->sample_region_kib, cfg->sample_coverage_pct,
+                cfg->sample_budget_mib, (unsigned long long)cfg->sample_seed);
+        if (cfg->read_retries > 0)
+            fprintf(f, "Retry: %s, backoff=%d ms (doubled per attempt)\n", cfg->retry_defer ? "deferred" : "in place", cfg->retry_backoff_ms);
+        if (cfg->bisect_min_kib > 0) fprintf(f, "Bad-region bisection: %d KiB blocks\n", cfg->bisect_min_kib);
+        else fprintf(f, "Bad-region bisection: OFF\n");
+        if (cfg->read_deadline_s > 0) fprintf(f, "Read deadline: %d s\n", cfg->read_deadline_s);
+        else fprintf(f, "Read deadline: OFF\n");
+        if (cfg->stall_ms > 0) fprintf(f, "Stall watchdog: %d ms\n", cfg->stall_ms);
+        else fprintf(f, "Stall watchdog: OFF\n");
+        if (cfg->timeline_sec > 0) fprintf(f, "Timeline: every %d s (%s)\n", cfg->timeline_sec, TIMELINE_PATH);
+        else fprintf(f, "Timeline: OFF\n");
+        if (cfg->trace_mib > 0) fprintf(f, "Trace: %d MiB buffer (%s)\n", cfg->trace_mib, TRACE_PATH);
+        else fprintf(f, "Trace: OFF\n");
+        if (cfg->time_budget_min > 0) fprintf(f, "Time budget: %d min\n", cfg->time_budget_min);
+        else fprintf(f, "Time budget: OFF\n");
+        if (cfg->checkpoint_sec > 0) fprintf(f, "Checkpoint: every %d s (%s)\n", cfg->checkpoint_sec, SCAN_RESUME_PATH);
+        else fprintf(f, "Checkpoint: OFF\n");
+        if (cfg->manifest) fprintf(f, "Manifest: ON (%s), incremental=%s, stale after %d day(s)\n", MANIFEST_PATH,
+                                   cfg->incremental ? "ON" : "OFF", cfg->stale_days);
+        else fprintf(f, "Manifest: OFF\n");
+        if (cfg->hash_algo != HASH_CRC32)
+            fprintf(f, "Content hash: %s (%s, %.0f MiB/s); range reads OFF\n", hash_algo_name(cfg->hash_algo),
+                    hash_kernel_name(cfg->hash_algo), hash_kernel_mib_s(cfg->hash_algo));
+        else fprintf(f, "Content hash: OFF (CRC-32 only)\n");
         fprintf(f, "Filters: Skip known folders=%s, Skip media extensions=%s\n",
                 cfg->skip_known_folders ? "ON" : "OFF",
                 cfg->skip_media_exts ? "ON" : "OFF");
@@ -436,6 +472,38 @@ static void deep_ui_pause_modal(ScanStats* st, PadState* pad) {
     }
 }
 
+/* Live policy line of a time-budgeted run. */
+static void deep_ui_budget_line(int row, const ScanStats* st) {
+    if (st->budget_planning) {
+        ui_print_fit(row, 3, UI_INNER, C_YELLOW, "Time budget: planning (metadata pre-pass, %llu files so far)",
+                     (unsigned long long)st->files_total);
+        return;
+    }
+    int64_t left_s = st->budget_left_ms > 0 ? st->budget_left_ms / 1000 : 0;
+    const char* col = (st->budget_keep < 1.0) ? C_YELLOW : C_GRAY;
+    ui_print_fit(row, 3, UI_INNER, col, "Time budget: %lld:%02lld left  read share %.1f%%  files kept %.1f%%  re-plans %u",
+                 (long long)(left_s / 60), (long long)(left_s % 60),
+                 st->budget_frac * 100.0, st->budget_keep * 100.0, st->budget_solves);
+}
+
+/* Oldest operation the stall watchdog flagged that is still in flight, or a blank line. */
+static void deep_ui_stall_line(int row) {
+    StallLive lv;
+    if (!watchdog_live(&lv)) {
+        ui_print_fit(row, 3, UI_INNER, C_DIM, " ");
+        return;
+    }
+    char disp[64];
+    tail_ellipsize(disp, sizeof(disp), lv.path, 40);
+    char more[16] = "";
+    if (lv.stalled > 1) snprintf(more, sizeof(more), " (+%d)", lv.stalled - 1);
+    if (lv.kind == OP_READ)
+        ui_print_fit(row, 3, UI_INNER, C_RED, "STALL: %s %.1f s @ %llu (+%llu KiB)%s %s", op_kind_name(lv.kind), (double)lv.age_ms / 1000.0,
+                     (unsigned long long)lv.off, (unsigned long long)(lv.len / 1024), more, disp);
+    else
+        ui_print_fit(row, 3, UI_INNER, C_RED, "STALL: %s %.1f s%s %s", op_kind_name(lv.kind), (double)lv.age_ms / 1000.0, more, disp);
+}
+
 static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
     if (!st || !st->ui_active) return;
 
@@ -443,6 +511,7 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
     if (!appletMainLoop()) { st->cancelled = true; return; }
 
     if (pad && (now - st->input_last_ms) >= 40) {
+        uint64_t t0 = now_us();
         padUpdate(pad);
         uint64_t down = padGetButtonsDown(pad);
         uint64_t held = padGetButtons(pad);
@@ -505,6 +574,9 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
         }
 
         st->input_last_ms = now;
+        uint64_t t1 = now_us();
+        st->pad_us += t1 - t0;
+        trace_span(TRACE_PAD, t0, t1, NULL, 0, 0);
     }
 
     if (st->paused) {
@@ -514,6 +586,7 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
 
     if (!force && st->ui_last_ms && (now - st->ui_last_ms) < 250) return;
 
+    uint64_t t0 = now_us();
     if (!st->ui_drawn) {
         deep_ui_draw_frame(false);
         st->ui_drawn = true;
@@ -573,20 +646,25 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
                      (unsigned long long)st->dirs_total,
                      (unsigned long long)st->files_read,
                      (unsigned long long)st->files_total);
-        const char* vcol = (st->read_errors || st->consistency_errors) ? C_RED : ((st->open_errors || st->stat_errors || st->path_errors) ? C_YELLOW : C_GREEN);
+        const char* vcol = (st->read_errors || st->read_timeouts || st->consistency_errors) ? C_RED : ((st->open_errors || st->stat_errors || st->path_errors) ? C_YELLOW : C_GREEN);
         ui_print_fit(sy + 3, 3, UI_INNER, vcol, "Errors: read=%llu  open=%llu  stat=%llu  path=%llu  consistency=%llu",
                      (unsigned long long)st->read_errors,
                      (unsigned long long)st->open_errors,
                      (unsigned long long)st->stat_errors,
                      (unsigned long long)st->path_errors,
                      (unsigned long long)st->consistency_errors);
-        ui_print_fit(sy + 4, 3, UI_INNER, C_GRAY,  "Transient read errors (recovered): %llu", (unsigned long long)st->read_errors_transient);
+        if (st->read_timeouts)
+            ui_print_fit(sy + 4, 3, UI_INNER, C_RED, "Transient read errors (recovered): %llu  Timed out: %llu (%d hanging)",
+                         (unsigned long long)st->read_errors_transient, (unsigned long long)st->read_timeouts, io_reads_hanging());
+        else
+            ui_print_fit(sy + 4, 3, UI_INNER, C_GRAY,  "Transient read errors (recovered): %llu", (unsigned long long)st->read_errors_transient);
         ui_print_fit(sy + 5, 3, UI_INNER, C_GRAY,  "Skipped: %llu dirs, %llu files", (unsigned long long)st->skipped_dirs, (unsigned long long)st->skipped_files);
-        ui_print_fit(sy + 6, 3, UI_INNER, C_GRAY,  "Policy: full=%s  threshold=%llu MiB  retries=%d  consistency=%s",
-                     st->run_full_read ? "ON" : "OFF",
-                     (unsigned long long)(st->run_large_limit / (1024ull*1024ull)),
-                     st->run_retries,
-                     st->run_consistency ? "ON" : "OFF");
+        if (st->budget_on) deep_ui_budget_line(sy + 6, st);
+        else ui_print_fit(sy + 6, 3, UI_INNER, C_GRAY,  "Policy: full=%s  threshold=%llu MiB  retries=%d  consistency=%s",
+                          st->run_full_read ? "ON" : "OFF",
+                          (unsigned long long)(st->run_large_limit / (1024ull*1024ull)),
+                          st->run_retries,
+                          st->run_consistency ? "ON" : "OFF");
 
         int fy = UI_CONTENT_Y + 8 + 1;
         ui_print_fit(fy + 0, 3, UI_INNER, C_WHITE, "File: %-72s", path_disp);
@@ -596,7 +674,7 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
         format_bytes(pl, sizeof(pl), planned);
         ui_print_fit(fy + 2, 3, UI_INNER, C_WHITE, "Read : %-12s / %-12s  (%3d%%)", rd, pl, pct);
         ui_print_fit(fy + 3, 3, UI_INNER, C_WHITE, "[%-40s]", bar);
-        ui_print_fit(fy + 4, 3, UI_INNER, C_DIM,   " ");
+        deep_ui_stall_line(fy + 4);
 
         int ey = UI_CONTENT_Y + 16 + 2;
         int shown = st->err_ring_count;
@@ -622,19 +700,21 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
                      (unsigned long long)st->dirs_total,
                      (unsigned long long)st->files_read,
                      (unsigned long long)st->files_total);
-        const char* err_col = (st->read_errors || st->consistency_errors) ? C_RED : ((st->open_errors || st->stat_errors || st->path_errors) ? C_YELLOW : C_GREEN);
-        ui_print_fit(sy + 3, 3, UI_INNER, err_col, "Errors: read=%llu (transient %llu)  open=%llu  stat=%llu  path=%llu  consistency=%llu",
+        const char* err_col = (st->read_errors || st->read_timeouts || st->consistency_errors) ? C_RED : ((st->open_errors || st->stat_errors || st->path_errors) ? C_YELLOW : C_GREEN);
+        ui_print_fit(sy + 3, 3, UI_INNER, err_col, "Errors: read=%llu (transient %llu, timed out %llu)  open=%llu  stat=%llu  path=%llu  consistency=%llu",
                      (unsigned long long)st->read_errors,
                      (unsigned long long)st->read_errors_transient,
+                     (unsigned long long)st->read_timeouts,
                      (unsigned long long)st->open_errors,
                      (unsigned long long)st->stat_errors,
                      (unsigned long long)st->path_errors,
                      (unsigned long long)st->consistency_errors);
-        ui_print_fit(sy + 4, 3, UI_INNER, C_GRAY,  "Policy: full=%s  threshold=%llu MiB  retries=%d  consistency=%s",
-                     st->run_full_read ? "ON" : "OFF",
-                     (unsigned long long)(st->run_large_limit / (1024ull*1024ull)),
-                     st->run_retries,
-                     st->run_consistency ? "ON" : "OFF");
+        if (st->budget_on) deep_ui_budget_line(sy + 4, st);
+        else ui_print_fit(sy + 4, 3, UI_INNER, C_GRAY,  "Policy: full=%s  threshold=%llu MiB  retries=%d  consistency=%s",
+                          st->run_full_read ? "ON" : "OFF",
+                          (unsigned long long)(st->run_large_limit / (1024ull*1024ull)),
+                          st->run_retries,
+                          st->run_consistency ? "ON" : "OFF");
 
         int fy = UI_CONTENT_Y + 7 + 1;
         ui_print_fit(fy + 0, 3, UI_INNER, C_WHITE, "File: %-72s", path_disp);
@@ -644,7 +724,7 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
         format_bytes(pl, sizeof(pl), planned);
         ui_print_fit(fy + 2, 3, UI_INNER, C_WHITE, "Read : %-12s / %-12s   (%3d%%)", rd, pl, pct);
         ui_print_fit(fy + 3, 3, UI_INNER, C_WHITE, "[%-40s]", bar);
-        ui_print_fit(fy + 4, 3, UI_INNER, C_DIM, " ");
+        deep_ui_stall_line(fy + 4);
 
         int sysy = UI_CONTENT_Y + 14 + 1;
         const char* sleep_col = C_YELLOW;
@@ -686,6 +766,9 @@ static void deep_ui_maybe_update(ScanStats* st, PadState* pad, bool force) {
 
     st->ui_last_ms = now;
     consoleUpdate(NULL);
+    uint64_t t1 = now_us();
+    st->ui_us += t1 - t0;
+    trace_span(TRACE_UI, t0, t1, NULL, 0, 0);
 }
 
 /* --------------------------------------------------------------------------
@@ -726,10 +809,13 @@ typedef struct {
 
     uint64_t bytes_read;
     double seconds;
+    uint32_t resumes;          /* Deep Check: times the scan was resumed */
+    double prior_seconds;      /* ... and its scan time before this session */
 
     uint64_t open_errors;
     uint64_t read_errors;
     uint64_t read_errors_transient;
+    uint64_t read_timeouts;    /* reads given up at the deadline */
     uint64_t stat_errors;
     uint64_t path_errors;
     uint64_t consistency_errors;
@@ -737,6 +823,79 @@ typedef struct {
     uint64_t skipped_dirs;
     uint64_t skipped_files;
 
+    uint64_t stats_avoided;
+    uint64_t stats_performed;
+    uint64_t dir_enum_dirs;
+    uint64_t dir_enum_entries;
+    uint64_t dir_enum_us;
+    uint64_t read_io_us;
+    uint64_t walk_wait_us;
+    uint64_t ranged_files;
+    HashAlgo hash_algo;
+    uint64_t hash_bytes;
+    uint64_t hash_us;
+    uint64_t hash_wait_us;
+    uint64_t sample_files;
+    uint64_t sample_regions;
+    uint64_t sample_bytes;
+    uint64_t sample_span_bytes;
+    uint64_t sample_seed;
+    uint64_t bytes_total;      /* size of the files in scope */
+    bool     budget_on;
+    double   budget_frac;
+    double   budget_keep;
+    int64_t  budget_left_ms;
+    uint32_t budget_solves;
+    uint64_t budget_pre_files;
+    uint64_t budget_pre_bytes;
+    uint64_t budget_pre_ms;
+    uint64_t budget_full;
+    uint64_t budget_sampled;
+    uint64_t budget_skipped;
+    uint64_t budget_skipped_bytes;
+    double   budget_share_min;
+    double   budget_share_sum;
+    bool     manifest_on;
+    bool     incremental_on;
+    bool     manifest_write_ok;
+    uint32_t timeline_samples;  /* 0: no timeline this run */
+    uint32_t timeline_interval_s;
+    bool     timeline_write_ok;
+    uint64_t trace_events;      /* 0: no trace this run */
+    uint64_t trace_dropped;
+    bool     trace_write_ok;
+    uint64_t manifest_loaded;
+    uint64_t manifest_written;
+    uint64_t manifest_new;
+    uint64_t manifest_changed;
+    uint64_t manifest_stale;
+    uint64_t manifest_unchanged;
+    uint64_t manifest_unchanged_bytes;
+    uint64_t bitrot_checked;
+    uint64_t bitrot_files;
+    uint64_t bitrot_bytes;
+    BitrotEntry bitrot[BITROT_MAX];
+    int      bitrot_count;
+    uint64_t bad_files;
+    uint64_t bad_extents;
+    uint64_t bad_bytes;
+    uint64_t bisect_reads;
+    uint64_t bisect_bytes;
+    uint64_t bisect_recovered;
+    BadFileEntry bad[BADFILE_MAX];
+    int      bad_count;
+    uint64_t retry_deferred;
+    uint64_t retry_recovered;
+    uint32_t tune_chunk;       /* chunk auto-tuner choice (0 = fixed chunk) */
+    uint32_t tune_rounds;
+    double   tune_mib_s[TUNE_SIZES];
+    uint64_t tune_bytes[TUNE_SIZES];
+    int      lookahead;        /* effective look-ahead depth (0 = serial walk) */
+    int      readers;          /* reader threads that ran */
+    uint64_t worker_files[READERS_MAX];
+    uint64_t worker_bytes[READERS_MAX];
+    uint64_t worker_busy_us[READERS_MAX];
+
     /* quick specific */
     bool sd_accessible;
     bool space_ok;
@@ -760,6 +919,9 @@ typedef struct {
     uint64_t perf_hist[5];
     uint64_t perf_stalls;
     uint64_t perf_stall_total_ms;
+    StallStats stalls;
+    LatSummary lat[OP_KIND_COUNT];
+    uint64_t phase_us[PHASE_COUNT];
     uint64_t perf_longest_ms;
     double   perf_longest_mib_s;
     uint64_t perf_longest_off;
@@ -777,11 +939,15 @@ typedef struct {
     /* deep details */
     LargestEntry largest[LARGEST_MAX];
     int largest_count;
+    SlowList slow_rate;      /* sorted, slowest first */
+    SlowList slow_time;
+    SlowList slow_dirs;
 
     char fail_paths[FAIL_MAX][256];
     int fail_count;
 
     ScanConfig effective_cfg;
+    char io_backend[16];   /* Deep Check: backend that produced the numbers */
 } RunResult;
 
 static void runresult_clear(RunResult* r) {
@@ -792,7 +958,7 @@ static void runresult_clear(RunResult* r) {
 static Verdict compute_verdict(const RunResult* r) {
     if (!r || !r->ran) return VERDICT_WARNINGS;
     if (r->cancelled) return VERDICT_CANCELLED;
-    if (r->read_errors > 0 || r->consistency_errors > 0) return VERDICT_FAILED;
+    if (r->read_errors > 0 || r->read_timeouts > 0 || r->consistency_errors > 0 || r->bitrot_files > 0) return VERDICT_FAILED;
     if (r->write_test_enabled && !r->write_test_ok) return VERDICT_FAILED;
 
     bool any_warn = false;
@@ -813,6 +979,20 @@ static void build_next_steps(const RunResult* r, char out[4][96]) {
         return;
     }
 
+    if (r->bitrot_files > 0) {
+        snprintf(out[0], 96, "- Files changed without being written (bit-rot). See Summary page 6.");
+        snprintf(out[1], 96, "- Restore them from a backup and back up the rest of the card now.");
+        snprintf(out[2], 96, "- Replace the card: silent corruption tends to spread.");
+        return;
+    }
+
+    if (r->read_timeouts > 0 && r->read_errors == 0 && r->consistency_errors == 0) {
+        snprintf(out[0], 96, "- Reads hung past the deadline; those files were skipped (see log).");
+        snprintf(out[1], 96, "- Back up important data now: hangs usually precede read errors.");
+        snprintf(out[2], 96, "- Test the SD on a PC (full surface read). Replace if hangs repeat.");
+        return;
+    }
+
     if (r->read_errors > 0 || r->consistency_errors > 0) {
         snprintf(out[0], 96, "- Back up important data immediately.");
         snprintf(out[1], 96, "- Test the SD on a PC (full surface read). Replace if errors repeat.");
@@ -864,18 +1044,20 @@ static void ui_results_draw(const char* title, const RunResult* r) {
 
     if (r) {
         ui_print_fit(UI_CONTENT_Y + 5, 3, UI_INNER, (v==VERDICT_FAILED)?C_RED:((v==VERDICT_WARNINGS)?C_YELLOW:C_GREEN),
-                     "Errors: read=%llu (transient %llu)  open=%llu  stat=%llu  path=%llu  consistency=%llu",
+                     "Errors: read=%llu (transient %llu, timed out %llu)  open=%llu  stat=%llu  path=%llu  consistency=%llu",
                      (unsigned long long)r->read_errors,
                      (unsigned long long)r->read_errors_transient,
+                     (unsigned long long)r->read_timeouts,
                      (unsigned long long)r->open_errors,
                      (unsigned long long)r->stat_errors,
                      (unsigned long long)r->path_errors,
                      (unsigned long long)r->consistency_errors);
         ui_print_fit(UI_CONTENT_Y + 6, 3, UI_INNER, C_GRAY,
-                     "Skipped: %llu dirs, %llu files    Preset: %s",
+                     "Skipped: %llu dirs, %llu files    Preset: %s%s%s",
                      (unsigned long long)r->skipped_dirs,
                      (unsigned long long)r->skipped_files,
-                     preset_name(r->effective_cfg.preset));
+                     preset_name(r->effective_cfg.preset),
+                     r->io_backend[0] ? "    I/O: " : "", r->io_backend);
     }
 
     ui_draw_box(1, 17, UI_W, 12, "Details / Next steps", C_CYAN);
@@ -907,6 +1089,13 @@ static void ui_results_draw(const char* title, const RunResult* r) {
     } else {
         ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Log file: sdmc:/sdcheck.log (not saved)");
     }
+    if (r && r->timeline_samples > 0)
+        ui_print_fit(row++, 3, UI_INNER, r->timeline_write_ok ? C_GREEN : C_YELLOW, "Timeline: %s (%u x %u s, %s)",
+                     TIMELINE_PATH, r->timeline_samples, r->timeline_interval_s, r->timeline_write_ok ? "saved" : "save failed");
+    if (r && r->trace_events > 0)
+        ui_print_fit(row++, 3, UI_INNER, (r->trace_write_ok && !r->trace_dropped) ? C_GREEN : C_YELLOW,
+                     "Trace: %s (%llu events%s, %s)", TRACE_PATH, (unsigned long long)r->trace_events,
+                     r->trace_dropped ? ", buffer full" : "", r->trace_write_ok ? "saved" : "save failed");
 
     if (r) {
         char steps[4][96];
@@ -920,15 +1109,17 @@ static void ui_results_draw(const char* title, const RunResult* r) {
 }
 
 
+#define SUMMARY_PAGES 10
+
 static void ui_summary_draw(const RunResult* r, int page) {
     if (page < 0) page = 0;
-    if (page > 1) page = 1;
+    if (page > SUMMARY_PAGES - 1) page = SUMMARY_PAGES - 1;
 
     char hint[256];
     snprintf(hint, sizeof(hint),
-             "B/+ : Back    Y: Log    L/R: Page (%d/2)\n"
+             "B/+ : Back    Y: Log    L/R: Page (%d/%d)\n"
              "ZL: Help\n"
-             " ", page + 1);
+             " ", page + 1, SUMMARY_PAGES);
 
     ui_draw_header("Summary", hint);
     /* Page 1: Run + Performance + First failure */
@@ -945,7 +1136,14 @@ static void ui_summary_draw(const RunResult* r, int page) {
                          (unsigned long long)r->dirs_total,
                          (unsigned long long)r->files_read,
                          (unsigned long long)r->files_total);
-            ui_print_fit(UI_CONTENT_Y + 4, 3, UI_INNER, C_WHITE, "Read: %-12s   Time: %.1f s", br, r->seconds);
+            char tm[48];
+            if (r->resumes > 0) snprintf(tm, sizeof(tm), "%.1f s (+%.1f s before resume)", r->seconds, r->prior_seconds);
+            else snprintf(tm, sizeof(tm), "%.1f s", r->seconds);
+            if (r->bytes_total > 0)
+                ui_print_fit(UI_CONTENT_Y + 4, 3, UI_INNER, C_WHITE, "Read: %-12s   Time: %s   Verified: %.1f%% of the bytes in scope",
+                             br, tm, 100.0 * (double)r->bytes_read / (double)r->bytes_total);
+            else
+                ui_print_fit(UI_CONTENT_Y + 4, 3, UI_INNER, C_WHITE, "Read: %-12s   Time: %s", br, tm);
             ui_print_fit(UI_CONTENT_Y + 5, 3, UI_INNER, C_WHITE, "Preset: %-9s   Full read: %-3s   Threshold: %llu MiB",
                          preset_name(r->effective_cfg.preset), onoff(r->effective_cfg.full_read),
                          (unsigned long long)(r->effective_cfg.large_file_limit/(1024ull*1024ull)));
@@ -958,10 +1156,11 @@ static void ui_summary_draw(const RunResult* r, int page) {
         int row = UI_CONTENT_Y + 10;
         if (r && r->perf_ops > 0 && r->seconds > 0.0) {
             double avg = ((double)r->perf_bytes / 1048576.0) / r->seconds;
-            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Avg throughput: %.2f MiB/s   Ops: %llu   Bytes: %.2f MiB",
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Avg throughput: %.2f MiB/s   Ops: %llu   Bytes: %.2f MiB   I/O: %s",
                          avg,
                          (unsigned long long)r->perf_ops,
-                         (double)r->perf_bytes / 1048576.0);
+                         (double)r->perf_bytes / 1048576.0,
+                         r->io_backend[0] ? r->io_backend : "-");
 
             ui_print_fit(row++, 3, UI_INNER, C_WHITE,
                          "Buckets (ops): >=60:%llu  30-60:%llu  10-30:%llu  1-10:%llu  <1:%llu",
@@ -981,6 +1180,14 @@ static void ui_summary_draw(const RunResult* r, int page) {
             char disp[80];
             tail_ellipsize(disp, sizeof(disp), r->perf_longest_path[0] ? r->perf_longest_path : "(unknown)", 72);
             ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Longest path: %s", disp);
+            if (r->effective_cfg.stall_ms > 0) {
+                const StallStats* sl = &r->stalls;
+                ui_print_fit(row++, 3, UI_INNER, sl->count ? C_YELLOW : C_GREEN,
+                             "Watchdog: %llu op(s) >= %d ms  <1s:%llu 1-2s:%llu 2-5s:%llu 5-10s:%llu 10-30s:%llu >=30s:%llu",
+                             (unsigned long long)sl->count, r->effective_cfg.stall_ms,
+                             (unsigned long long)sl->hist[0], (unsigned long long)sl->hist[1], (unsigned long long)sl->hist[2],
+                             (unsigned long long)sl->hist[3], (unsigned long long)sl->hist[4], (unsigned long long)sl->hist[5]);
+            }
         } else {
             ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No performance data. Quick Check does not collect per-op read speeds.)");
         }
@@ -1005,6 +1212,382 @@ static void ui_summary_draw(const RunResult* r, int page) {
         return;
     }
 
+    /* Page 3: Traversal (enumeration, metadata, time split) */
+    if (page == 2) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 8, "Traversal", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        if (r && r->dir_enum_dirs > 0) {
+            double enum_ms = (double)r->dir_enum_us / 1000.0;
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Directories listed: %llu   Entries: %llu   Skipped dirs: %llu",
+                         (unsigned long long)r->dir_enum_dirs,
+                         (unsigned long long)r->dir_enum_entries,
+                         (unsigned long long)r->skipped_dirs);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Enumeration: %.1f ms   %.1f us/dir   %.2f us/entry",
+                         enum_ms,
+                         (double)r->dir_enum_us / (double)r->dir_enum_dirs,
+                         r->dir_enum_entries ? (double)r->dir_enum_us / (double)r->dir_enum_entries : 0.0);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Metadata: stat() calls %llu   avoided %llu (from directory reads)",
+                         (unsigned long long)r->stats_performed,
+                         (unsigned long long)r->stats_avoided);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "I/O backend: %s", r->io_backend[0] ? r->io_backend : "-");
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No traversal data. Quick Check does not enumerate files.)");
+        }
+
+        ui_draw_box(1, UI_CONTENT_Y + 8, UI_W, 6, "Time split", C_CYAN);
+        row = UI_CONTENT_Y + 10;
+        if (r && r->dir_enum_dirs > 0) {
+            double total_ms = r->seconds * 1000.0;
+            double enum_ms = (double)r->dir_enum_us / 1000.0;
+            double read_ms = (double)r->read_io_us / 1000.0;
+            if (r->lookahead > 0) {
+                /* Listing overlaps reads; only the time the reader sat idle counts against it. */
+                double wait_ms = (double)r->walk_wait_us / 1000.0;
+                double other_ms = total_ms - wait_ms - read_ms;
+                if (other_ms < 0.0) other_ms = 0.0;
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "File reads: %.1f ms   Waiting for walker: %.1f ms   Other: %.1f ms",
+                             read_ms, wait_ms, other_ms);
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Look-ahead %d: listing (%.1f ms) ran alongside reads.",
+                             r->lookahead, enum_ms);
+            } else {
+                double other_ms = total_ms - enum_ms - read_ms;
+                if (other_ms < 0.0) other_ms = 0.0;
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Directory listing: %.1f ms   File reads: %.1f ms   Other: %.1f ms",
+                             enum_ms, read_ms, other_ms);
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Other = open/stat, hashing wait, UI and pauses.");
+            }
+            if (r->ranged_files > 0)
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Range reads: %llu large file(s) read as parallel ranges.",
+                             (unsigned long long)r->ranged_files);
+        }
+
+        ui_draw_box(1, UI_CONTENT_Y + 14, UI_W, 7, "Readers", C_CYAN);
+        row = UI_CONTENT_Y + 16;
+        if (r && r->readers > 0 && r->seconds > 0.0) {
+            for (int i = 0; i < r->readers && i < READERS_MAX; i++) {
+                double mib = (double)r->worker_bytes[i] / 1048576.0;
+                double busy = 100.0 * ((double)r->worker_busy_us[i] / 1000000.0) / r->seconds;
+                if (busy > 100.0) busy = 100.0;
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Reader %d: %-8llu files   %10.1f MiB   %8.2f MiB/s   busy %3.0f%%",
+                             i + 1, (unsigned long long)r->worker_files[i], mib, mib / r->seconds, busy);
+            }
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No reader data.)");
+        }
+        return;
+    }
+
+    /* Page 4: Read strategy (chunk tuner probe table, sampling) */
+    if (page == 3) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 14, "Chunk size", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        if (r && r->tune_chunk) {
+            double top = 0.0;
+            for (int i = 0; i < TUNE_SIZES; i++) {
+                if (r->tune_mib_s[i] > top) top = r->tune_mib_s[i];
+            }
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Auto-tuner: %u KiB chosen   Probe rounds: %u%s",
+                         r->tune_chunk / 1024u, r->tune_rounds, r->tune_rounds ? "" : " (first round not finished)");
+            row++;
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "    Size       MiB/s    MiB read");
+            for (int i = 0; i < TUNE_SIZES; i++) {
+                unsigned kib = 64u << i;
+                char bar[32];
+                int n = (top > 0.0) ? (int)(r->tune_mib_s[i] / top * 30.0 + 0.5) : 0;
+                if (n > 30) n = 30;
+                memset(bar, '#', (size_t)n);
+                bar[n] = '\0';
+                bool chosen = (kib * 1024u == r->tune_chunk);
+                if (r->tune_mib_s[i] > 0.0) {
+                    ui_print_fit(row++, 3, UI_INNER, chosen ? C_GREEN : C_WHITE, "%s %5u KiB  %8.2f  %10.1f  %s",
+                                 chosen ? ">" : " ", kib, r->tune_mib_s[i], (double)r->tune_bytes[i] / 1048576.0, bar);
+                } else {
+                    ui_print_fit(row++, 3, UI_INNER, C_GRAY, "%s %5u KiB         -  %10.1f", chosen ? ">" : " ", kib,
+                                 (double)r->tune_bytes[i] / 1048576.0);
+                }
+            }
+        } else if (r && r->effective_cfg.chunk_mode != CHUNK_AUTO) {
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Fixed chunk: %s", chunk_name(r->effective_cfg.chunk_mode));
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Set Chunk size to Auto to let the tuner probe 64 KiB .. 8 MiB.");
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No full reads were timed.)");
+        }
+        ui_draw_box(1, UI_CONTENT_Y + 14, UI_W, 7, "Sampling (large files)", C_CYAN);
+        row = UI_CONTENT_Y + 16;
+        if (r) {
+            char budget[24];
+            if (r->effective_cfg.sample_budget_mib > 0) snprintf(budget, sizeof(budget), "%d MiB", r->effective_cfg.sample_budget_mib);
+            else snprintf(budget, sizeof(budget), "none");
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Mode: %s   Region: %d KiB   Coverage target: %.2f%%   Budget/file: %s",
+                         sample_mode_name(r->effective_cfg.sample_mode), r->effective_cfg.sample_region_kib,
+                         r->effective_cfg.sample_coverage_pct, budget);
+        }
+        if (r && r->sample_files > 0) {
+            char rd[32], span[32];
+            format_bytes(rd, sizeof(rd), r->sample_bytes);
+            format_bytes(span, sizeof(span), r->sample_span_bytes);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Files: %llu   Regions: %llu   Read: %s of %s (%.3f%%)",
+                         (unsigned long long)r->sample_files, (unsigned long long)r->sample_regions, rd, span,
+                         r->sample_span_bytes ? 100.0 * (double)r->sample_bytes / (double)r->sample_span_bytes : 0.0);
+            if (r->sample_seed)
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Seed: %llu (sample_seed=%llu repeats these regions)",
+                             (unsigned long long)r->sample_seed, (unsigned long long)r->sample_seed);
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No files were sampled: full read, or none above the threshold.)");
+        }
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: MiB/s is per read request (card time only), so sizes compare fairly.");
+        return;
+    }
+
+    /* Page 5: Time budget + Manifest */
+    if (page == 4) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 10, "Time budget", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        if (r && r->budget_on) {
+            char pre[32], skb[32];
+            format_bytes(pre, sizeof(pre), r->budget_pre_bytes);
+            format_bytes(skb, sizeof(skb), r->budget_skipped_bytes);
+            double left = (double)r->budget_left_ms / 1000.0;
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Budget: %d min   %s: %.1f s",
+                         r->effective_cfg.time_budget_min, left >= 0.0 ? "Left" : "Over", left >= 0.0 ? left : -left);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Pre-pass: %llu files, %s listed in %.1f s",
+                         (unsigned long long)r->budget_pre_files, pre, (double)r->budget_pre_ms / 1000.0);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Files: full %llu   sampled %llu   skipped %llu (%s)",
+                         (unsigned long long)r->budget_full, (unsigned long long)r->budget_sampled,
+                         (unsigned long long)r->budget_skipped, skb);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Final policy: read share %.2f%%   files kept %.1f%%   Re-plans: %u",
+                         r->budget_frac * 100.0, r->budget_keep * 100.0, r->budget_solves);
+            uint64_t kept = r->budget_full + r->budget_sampled;
+            if (kept > 0)
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Per file read: mean %.1f%% of its bytes   lowest %.2f%%",
+                             100.0 * r->budget_share_sum / (double)kept, r->budget_share_min * 100.0);
+            if (r->bytes_total > 0)
+                ui_print_fit(row++, 3, UI_INNER, C_GREEN, "Verified: %.2f%% of the bytes in scope",
+                             100.0 * (double)r->bytes_read / (double)r->bytes_total);
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No time budget. Set one with Up/Down on the Deep Check screen.)");
+        }
+
+        ui_draw_box(1, UI_CONTENT_Y + 10, UI_W, 7, "Manifest", C_CYAN);
+        row = UI_CONTENT_Y + 12;
+        if (r && r->manifest_on) {
+            char ub[32];
+            format_bytes(ub, sizeof(ub), r->manifest_unchanged_bytes);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Files: new %llu   changed %llu   stale %llu   unchanged %llu (%s)",
+                         (unsigned long long)r->manifest_new, (unsigned long long)r->manifest_changed,
+                         (unsigned long long)r->manifest_stale, (unsigned long long)r->manifest_unchanged, ub);
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Mode: %s   Entries: %llu loaded, %llu written",
+                         r->incremental_on ? "incremental (unchanged files not read)" : "full",
+                         (unsigned long long)r->manifest_loaded, (unsigned long long)r->manifest_written);
+            if (!r->manifest_write_ok)
+                ui_print_fit(row++, 3, UI_INNER, C_YELLOW, "The manifest could not be saved; see the log.");
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(Manifest OFF.)");
+        }
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: Run again without a budget to read everything the budget sampled or skipped.");
+        return;
+    }
+
+    /* Page 6: Bit-rot + Content hash */
+    if (page == 5) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 15, "Bit-rot", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        if (r && r->manifest_on) {
+            char bb[32];
+            format_bytes(bb, sizeof(bb), r->bitrot_bytes);
+            ui_print_fit(row++, 3, UI_INNER, r->bitrot_files ? C_RED : C_GREEN,
+                         "Changed without a write: %llu (%s)   Checked against the manifest: %llu file(s)",
+                         (unsigned long long)r->bitrot_files, bb, (unsigned long long)r->bitrot_checked);
+            for (int i = 0; i < r->bitrot_count && i < BITROT_MAX; i++) {
+                const BitrotEntry* b = &r->bitrot[i];
+                char disp[80], when[16] = "?";
+                time_t t = (time_t)b->verified_at;
+                struct tm tmv;
+                if (localtime_r(&t, &tmv)) strftime(when, sizeof(when), "%Y-%m-%d", &tmv);
+                tail_ellipsize(disp, sizeof(disp), b->path, 72);
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%s", disp);
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "  CRC %08X, was %08X on %s", (unsigned int)b->crc, (unsigned int)b->recorded, when);
+            }
+            if (r->bitrot_files > (uint64_t)r->bitrot_count)
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(+%llu more in the log)",
+                             (unsigned long long)(r->bitrot_files - (uint64_t)r->bitrot_count));
+            if (r->bitrot_checked == 0)
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No file had a CRC from an earlier Deep Check with the same size and time.)");
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(Manifest OFF: no CRC baseline to compare against.)");
+        }
+
+        ui_draw_box(1, UI_CONTENT_Y + 15, UI_W, 6, "Content hash", C_CYAN);
+        row = UI_CONTENT_Y + 17;
+        if (r) {
+            double hash_mib_s = r->hash_us ? ((double)r->hash_bytes / 1048576.0) / ((double)r->hash_us / 1e6) : 0.0;
+            double read_mib_s = r->read_io_us ? ((double)r->bytes_read / 1048576.0) / ((double)r->read_io_us / 1e6) : 0.0;
+            if (r->hash_algo != HASH_CRC32)
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Algorithm: %s + CRC-32 (%s, %.0f MiB/s at startup); range reads OFF",
+                             hash_algo_name(r->hash_algo), hash_kernel_name(r->hash_algo), hash_kernel_mib_s(r->hash_algo));
+            else
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Algorithm: CRC-32 only (hash_algo=0)");
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Hasher: %.0f MiB/s   Card: %.1f MiB/s   Readers waited on the hasher: %llu ms",
+                         hash_mib_s, read_mib_s, (unsigned long long)(r->hash_wait_us / 1000));
+            /* Waiting for more than a tenth of the read time: the hasher, not the card, sets the pace. */
+            bool slow = r->read_io_us > 0 && r->hash_wait_us * 10 > r->read_io_us;
+            ui_print_fit(row++, 3, UI_INNER, slow ? C_YELLOW : C_GRAY, "%s",
+                         slow ? "The hasher was slower than the card: a faster algorithm shortens the scan."
+                              : "The hasher kept up with the card.");
+        }
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: Only files read in full are compared; incremental scans re-check them after stale_days.");
+        return;
+    }
+
+    /* Page 7: Bad regions + Retry queue */
+    if (page == 6) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 15, "Bad regions", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        if (r && r->effective_cfg.bisect_min_kib > 0) {
+            char bb[32];
+            format_bytes(bb, sizeof(bb), r->bad_bytes);
+            ui_print_fit(row++, 3, UI_INNER, r->bad_files ? C_RED : C_GREEN,
+                         "Unreadable: %s in %llu extent(s) of %llu file(s)   Blocks: %d KiB",
+                         bb, (unsigned long long)r->bad_extents, (unsigned long long)r->bad_files, r->effective_cfg.bisect_min_kib);
+            if (r->bisect_reads > 0)
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Located with %llu reads (%.1f MiB); the rest of each file was read on.",
+                             (unsigned long long)r->bisect_reads, (double)r->bisect_bytes / 1048576.0);
+            if (r->bisect_recovered > 0)
+                ui_print_fit(row++, 3, UI_INNER, C_YELLOW, "Read fine when confirmed block by block: %llu KiB",
+                             (unsigned long long)(r->bisect_recovered / 1024));
+            int shown = 0;
+            for (int i = 0; i < r->bad_count && i < BADFILE_MAX && row + 1 < UI_CONTENT_Y + 14; i++, shown++) {
+                const BadFileEntry* b = &r->bad[i];
+                char disp[80], ext[96];
+                tail_ellipsize(disp, sizeof(disp), b->path, 72);
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%s", disp);
+                int n = snprintf(ext, sizeof(ext), " ");
+                for (uint32_t k = 0; k < b->shown && n < (int)sizeof(ext); k++)
+                    n += snprintf(ext + n, sizeof(ext) - (size_t)n, " @%llu+%lluK", (unsigned long long)b->ext[k].off,
+                                  (unsigned long long)(b->ext[k].len / 1024));
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "%s%s", ext, b->extents > b->shown ? " ..." : "");
+            }
+            if (r->bad_files > (uint64_t)shown && row < UI_CONTENT_Y + 14)
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(+%llu more in the log)",
+                             (unsigned long long)(r->bad_files - (uint64_t)shown));
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(Bisection OFF: a failed read is reported at chunk size and ends the file.)");
+        }
+
+        ui_draw_box(1, UI_CONTENT_Y + 15, UI_W, 6, "Retry queue", C_CYAN);
+        row = UI_CONTENT_Y + 17;
+        if (r && r->retry_deferred > 0)
+            ui_print_fit(row++, 3, UI_INNER, C_WHITE, "Deferred: %llu region(s)   Read back: %llu   Failed: %llu",
+                         (unsigned long long)r->retry_deferred, (unsigned long long)r->retry_recovered,
+                         (unsigned long long)(r->retry_deferred - r->retry_recovered));
+        else
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No read was deferred.)");
+        if (r && r->effective_cfg.retry_defer && r->effective_cfg.read_retries > 0)
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Read back after the other files: %d retries, %d ms backoff doubled per attempt.",
+                         r->effective_cfg.read_retries, r->effective_cfg.retry_backoff_ms);
+        else if (r)
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Deferral OFF: failed reads are retried in place.");
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: Copy what you can off a card with unreadable extents, then replace it.");
+        return;
+    }
+
+    /* Page 8: Latency per operation */
+    if (page == 7) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 12, "Latency per operation", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        bool any = false;
+        for (int k = 0; k < OP_KIND_COUNT && r; k++) any |= (r->lat[k].count > 0);
+        if (any) {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "%-8s %10s %9s %9s %9s %9s %9s %9s", "Op", "Count", "Mean",
+                         lat_pct_name(0), lat_pct_name(1), lat_pct_name(2), lat_pct_name(3), "Max");
+            for (int k = 0; k < OP_KIND_COUNT; k++) {
+                const LatSummary* l = &r->lat[k];
+                if (!l->count) continue;
+                char mean[16], p[LAT_PCTS][16], mx[16];
+                lat_format(mean, sizeof(mean), l->mean_us);
+                for (int i = 0; i < LAT_PCTS; i++) lat_format(p[i], sizeof(p[i]), l->p_us[i]);
+                lat_format(mx, sizeof(mx), l->max_us);
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%-8s %10llu %9s %9s %9s %9s %9s %9s", op_kind_name((OpKind)k),
+                             (unsigned long long)l->count, mean, p[0], p[1], p[2], p[3], mx);
+            }
+            row++;
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Percentiles are bucket tops: within 12.5%% of the true value.");
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "readdir is timed per batch of entries; read per chunk or region.");
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No latency data. Quick Check does not time operations.)");
+        }
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: A p99.9 far above p99 points at rare, long stalls rather than a slow card.");
+        return;
+    }
+
+    /* Page 9: Time per phase */
+    if (page == 8) {
+        ui_draw_box(1, UI_CONTENT_Y, UI_W, 18, "Time per phase", C_CYAN);
+        int row = UI_CONTENT_Y + 2;
+        uint64_t sum = 0;
+        for (int k = 0; k < PHASE_COUNT && r; k++) sum += r->phase_us[k];
+        double wall_ms = r ? (r->seconds + r->prior_seconds) * 1000.0 : 0.0;
+        if (sum > 0 && wall_ms > 0.0) {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "%-14s %12s %8s", "Phase", "Time", "Share");
+            for (int k = 0; k < PHASE_COUNT; k++) {
+                double ms = (double)r->phase_us[k] / 1000.0;
+                ui_print_fit(row++, 3, UI_INNER, r->phase_us[k] ? C_WHITE : C_GRAY, "%-14s %9.1f ms %7.1f%%",
+                             scan_phase_name((ScanPhase)k), ms, 100.0 * ms / wall_ms);
+            }
+            row++;
+            if (r->readers <= 1 && !r->lookahead && !r->hash_bytes) {
+                double rest = wall_ms - (double)sum / 1000.0;
+                ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%-14s %9.1f ms %7.1f%%", "other", rest > 0.0 ? rest : 0.0,
+                             rest > 0.0 ? 100.0 * rest / wall_ms : 0.0);
+            } else {
+                ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Threads overlap (%d reader(s), walker, hasher): shares add up past 100%%.",
+                             r->readers > 0 ? r->readers : 1);
+            }
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "Share of the wall time, %.1f s including pauses.", wall_ms / 1000.0);
+        } else {
+            ui_print_fit(row++, 3, UI_INNER, C_GRAY, "(No phase data. Quick Check does not time its phases.)");
+        }
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: A large UI or pad share means the screen, not the card, slowed the scan.");
+        return;
+    }
+
+    /* Page 10: Slowest files and directories */
+    if (page == 9) {
+        static const char* titles[3] = { "Slowest files by rate (1 MiB and up)", "Slowest files by time",
+                                         "Slowest directories (listing time per entry)" };
+        const SlowList* lists[3] = { r ? &r->slow_rate : NULL, r ? &r->slow_time : NULL, r ? &r->slow_dirs : NULL };
+        for (int b = 0; b < 3; b++) {
+            int y = UI_CONTENT_Y + b * 7;
+            ui_draw_box(1, y, UI_W, 7, titles[b], C_CYAN);
+            int row = y + 1;
+            if (!lists[b] || lists[b]->count == 0) {
+                ui_print_fit(row, 3, UI_INNER, C_GRAY, "(None recorded.)");
+                continue;
+            }
+            for (int i = 0; i < lists[b]->count; i++) {
+                const SlowEntry* e = &lists[b]->e[i];
+                char disp[80];
+                tail_ellipsize(disp, sizeof(disp), e->path, 44);
+                if (b == 0)
+                    ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%9.2f MiB/s %9.1f MiB  %s", slow_mib_s(e), (double)e->n / 1048576.0, disp);
+                else if (b == 1)
+                    ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%10.1f ms %9.1f MiB  %s", (double)e->us / 1000.0, (double)e->n / 1048576.0, disp);
+                else
+                    ui_print_fit(row++, 3, UI_INNER, C_WHITE, "%8llu us/entry %7llu  %s", (unsigned long long)e->key,
+                                 (unsigned long long)e->n, disp);
+            }
+        }
+
+        ui_print_fit(27, 3, UI_INNER, C_GRAY, "Tip: Slow entries under one folder point at a region of the card, not all of it.");
+        return;
+    }
+
     /* Page 2: Failing paths + Largest files */
     ui_draw_box(1, UI_CONTENT_Y, UI_W, 7, "Run", C_CYAN);
 
@@ -1013,8 +1596,9 @@ static void ui_summary_draw(const RunResult* r, int page) {
     if (r) {
         ui_print_fit(UI_CONTENT_Y + 3, 3, UI_INNER, C_WHITE, "Mode: %s    Preset: %s", r->effective_cfg.full_read ? "Deep" : "Deep/Quick", preset_name(r->effective_cfg.preset));
         ui_print_fit(UI_CONTENT_Y + 4, 3, UI_INNER, C_WHITE, "Full read: %s    Threshold: %llu MiB", onoff(r->effective_cfg.full_read), (unsigned long long)(r->effective_cfg.large_file_limit/(1024ull*1024ull)));
-        ui_print_fit(UI_CONTENT_Y + 5, 3, UI_INNER, C_WHITE, "Retries: %d    Consistency: %s    Chunk: %s",
-                     r->effective_cfg.read_retries, onoff(r->effective_cfg.consistency_check), chunk_name(r->effective_cfg.chunk_mode));
+        ui_print_fit(UI_CONTENT_Y + 5, 3, UI_INNER, C_WHITE, "Retries: %d    Consistency: %s    Chunk: %s    I/O: %s",
+                     r->effective_cfg.read_retries, onoff(r->effective_cfg.consistency_check), chunk_name(r->effective_cfg.chunk_mode),
+                     r->io_backend[0] ? r->io_backend : "-");
         ui_print_fit(UI_CONTENT_Y + 6, 3, UI_INNER, C_WHITE, "Filters: skip folders=%s    skip exts=%s",
                      onoff(r->effective_cfg.skip_known_folders), onoff(r->effective_cfg.skip_media_exts));
     }
@@ -1065,8 +1649,8 @@ static void ui_results(PadState* pad, const char* title, RunResult* r) {
                 uint64_t d2 = poll_down(pad);
                 if (d2 & HidNpadButton_Y) { ui_log(pad); continue; }
                 if (d2 & HidNpadButton_ZL) { ui_help(pad); continue; }
-                if (d2 & HidNpadButton_L) { page = (page == 0) ? 1 : 0; continue; }
-                if (d2 & HidNpadButton_R) { page = (page == 0) ? 1 : 0; continue; }
+                if (d2 & HidNpadButton_L) { page = (page + SUMMARY_PAGES - 1) % SUMMARY_PAGES; continue; }
+                if (d2 & HidNpadButton_R) { page = (page + 1) % SUMMARY_PAGES; continue; }
                 if (d2 & (HidNpadButton_B | HidNpadButton_Plus)) break;
             }
         }
@@ -1203,12 +1787,13 @@ typedef enum {
     HOME_ACT_NONE = 0,
     HOME_ACT_QUICK,
     HOME_ACT_DEEP,
+    HOME_ACT_RESUME,
     HOME_ACT_SETTINGS,
     HOME_ACT_LOG,
     HOME_ACT_EXIT
 } HomeAction;
 
-static void ui_home_draw(int sel) {
+static void ui_home_draw(int sel, const ScanResumeInfo* ri) {
     ui_draw_header("Home",
                    "Up/Down: Select   A: Start   ZL: Help\n"
                    "X: Settings       -: Reset defaults\n"
@@ -1217,6 +1802,12 @@ static void ui_home_draw(int sel) {
     ui_draw_box(1, UI_CONTENT_Y, UI_W, 7, "Actions", C_CYAN);
     ui_print_fit(UI_CONTENT_Y + 2, 3, UI_INNER, (sel==0)?C_GREEN:C_WHITE, "%s  Quick Check", (sel==0)?">":" ");
     ui_print_fit(UI_CONTENT_Y + 3, 3, UI_INNER, (sel==1)?C_GREEN:C_WHITE, "%s  Deep Check",  (sel==1)?">":" ");
+    if (ri) {
+        ui_print_fit(UI_CONTENT_Y + 4, 3, UI_INNER, (sel==2)?C_GREEN:C_WHITE, "%s  Resume last Deep Check", (sel==2)?">":" ");
+        ui_print_fit(UI_CONTENT_Y + 5, 6, UI_INNER - 3, C_GRAY, "%.60s: %llu files, %.1f MiB done, %llu s",
+                     ri->root, (unsigned long long)ri->files_read, (double)ri->bytes_read / 1048576.0,
+                     (unsigned long long)(ri->elapsed_ms / 1000));
+    }
 
     ui_draw_box(1, 13, UI_W, 7, "Current Settings (saved)", C_CYAN);
 
@@ -1242,18 +1833,20 @@ static void ui_home_draw(int sel) {
 
 static HomeAction ui_home(PadState* pad) {
     int sel = 0;
+    ScanResumeInfo ri;
+    bool can_resume = scan_resume_peek(&ri);
     while (appletMainLoop()) {
         log_set_context("Home");
-        ui_home_draw(sel);
+        ui_home_draw(sel, can_resume ? &ri : NULL);
         consoleUpdate(NULL);
 
         uint64_t down = poll_down(pad);
         if (down & HidNpadButton_ZL) { ui_help(pad); continue; }
 
         if (down & HidNpadButton_Up)   { if (sel > 0) sel--; }
-        if (down & HidNpadButton_Down) { if (sel < 1) sel++; }
+        if (down & HidNpadButton_Down) { if (sel < (can_resume ? 2 : 1)) sel++; }
 
-        if (down & HidNpadButton_A) return (sel == 0) ? HOME_ACT_QUICK : HOME_ACT_DEEP;
+        if (down & HidNpadButton_A) return (sel == 0) ? HOME_ACT_QUICK : (sel == 1) ? HOME_ACT_DEEP : HOME_ACT_RESUME;
         if (down & HidNpadButton_X) return HOME_ACT_SETTINGS;
         if (down & HidNpadButton_Y) return HOME_ACT_LOG;
 
@@ -1279,7 +1872,7 @@ static void ui_settings_draw(int sel, int scroll) {
 
     /* Settings list */
     const int visible = 10;
-    const int total = 14;
+    const int total = 17;
     if (scroll < 0) scroll = 0;
     if (scroll > total - visible) scroll = total - visible;
     if (scroll < 0) scroll = 0;
@@ -1301,18 +1894,23 @@ static void ui_settings_draw(int sel, int scroll) {
             case 3: snprintf(line, sizeof(line), "%s Read retries        : %d", mark, g_cfg.read_retries); break;
             case 4: snprintf(line, sizeof(line), "%s Consistency check   : %s", mark, onoff(g_cfg.consistency_check)); break;
             case 5: snprintf(line, sizeof(line), "%s Chunk size          : %s", mark, chunk_name(g_cfg.chunk_mode)); break;
-            case 6: snprintf(line, sizeof(line), "%s Skip known folders  : %s", mark, onoff(g_cfg.skip_known_folders)); break;
-            case 7: snprintf(line, sizeof(line), "%s Skip media exts     : %s", mark, onoff(g_cfg.skip_media_exts)); break;
-            case 8: snprintf(line, sizeof(line), "%s Quick write test    : %s", mark, onoff(g_cfg.write_test)); break;
-            case 9: snprintf(line, sizeof(line), "%s Quick root listing  : %s", mark, onoff(g_cfg.list_root)); break;
-            case 10: snprintf(line, sizeof(line), "%s Deep scan target    : %s", mark, target_name(g_cfg.deep_target)); break;
-            case 11: {
+            case 6: snprintf(line, sizeof(line), "%s Reader threads      : %d", mark, g_cfg.reader_threads); break;
+            case 7: snprintf(line, sizeof(line), "%s Skip known folders  : %s", mark, onoff(g_cfg.skip_known_folders)); break;
+            case 8: snprintf(line, sizeof(line), "%s Skip media exts     : %s", mark, onoff(g_cfg.skip_media_exts)); break;
+            case 9: snprintf(line, sizeof(line), "%s Quick write test    : %s", mark, onoff(g_cfg.write_test)); break;
+            case 10: snprintf(line, sizeof(line), "%s Quick root listing  : %s", mark, onoff(g_cfg.list_root)); break;
+            case 11: snprintf(line, sizeof(line), "%s Deep scan target    : %s", mark, target_name(g_cfg.deep_target)); break;
+            case 12: {
                 char cr[80];
                 snprintf(cr, sizeof(cr), "%.65s", g_cfg.custom_root[0] ? g_cfg.custom_root : "sdmc:/");
                 snprintf(line, sizeof(line), "%s Custom path (cfg)   : %s", mark, cr);
             } break;
-            case 12: snprintf(line, sizeof(line), "%s UI top margin       : %d", mark, g_ui.top_margin); break;
-            case 13: snprintf(line, sizeof(line), "%s UI compact mode     : %s", mark, onoff(g_ui.compact_mode)); break;
+            case 13: snprintf(line, sizeof(line), "%s UI top margin       : %d", mark, g_ui.top_margin); break;
+            case 14: snprintf(line, sizeof(line), "%s UI compact mode     : %s", mark, onoff(g_ui.compact_mode)); break;
+            case 15: snprintf(line, sizeof(line), "%s Incremental scan    : %s", mark,
+                              g_cfg.manifest ? onoff(g_cfg.incremental) : "OFF (manifest=0)"); break;
+            case 16: snprintf(line, sizeof(line), "%s Content hash        : %s", mark,
+                              g_cfg.hash_algo == HASH_CRC32 ? "OFF (CRC-32)" : hash_algo_name(g_cfg.hash_algo)); break;
             default: snprintf(line, sizeof(line), "%s ", mark); break;
         }
 
@@ -1350,7 +1948,7 @@ static void ui_settings(PadState* pad) {
         }
 
         if (down & HidNpadButton_Up) { if (sel > 0) sel--; }
-        if (down & HidNpadButton_Down) { if (sel < 13) sel++; }
+        if (down & HidNpadButton_Down) { if (sel < 16) sel++; }
 
         const int visible = 10;
         if (sel < scroll) scroll = sel;
@@ -1396,47 +1994,67 @@ static void ui_settings(PadState* pad) {
                     break;
                 case 5:
                     cfg_touch_custom(&g_cfg);
-                    if (left) g_cfg.chunk_mode = (g_cfg.chunk_mode == CHUNK_AUTO) ? CHUNK_1M : (ChunkMode)(g_cfg.chunk_mode - 1);
-                    else g_cfg.chunk_mode = (g_cfg.chunk_mode == CHUNK_1M) ? CHUNK_AUTO : (ChunkMode)(g_cfg.chunk_mode + 1);
+                    if (left) g_cfg.chunk_mode = (g_cfg.chunk_mode == CHUNK_AUTO) ? CHUNK_8M : (ChunkMode)(g_cfg.chunk_mode - 1);
+                    else g_cfg.chunk_mode = (g_cfg.chunk_mode == CHUNK_8M) ? CHUNK_AUTO : (ChunkMode)(g_cfg.chunk_mode + 1);
                     log_pushf("INFO", "Chunk size: %s", chunk_name(g_cfg.chunk_mode));
                     break;
                 case 6:
+                    if (left) g_cfg.reader_threads = (g_cfg.reader_threads > 1) ? (g_cfg.reader_threads - 1) : READERS_MAX;
+                    else g_cfg.reader_threads = (g_cfg.reader_threads < READERS_MAX) ? (g_cfg.reader_threads + 1) : 1;
+                    log_pushf("INFO", "Reader threads: %d", g_cfg.reader_threads);
+                    break;
+                case 7:
                     cfg_touch_custom(&g_cfg);
                     g_cfg.skip_known_folders = !g_cfg.skip_known_folders;
                     log_pushf("INFO", "Skip known folders: %s", onoff(g_cfg.skip_known_folders));
                     break;
-                case 7:
+                case 8:
                     cfg_touch_custom(&g_cfg);
                     g_cfg.skip_media_exts = !g_cfg.skip_media_exts;
                     log_pushf("INFO", "Skip media extensions: %s", onoff(g_cfg.skip_media_exts));
                     break;
-                case 8:
+                case 9:
                     g_cfg.write_test = !g_cfg.write_test;
                     log_pushf("INFO", "Quick write test: %s", onoff(g_cfg.write_test));
                     break;
-                case 9:
+                case 10:
                     g_cfg.list_root = !g_cfg.list_root;
                     log_pushf("INFO", "Quick root listing: %s", onoff(g_cfg.list_root));
                     break;
-                case 10: {
+                case 11: {
                     int t = (int)g_cfg.deep_target;
                     if (left) t = (t == 0) ? (int)SCAN_TARGET_CUSTOM_CFG : (t - 1);
                     else t = (t == (int)SCAN_TARGET_CUSTOM_CFG) ? 0 : (t + 1);
                     g_cfg.deep_target = (ScanTarget)t;
                     log_pushf("INFO", "Deep scan target: %s", target_name(g_cfg.deep_target));
                 } break;
-                case 11:
+                case 12:
                     log_push("INFO", "Custom path is read-only in UI. Edit sdmc:/switch/sdcheck.cfg (custom_root=...).");
                     break;
-                case 12:
+                case 13:
                     if (left) g_ui.top_margin = (g_ui.top_margin > 0) ? (g_ui.top_margin - 1) : 2;
                     else g_ui.top_margin = (g_ui.top_margin < 2) ? (g_ui.top_margin + 1) : 0;
                     log_pushf("INFO", "UI top margin: %d", g_ui.top_margin);
                     break;
-                case 13:
+                case 14:
                     g_ui.compact_mode = !g_ui.compact_mode;
                     log_pushf("INFO", "UI compact mode: %s", onoff(g_ui.compact_mode));
                     break;
+                case 15:
+                    if (!g_cfg.manifest) {
+                        log_push("INFO", "Incremental scan needs the manifest. Set manifest=1 in sdmc:/switch/sdcheck.cfg.");
+                        break;
+                    }
+                    cfg_touch_custom(&g_cfg);
+                    g_cfg.incremental = !g_cfg.incremental;
+                    log_pushf("INFO", "Incremental scan: %s", onoff(g_cfg.incremental));
+                    break;
+                case 16:
+                    cfg_touch_custom(&g_cfg);
+                    if (left) g_cfg.hash_algo = (HashAlgo)((g_cfg.hash_algo + HASH_ALGO_COUNT - 1) % HASH_ALGO_COUNT);
+                    else g_cfg.hash_algo = (HashAlgo)((g_cfg.hash_algo + 1) % HASH_ALGO_COUNT);
+                    log_pushf("INFO", "Content hash: %s", hash_algo_name(g_cfg.hash_algo));
+                    break;
                 default:
                     break;
             }
@@ -1693,12 +2311,14 @@ static void do_deep_check(PadState* pad) {
 
     const uint64_t thresholds[] = { 64ull*1024ull*1024ull, 256ull*1024ull*1024ull, 1024ull*1024ull*1024ull };
     const int th_n = (int)(sizeof(thresholds)/sizeof(thresholds[0]));
+    const int budgets[] = { 0, 5, 10, 15, 30, 60, 120 };
+    const int bud_n = (int)(sizeof(budgets)/sizeof(budgets[0]));
 
     while (appletMainLoop()) {
         ui_draw_header("Deep Check",
                        "A: Start           ZR: Toggle Full read\n"
-                       "Left/Right: Threshold   B/+ : Back\n"
-                       "Y: Log   ZL: Help");
+                       "Left/Right: Threshold   Up/Down: Time budget\n"
+                       "B/+ : Back   Y: Log   ZL: Help");
 
         ui_draw_box(1, UI_CONTENT_Y, UI_W, 11, "Policy", C_CYAN);
         ui_print_fit(UI_CONTENT_Y + 2, 3, UI_INNER, C_WHITE, "Preset: %s", preset_name(g_cfg.preset));
@@ -1712,6 +2332,10 @@ static void do_deep_check(PadState* pad) {
         ui_print_fit(UI_CONTENT_Y + 6, 3, UI_INNER, C_WHITE, "Large-file threshold: %llu MiB", (unsigned long long)(g_cfg.large_file_limit/(1024ull*1024ull)));
         ui_print_fit(UI_CONTENT_Y + 7, 3, UI_INNER, C_WHITE, "Full read: %s", onoff(g_cfg.full_read));
         ui_print_fit(UI_CONTENT_Y + 8, 3, UI_INNER, C_GRAY,  "If Full read is OFF, large files may be sampled (first+last 64 KiB)." );
+        if (g_cfg.time_budget_min > 0)
+            ui_print_fit(UI_CONTENT_Y + 9, 3, UI_INNER, C_YELLOW, "Time budget: %d min (reads fully, samples or skips files to finish in time)", g_cfg.time_budget_min);
+        else
+            ui_print_fit(UI_CONTENT_Y + 9, 3, UI_INNER, C_WHITE, "Time budget: OFF");
 
         ui_draw_box(1, 17, UI_W, 12, "Notes", C_CYAN);
         ui_print_fit(19, 3, UI_INNER, C_WHITE, "Deep Check reads files to detect read errors.");
@@ -1744,6 +2368,17 @@ static void do_deep_check(PadState* pad) {
             cfg_save_to_sd(&g_cfg, &g_ui);
         }
 
+        if (down & (HidNpadButton_Up | HidNpadButton_Down)) {
+            int cur = 0;
+            for (int i = 0; i < bud_n; i++) if (g_cfg.time_budget_min == budgets[i]) { cur = i; break; }
+            if (down & HidNpadButton_Up) cur = (cur + 1) % bud_n;
+            if (down & HidNpadButton_Down) cur = (cur - 1 + bud_n) % bud_n;
+            g_cfg.time_budget_min = budgets[cur];
+            if (g_cfg.time_budget_min > 0) log_pushf("INFO", "Time budget set: %d min", g_cfg.time_budget_min);
+            else log_push("INFO", "Time budget set: OFF");
+            cfg_save_to_sd(&g_cfg, &g_ui);
+        }
+
         if (down & HidNpadButton_A) break;
         if (down & (HidNpadButton_B | HidNpadButton_Plus)) return;
     }
@@ -1754,6 +2389,22 @@ static void do_deep_check(PadState* pad) {
 
     char deep_root[256];
     get_deep_root(&cfg, deep_root, sizeof(deep_root));
+    deep_run(pad, deep_root, &cfg, false);
+}
+
+/* Continues the scan left in the resume journal, with the settings it was started with. */
+static void do_deep_resume(PadState* pad) {
+    ScanResumeInfo ri;
+    if (!scan_resume_peek(&ri)) {
+        ui_message_screen(pad, "Deep Check", "Nothing to resume (the journal is missing or damaged).", "B/+ : Back\nY: Log   ZL: Help\n ");
+        return;
+    }
+    log_pushf("INFO", "Deep Check resumed (%s, %llu files done).", ri.root, (unsigned long long)ri.files_read);
+    deep_run(pad, ri.root, &ri.cfg, true);
+}
+
+static void deep_run(PadState* pad, const char* deep_root, const ScanConfig* run_cfg, bool resume) {
+    ScanConfig cfg = *run_cfg;
     struct stat root_st;
     if (stat(deep_root, &root_st) != 0 || !S_ISDIR(root_st.st_mode)) {
         log_pushf("ERROR", "Target root is not accessible: %s (%s)", deep_root, strerror(errno));
@@ -1789,7 +2440,8 @@ static void do_deep_check(PadState* pad) {
 
     uint64_t start_tick = armGetSystemTick();
 
-    scan_engine_run(deep_root, &cfg, &st, pad, deep_ui_maybe_update);
+    if (resume) scan_engine_resume(&st, pad, deep_ui_maybe_update);
+    else scan_engine_run(deep_root, &cfg, &st, pad, deep_ui_maybe_update);
 
     st.ui_active = false;
 
@@ -1806,21 +2458,106 @@ static void do_deep_check(PadState* pad) {
     rr.files_read = st.files_read;
     rr.bytes_read = st.bytes_read;
     rr.seconds = secs;
+    rr.resumes = st.resumes;
+    rr.prior_seconds = (double)st.resume_prior_ms / 1000.0;
 
     rr.open_errors = st.open_errors;
     rr.read_errors = st.read_errors;
     rr.read_errors_transient = st.read_errors_transient;
+    rr.read_timeouts = st.read_timeouts;
     rr.stat_errors = st.stat_errors;
     rr.path_errors = st.path_errors;
     rr.consistency_errors = st.consistency_errors;
 
     rr.skipped_dirs = st.skipped_dirs;
     rr.skipped_files = st.skipped_files;
+    rr.stats_avoided = st.stats_avoided;
+    rr.stats_performed = st.stats_performed;
+    rr.dir_enum_dirs = st.dir_enum_dirs;
+    rr.dir_enum_entries = st.dir_enum_entries;
+    rr.dir_enum_us = st.dir_enum_us;
+    rr.read_io_us = st.read_io_us;
+    rr.walk_wait_us = st.walk_wait_us;
+    rr.ranged_files = st.ranged_files;
+    rr.hash_algo = cfg.hash_algo;
+    rr.hash_bytes = st.hash_bytes;
+    rr.hash_us = st.hash_us;
+    rr.hash_wait_us = st.hash_wait_us;
+    rr.sample_files = st.sample_files;
+    rr.sample_regions = st.sample_regions;
+    rr.sample_bytes = st.sample_bytes;
+    rr.sample_span_bytes = st.sample_span_bytes;
+    rr.sample_seed = st.sample_seed;
+    rr.bytes_total = st.bytes_total;
+    rr.budget_on = st.budget_on;
+    rr.manifest_on = st.manifest_on;
+    rr.incremental_on = st.incremental_on;
+    rr.manifest_write_ok = st.manifest_write_ok;
+    rr.timeline_samples = st.timeline_samples;
+    rr.timeline_interval_s = st.timeline_interval_s;
+    rr.timeline_write_ok = st.timeline_write_ok;
+    rr.trace_events = st.trace_events;
+    rr.trace_dropped = st.trace_dropped;
+    rr.trace_write_ok = st.trace_write_ok;
+    rr.manifest_loaded = st.manifest_loaded;
+    rr.manifest_written = st.manifest_written;
+    rr.manifest_new = st.manifest_new;
+    rr.manifest_changed = st.manifest_changed;
+    rr.manifest_stale = st.manifest_stale;
+    rr.manifest_unchanged = st.manifest_unchanged;
+    rr.manifest_unchanged_bytes = st.manifest_unchanged_bytes;
+    rr.budget_frac = st.budget_frac;
+    rr.budget_keep = st.budget_keep;
+    rr.budget_left_ms = st.budget_left_ms;
+    rr.budget_solves = st.budget_solves;
+    rr.budget_pre_files = st.budget_pre_files;
+    rr.budget_pre_bytes = st.budget_pre_bytes;
+    rr.budget_pre_ms = st.budget_pre_ms;
+    rr.budget_full = st.budget_full;
+    rr.budget_sampled = st.budget_sampled;
+    rr.budget_skipped = st.budget_skipped;
+    rr.budget_skipped_bytes = st.budget_skipped_bytes;
+    rr.budget_share_min = st.budget_share_min;
+    rr.budget_share_sum = st.budget_share_sum;
+    rr.tune_chunk = st.tune_chunk;
+    rr.tune_rounds = st.tune_rounds;
+    for (int i = 0; i < TUNE_SIZES; i++) {
+        rr.tune_mib_s[i] = st.tune_mib_s[i];
+        rr.tune_bytes[i] = st.tune_bytes[i];
+    }
+    rr.lookahead = st.run_lookahead;
+    rr.readers = st.run_readers;
+    for (int i = 0; i < READERS_MAX; i++) {
+        rr.worker_files[i] = st.worker_files[i];
+        rr.worker_bytes[i] = st.worker_bytes[i];
+        rr.worker_busy_us[i] = st.worker_busy_us[i];
+    }
 
     rr.effective_cfg = cfg;
+    snprintf(rr.io_backend, sizeof(rr.io_backend), "%s", st.run_io_backend);
 
     rr.largest_count = st.largest_count;
     for (int i = 0; i < st.largest_count && i < LARGEST_MAX; i++) rr.largest[i] = st.largest[i];
+    rr.slow_rate.count = slow_sorted(&st.slow_rate, rr.slow_rate.e);
+    rr.slow_time.count = slow_sorted(&st.slow_time, rr.slow_time.e);
+    rr.slow_dirs.count = slow_sorted(&st.slow_dirs, rr.slow_dirs.e);
+
+    rr.bitrot_checked = st.bitrot_checked;
+    rr.bitrot_files = st.bitrot_files;
+    rr.bitrot_bytes = st.bitrot_bytes;
+    rr.bitrot_count = st.bitrot_count;
+    for (int i = 0; i < st.bitrot_count && i < BITROT_MAX; i++) rr.bitrot[i] = st.bitrot[i];
+
+    rr.bad_files = st.bad_files;
+    rr.bad_extents = st.bad_extents;
+    rr.bad_bytes = st.bad_bytes;
+    rr.bisect_reads = st.bisect_reads;
+    rr.bisect_bytes = st.bisect_bytes;
+    rr.bisect_recovered = st.bisect_recovered;
+    rr.bad_count = st.bad_count;
+    for (int i = 0; i < st.bad_count && i < BADFILE_MAX; i++) rr.bad[i] = st.bad[i];
+    rr.retry_deferred = st.retry_deferred;
+    rr.retry_recovered = st.retry_recovered;
 
     rr.fail_count = st.fail_count;
     for (int i = 0; i < st.fail_count && i < FAIL_MAX; i++) snprintf(rr.fail_paths[i], sizeof(rr.fail_paths[i]), "%s", st.fail_paths[i]);
@@ -1830,6 +2567,9 @@ static void do_deep_check(PadState* pad) {
     for (int i = 0; i < 5; i++) rr.perf_hist[i] = st.perf_hist[i];
     rr.perf_stalls = st.perf_stalls;
     rr.perf_stall_total_ms = st.perf_stall_total_ms;
+    rr.stalls = st.stalls;
+    for (int k = 0; k < OP_KIND_COUNT; k++) lat_summarize(&st.lat[k], &rr.lat[k]);
+    scan_phase_times(&st, rr.phase_us);
     rr.perf_longest_ms = st.perf_longest_ms;
     rr.perf_longest_mib_s = st.perf_longest_mib_s;
     rr.perf_longest_off = st.perf_longest_off;
@@ -1868,6 +2608,8 @@ int main(int argc, char* argv[]) {
 
     log_clear();
     log_push("INFO", "SD Check started.");
+    crc32_init();
+    hash_init();
 
     sleep_guard_enter(&g_sleep);
 
@@ -1921,6 +2663,7 @@ int main(int argc, char* argv[]) {
 
         if (act == HOME_ACT_QUICK) do_quick_check(&pad);
         else if (act == HOME_ACT_DEEP) do_deep_check(&pad);
+        else if (act == HOME_ACT_RESUME) do_deep_resume(&pad);
         else if (act == HOME_ACT_SETTINGS) ui_settings(&pad);
         else if (act == HOME_ACT_LOG) ui_log(&pad);
         else if (act == HOME_ACT_EXIT) break;
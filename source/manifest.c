@@ -0,0 +1,299 @@
+#include "manifest.h"
+#include "crc32.h"
+#include "config.h"
+
+#ifndef __SWITCH__
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+uint64_t manifest_hash(const char* path) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (const unsigned char* p = (const unsigned char*)path; *p; p++) {
+        h ^= *p;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+/* Order of the entry table: hash, then path (collisions). */
+static int mf_order(uint64_t ha, const char* pa, uint64_t hb, const char* pb) {
+    if (ha != hb) return ha < hb ? -1 : 1;
+    return strcmp(pa, pb);
+}
+
+/* --------------------------------------------------------------------------
+   Loading
+----------------------------------------------------------------------------*/
+static bool mf_validate(Manifest* m) {
+    const ManifestHeader* h = (const ManifestHeader*)m->base;
+    if (m->len < sizeof(*h)) return false;
+    if (memcmp(h->magic, MANIFEST_MAGIC, sizeof(h->magic)) != 0) return false;
+    if (h->version != MANIFEST_VERSION) return false;
+    if (h->header_size != sizeof(ManifestHeader) || h->entry_size != sizeof(ManifestEntry)) return false;
+    if (h->count > (m->len - sizeof(*h)) / sizeof(ManifestEntry)) return false;
+    uint64_t ents_len = h->count * sizeof(ManifestEntry);
+    if (sizeof(*h) + ents_len + h->names_len != m->len) return false;
+    if (h->names_len > 0 && ((const char*)m->base)[m->len - 1] != 0) return false;
+
+    m->hdr = h;
+    m->ents = (const ManifestEntry*)((const char*)m->base + sizeof(*h));
+    m->names = (const char*)m->base + sizeof(*h) + ents_len;
+    m->count = h->count;
+
+    if (crc32_update(0, m->ents, (size_t)(ents_len + h->names_len)) != h->crc) return false;
+    for (uint64_t i = 0; i < m->count; i++) {
+        const ManifestEntry* e = &m->ents[i];
+        if (e->name_off >= h->names_len) return false;
+        if (i > 0 && mf_order(m->ents[i - 1].path_hash, manifest_name(m, &m->ents[i - 1]),
+                              e->path_hash, manifest_name(m, e)) >= 0) return false;
+    }
+    return true;
+}
+
+bool manifest_load(Manifest* m, const char* path) {
+    memset(m, 0, sizeof(*m));
+    crc32_init();
+
+    struct stat s;
+    if (stat(path, &s) != 0) return false;
+    if (s.st_size < (off_t)sizeof(ManifestHeader)) {
+        errno = EILSEQ;
+        return false;
+    }
+    m->len = (size_t)s.st_size;
+
+#ifndef __SWITCH__
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    void* p = mmap(NULL, m->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    int e = errno;
+    close(fd);
+    if (p == MAP_FAILED) {
+        errno = e;
+        return false;
+    }
+    m->base = p;
+    m->mapped = true;
+#else
+    m->base = malloc(m->len);
+    if (!m->base) {
+        errno = ENOMEM;
+        return false;
+    }
+    FILE* f = fopen(path, "rb");
+    bool ok = f && fread(m->base, 1, m->len, f) == m->len;
+    int e = errno;
+    if (f) fclose(f);
+    if (!ok) {
+        manifest_close(m);
+        errno = e ? e : EIO;
+        return false;
+    }
+#endif
+
+    if (!mf_validate(m)) {
+        manifest_close(m);
+        errno = EILSEQ;
+        return false;
+    }
+    return true;
+}
+
+void manifest_close(Manifest* m) {
+#ifndef __SWITCH__
+    if (m->mapped && m->base) munmap(m->base, m->len);
+    else free(m->base);
+#else
+    free(m->base);
+#endif
+    memset(m, 0, sizeof(*m));
+}
+
+const ManifestEntry* manifest_find(const Manifest* m, const char* path) {
+    if (!m || m->count == 0) return NULL;
+    uint64_t h = manifest_hash(path);
+    uint64_t lo = 0, hi = m->count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        const ManifestEntry* e = &m->ents[mid];
+        int c = mf_order(e->path_hash, manifest_name(m, e), h, path);
+        if (c == 0) return e;
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------
+   Building
+----------------------------------------------------------------------------*/
+bool manifest_builder_add(ManifestBuilder* b, const char* path, const ManifestEntry* src) {
+    size_t len = strlen(path);
+    if (b->count == b->cap) {
+        size_t ncap = b->cap ? b->cap * 2 : 1024;
+        ManifestEntry* ne = (ManifestEntry*)realloc(b->ents, ncap * sizeof(*ne));
+        if (!ne) { b->oom = true; return false; }
+        b->ents = ne;
+        b->cap = ncap;
+    }
+    if (b->names_len + len + 1 > b->names_cap) {
+        size_t ncap = b->names_cap ? b->names_cap : 65536;
+        while (ncap < b->names_len + len + 1) ncap *= 2;
+        char* nn = (char*)realloc(b->names, ncap);
+        if (!nn) { b->oom = true; return false; }
+        b->names = nn;
+        b->names_cap = ncap;
+    }
+
+    ManifestEntry* e = &b->ents[b->count++];
+    *e = *src;
+    e->path_hash = manifest_hash(path);
+    e->name_off = b->names_len;
+    memcpy(b->names + b->names_len, path, len + 1);
+    b->names_len += len + 1;
+    return true;
+}
+
+bool manifest_builder_carry(ManifestBuilder* b, const char* path, const ManifestEntry* e) {
+    if (!manifest_builder_add(b, path, e)) return false;
+    b->carried++;
+    return true;
+}
+
+void manifest_builder_free(ManifestBuilder* b) {
+    free(b->ents);
+    free(b->names);
+    memset(b, 0, sizeof(*b));
+}
+
+/* --------------------------------------------------------------------------
+   Writing
+----------------------------------------------------------------------------*/
+typedef struct {
+    const ManifestEntry* e;
+    const char*          path;
+} MfRef;
+
+static int mf_ref_cmp(const void* a, const void* b) {
+    const MfRef* x = (const MfRef*)a;
+    const MfRef* y = (const MfRef*)b;
+    int c = mf_order(x->e->path_hash, x->path, y->e->path_hash, y->path);
+    if (c) return c;
+    /* Same path from two builders (a resumed read): the newer verification sorts last and wins. */
+    if (x->e->verified_at != y->e->verified_at) return x->e->verified_at < y->e->verified_at ? -1 : 1;
+    return 0;
+}
+
+static bool path_under(const char* root, const char* path) {
+    size_t n = strlen(root);
+    if (strncmp(root, path, n) != 0) return false;
+    return n == 0 || root[n - 1] == '/' || path[n] == '/' || path[n] == 0;
+}
+
+static bool mf_put(FILE* f, const void* p, size_t len, uint32_t* crc) {
+    *crc = crc32_update(*crc, p, len);
+    return fwrite(p, 1, len, f) == len;
+}
+
+bool manifest_write(const char* path, const Manifest* old, ManifestBuilder* const* b, int nb,
+                    const char* prune_root, uint64_t* out_count) {
+    crc32_init();
+    size_t nnew = 0;
+    for (int i = 0; i < nb; i++) if (b[i]) nnew += b[i]->count;
+    size_t nold = old ? (size_t)old->count : 0;
+
+    MfRef* add = (MfRef*)malloc((nnew ? nnew : 1) * sizeof(*add));
+    MfRef* out = (MfRef*)malloc((nnew + nold ? nnew + nold : 1) * sizeof(*out));
+    if (!add || !out) {
+        free(add);
+        free(out);
+        errno = ENOMEM;
+        return false;
+    }
+    size_t na = 0;
+    for (int i = 0; i < nb; i++) {
+        if (!b[i]) continue;
+        for (size_t k = 0; k < b[i]->count; k++) {
+            add[na].e = &b[i]->ents[k];
+            add[na].path = b[i]->names + b[i]->ents[k].name_off;
+            na++;
+        }
+    }
+    qsort(add, na, sizeof(*add), mf_ref_cmp);
+
+    /* Merge: both lists are in table order; a built entry replaces the old one. */
+    size_t n = 0, ia = 0, io = 0;
+    while (ia < na || io < nold) {
+        int c;
+        if (ia == na) c = 1;
+        else if (io == nold) c = -1;
+        else c = mf_order(add[ia].e->path_hash, add[ia].path, old->ents[io].path_hash, manifest_name(old, &old->ents[io]));
+
+        if (c > 0) {
+            const ManifestEntry* e = &old->ents[io++];
+            const char* p = manifest_name(old, e);
+            if (!(prune_root && path_under(prune_root, p))) {
+                out[n].e = e;
+                out[n].path = p;
+                n++;
+            }
+            continue;
+        }
+        if (c == 0) io++;
+        /* Duplicates among the built entries: keep the last (newest). */
+        while (ia + 1 < na && mf_order(add[ia].e->path_hash, add[ia].path, add[ia + 1].e->path_hash, add[ia + 1].path) == 0) ia++;
+        out[n++] = add[ia++];
+    }
+
+    char tmp[PATH_MAX_LOCAL];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE* f = fopen(tmp, "wb");
+    bool ok = (f != NULL);
+    char* iobuf = ok ? (char*)malloc(65536) : NULL;
+    if (iobuf) setvbuf(f, iobuf, _IOFBF, 65536);
+
+    ManifestHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, MANIFEST_MAGIC, sizeof(h.magic));
+    h.version = MANIFEST_VERSION;
+    h.header_size = sizeof(ManifestHeader);
+    h.entry_size = sizeof(ManifestEntry);
+    h.count = n;
+    h.created = (int64_t)time(NULL);
+    if (ok) ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+    uint32_t crc = 0;
+    uint64_t name_off = 0;
+    for (size_t i = 0; i < n && ok; i++) {
+        ManifestEntry e = *out[i].e;
+        e.name_off = name_off;
+        name_off += strlen(out[i].path) + 1;
+        ok = mf_put(f, &e, sizeof(e), &crc);
+    }
+    for (size_t i = 0; i < n && ok; i++) ok = mf_put(f, out[i].path, strlen(out[i].path) + 1, &crc);
+    h.names_len = name_off;
+    h.crc = crc;
+    if (ok) ok = fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, f) == 1;
+    int e = errno;
+    if (f && fclose(f) != 0 && ok) {
+        ok = false;
+        e = errno;
+    }
+    free(iobuf);
+    free(add);
+    free(out);
+
+    if (ok) {
+        remove(path);
+        ok = (rename(tmp, path) == 0);
+        e = errno;
+    }
+    if (!ok) {
+        remove(tmp);
+        errno = e ? e : EIO;
+        return false;
+    }
+    if (out_count) *out_count = n;
+    return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "app.h"
+
+/*
+ * File manifest: one record per verified file (path, size, mtime, time of the last full read
+ * without error, whole-file CRC-32 and, with hash_algo set, a content digest). A Deep Check
+ * writes it at the end; an incremental scan uses it to skip files that did not change and were
+ * verified recently.
+ *
+ * On disk (little-endian, 8-byte aligned, offsets only), so a host can mmap it as is:
+ *   ManifestHeader
+ *   ManifestEntry[count]    sorted by (path_hash, path): lookups are a binary search
+ *   char names[names_len]   NUL-terminated paths, referenced by name_off
+ */
+#define MANIFEST_MAGIC   "SDCKMAN1"
+#define MANIFEST_VERSION 1
+
+#ifndef MANIFEST_DIR
+#define MANIFEST_DIR "sdmc:/switch"
+#endif
+#define MANIFEST_PATH MANIFEST_DIR "/sdcheck.manifest"
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t entry_size;
+    uint32_t crc;            /* CRC-32 of the entries and names */
+    uint64_t count;
+    uint64_t names_len;
+    int64_t  created;        /* time() of the write */
+} ManifestHeader;
+
+typedef struct {
+    uint64_t path_hash;      /* manifest_hash() of the path */
+    uint64_t name_off;       /* into names */
+    uint64_t size;
+    int64_t  mtime;          /* as the filesystem reports it */
+    int64_t  verified_at;    /* time() of the last full read without error */
+    uint32_t crc;            /* CRC-32 of the whole file */
+    uint32_t flags;          /* MANIFEST_F_* */
+    uint32_t hash_algo;      /* HashAlgo of digest; HASH_CRC32: none */
+    uint32_t reserved;
+    uint8_t  digest[32];     /* canonical, hash_digest_len() bytes used */
+} ManifestEntry;
+
+/* The last read did not match crc (kept from the earlier verification); re-read every run. */
+#define MANIFEST_F_BITROT 1u
+
+typedef struct {
+    const ManifestHeader* hdr;
+    const ManifestEntry*  ents;
+    const char*           names;
+    uint64_t              count;
+    void*                 base;      /* mapping (host) or heap copy (Switch) */
+    size_t                len;
+    bool                  mapped;
+} Manifest;
+
+/* 64-bit FNV-1a. */
+uint64_t manifest_hash(const char* path);
+
+/* Opens and validates a manifest.
+   false + errno (ENOENT: none yet, EILSEQ: damaged or foreign). */
+bool manifest_load(Manifest* m, const char* path);
+void manifest_close(Manifest* m);
+
+/* O(log n). NULL if the path is not listed (or m is empty). */
+const ManifestEntry* manifest_find(const Manifest* m, const char* path);
+
+static inline const char* manifest_name(const Manifest* m, const ManifestEntry* e) {
+    return m->names + e->name_off;
+}
+
+/* Entries collected during a scan; one builder per thread, no locking. */
+typedef struct {
+    ManifestEntry* ents;
+    size_t         count;
+    size_t         cap;
+    char*          names;
+    size_t         names_len;
+    size_t         names_cap;
+    size_t         carried;  /* of count: old entries kept as they were (not verified) */
+    bool           oom;      /* an add failed: entries are missing */
+} ManifestBuilder;
+
+/* Adds a copy of e for path (path_hash and name_off are set here). */
+bool manifest_builder_add(ManifestBuilder* b, const char* path, const ManifestEntry* e);
+/* The same for an old entry kept without reading the file (counted in carried). */
+bool manifest_builder_carry(ManifestBuilder* b, const char* path, const ManifestEntry* e);
+void manifest_builder_free(ManifestBuilder* b);
+
+/*
+ * Writes old + the builders' entries to path (temp file, then rename). A built entry replaces the
+ * old one with the same path. With prune_root set, old entries under it that no builder has are
+ * dropped: the scan covered that tree, so those files are gone or failed to verify.
+ */
+bool manifest_write(const char* path, const Manifest* old, ManifestBuilder* const* b, int nb,
+                    const char* prune_root, uint64_t* out_count);
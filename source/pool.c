@@ -0,0 +1,485 @@
+#include "pool.h"
+#include "util.h"
+#include "log.h"
+#include "budget.h"
+
+#include <stdatomic.h>
+
+static void shard_publish(ReaderShard* sh) {
+    pthread_mutex_lock(&sh->lock);
+    memcpy(&sh->view.st, &sh->st, sizeof(sh->st));
+    sh->view.first_fail_seq = sh->first_fail_seq;
+    memcpy(sh->view.fail_seq, sh->fail_seq, sizeof(sh->fail_seq));
+    sh->view.cur_seq = sh->cur_seq;
+    sh->view.busy = sh->busy;
+    sh->view.cursor = sh->cursor;
+    pthread_mutex_unlock(&sh->lock);
+}
+
+/* ui_update hook of the read path on reader threads: publish, honor pause and cancel. */
+static void reader_tick(ScanStats* st, PadState* pad, bool force) {
+    (void)pad;
+    ReaderShard* sh = (ReaderShard*)st;
+    ScanPool* pool = sh->pool;
+
+    /*
+     * Pause, help, log and the cancel prompt are modal screens on the UI thread; a serial scan
+     * stops reading while one is open. Readers do the same: they hold while the UI thread's
+     * heartbeat is stale.
+     */
+    uint64_t hold0 = now_ms();
+    while (now_ms() - atomic_load_explicit(&pool->ui_beat_ms, memory_order_relaxed) > 250 &&
+           !atomic_load_explicit(&pool->cancel, memory_order_relaxed)) {
+        svcSleepThread(20 * 1000 * 1000);
+    }
+    /* Kept like a serial scan's pauses (pool_merge leaves the UI thread's own), so file times skip it. */
+    st->paused_total_ms += now_ms() - hold0;
+    if (atomic_load_explicit(&pool->cancel, memory_order_relaxed)) st->cancelled = true;
+
+    uint64_t now = now_ms();
+    if (force ? (now - sh->pub_last_ms) >= 20 : (now - sh->pub_last_ms) >= 50) {
+        shard_publish(sh);
+        sh->pub_last_ms = now;
+    }
+}
+
+static void reader_main(void* arg) {
+    ReaderShard* sh = (ReaderShard*)arg;
+    ScanPool* pool = sh->pool;
+    char name[24];
+    snprintf(name, sizeof(name), "reader %d", sh->id + 1);
+    trace_thread(name);
+    ScanRun run = { pool->cfg, &sh->st, NULL, reader_tick, &sh->bufs, pool->tune, pool->plan,
+                    pool->journal ? &sh->cursor : NULL, pool->cfg->manifest ? &sh->mf : NULL, &sh->retry };
+
+    WorkItem it;
+    memset(&it, 0, sizeof(it));
+    uint32_t wait_round = 0;
+    uint64_t wait_t0 = 0;
+    while (!atomic_load_explicit(&pool->cancel, memory_order_relaxed)) {
+        if (!work_queue_pop(pool->q, &it)) {
+            if (atomic_load_explicit(&pool->drained, memory_order_acquire)) break;
+            if (!wait_t0) wait_t0 = now_us();
+            queue_backoff(&wait_round);
+            continue;
+        }
+        if (wait_t0) {
+            sh->st.walk_wait_us += now_us() - wait_t0;
+            wait_t0 = 0;
+        }
+        wait_round = 0;
+
+        if (it.kind == WORK_END) {
+            walk_counts_apply(&sh->st, &it.counts);
+            atomic_store_explicit(&pool->drained, true, memory_order_release);
+            break;
+        }
+
+        sh->cur_seq = it.seq;
+        sh->busy = true;
+        if (pool->journal) {
+            /* A checkpoint must see the item as taken before any later item another reader takes. */
+            resume_cursor_take(&sh->cursor, &it);
+            sh->cursor.busy = it.opened;
+            sh->cursor.started = it.resumed;
+            sh->st.current_done = it.resume_off;
+            sh->st.current_seq_read = (it.resume_off > 0);
+            sh->st.current_crc = it.resume_crc;
+            sh->st.current_crc_off = it.resume_off;
+            sh->st.current_sample = it.sample;
+            shard_publish(sh);
+        }
+        int nfail = sh->st.fail_count;
+        bool had_first = sh->st.first_fail_set;
+        bool go = work_consume(&run, &it);
+        if (!had_first && sh->st.first_fail_set) sh->first_fail_seq = it.seq;
+        for (int i = nfail; i < sh->st.fail_count; i++) sh->fail_seq[i] = it.seq;
+        sh->busy = false;
+        if (!go) break;
+    }
+    if (it.opened) op_close(&it.f, it.path, sh->st.lat);
+    free(it.path);
+
+    /* Deferred regions: read back once this reader has run out of files. */
+    sh->busy = sh->retry.count > 0;
+    retry_drain(&run, &sh->retry);
+    for (int i = 0; i < sh->retry.count; i++) {
+        const RetryEntry* e = &sh->retry.ents[i];
+        int nfail = sh->st.fail_count;
+        bool had_first = sh->st.first_fail_set;
+        retry_report(&sh->st, &sh->retry, i);
+        if (!had_first && sh->st.first_fail_set) sh->first_fail_seq = e->seq;
+        for (int k = nfail; k < sh->st.fail_count; k++) sh->fail_seq[k] = e->seq;
+    }
+    sh->busy = false;
+    retry_queue_free(&sh->retry);
+
+    shard_publish(sh);
+    atomic_fetch_sub_explicit(&pool->active, 1, memory_order_release);
+}
+
+void pool_merge(ScanPool* pool, ScanStats* st) {
+    WalkCounts wc;
+    memset(&wc, 0, sizeof(wc));
+    uint64_t files_read = 0, bytes_read = 0, rd_err = 0, rd_tr = 0, rd_to = 0, rt_def = 0, rt_rec = 0, cons = 0;
+    uint64_t io_us = 0, busy_us = 0, wait_us = 0, ranged = 0;
+    uint64_t h_bytes = 0, h_us = 0, h_wait = 0, crc_us = 0, ver_us = 0, rs_us = 0;
+    uint64_t smp_files = 0, smp_regions = 0, smp_bytes = 0, smp_span = 0;
+    uint64_t b_full = 0, b_sampled = 0, b_skipped = 0, b_skipped_bytes = 0, b_share_n = 0;
+    double b_share_min = 0.0, b_share_sum = 0.0;
+    uint64_t p_ops = 0, p_bytes = 0, p_hist[5] = {0}, p_stalls = 0, p_stall_ms = 0;
+    LatHist lat[OP_KIND_COUNT];
+    memset(lat, 0, sizeof(lat));
+    SlowList slow_rate, slow_time;
+    memset(&slow_rate, 0, sizeof(slow_rate));
+    memset(&slow_time, 0, sizeof(slow_time));
+    uint64_t rot_checked = 0, rot_files = 0, rot_bytes = 0;
+    BitrotEntry rot[BITROT_MAX];
+    int nrot = 0;
+    uint64_t bad_files = 0, bad_ext = 0, bad_bytes = 0, bis_reads = 0, bis_bytes = 0, bis_rec = 0;
+    BadFileEntry bad[BADFILE_MAX];
+    int nbad = 0;
+    const ScanStats* longest = NULL;
+    const ScanStats* first = NULL;
+    uint64_t first_seq = UINT64_MAX;
+    const ScanStats* cur = NULL;
+    uint64_t cur_seq = UINT64_MAX;
+
+    /* Failing paths of all shards, merged by sequence (each shard's list is in order). */
+    const char* fp[(READERS_MAX + 1) * FAIL_MAX];
+    uint64_t fs[(READERS_MAX + 1) * FAIL_MAX];
+    int nfp = 0;
+
+    /* A resumed scan starts from the earlier sessions' counters; their failures come first. */
+    const ScanStats* b = pool->base;
+    if (b) {
+        files_read = b->files_read;
+        bytes_read = b->bytes_read;
+        rd_err = b->read_errors;
+        rd_tr = b->read_errors_transient;
+        rd_to = b->read_timeouts;
+        rt_def = b->retry_deferred;
+        rt_rec = b->retry_recovered;
+        ranged = b->ranged_files;
+        h_bytes = b->hash_bytes;
+        h_us = b->hash_us;
+        h_wait = b->hash_wait_us;
+        crc_us = b->crc_us;
+        ver_us = b->verify_us;
+        rs_us = b->retry_sleep_us;
+        smp_files = b->sample_files;
+        smp_regions = b->sample_regions;
+        smp_bytes = b->sample_bytes;
+        smp_span = b->sample_span_bytes;
+        cons = b->consistency_errors;
+        io_us = b->read_io_us;
+        busy_us = b->read_busy_us;
+        p_ops = b->perf_ops;
+        p_bytes = b->perf_bytes;
+        for (int k = 0; k < 5; k++) p_hist[k] = b->perf_hist[k];
+        p_stalls = b->perf_stalls;
+        p_stall_ms = b->perf_stall_total_ms;
+        lat_merge_all(lat, b->lat);
+        slow_rate = b->slow_rate;
+        slow_time = b->slow_time;
+        longest = b;
+        if (b->first_fail_set) {
+            first = b;
+            first_seq = 0;
+        }
+        for (int k = 0; k < b->fail_count && k < FAIL_MAX; k++) {
+            fp[nfp] = b->fail_paths[k];
+            fs[nfp] = 0;
+            nfp++;
+        }
+        rot_checked = b->bitrot_checked;
+        rot_files = b->bitrot_files;
+        rot_bytes = b->bitrot_bytes;
+        for (int k = 0; k < b->bitrot_count && nrot < BITROT_MAX; k++) rot[nrot++] = b->bitrot[k];
+        bad_files = b->bad_files;
+        bad_ext = b->bad_extents;
+        bad_bytes = b->bad_bytes;
+        bis_reads = b->bisect_reads;
+        bis_bytes = b->bisect_bytes;
+        bis_rec = b->bisect_recovered;
+        for (int k = 0; k < b->bad_count && nbad < BADFILE_MAX; k++) bad[nbad++] = b->bad[k];
+    }
+
+    for (int i = 0; i < pool->n; i++) {
+        ReaderShard* sh = pool->shards[i];
+        pthread_mutex_lock(&sh->lock);
+    }
+
+    for (int i = 0; i < pool->n; i++) {
+        const ShardView* v = &pool->shards[i]->view;
+        const ScanStats* s = &v->st;
+
+        if (s->dirs_total > wc.dirs_total) wc.dirs_total = s->dirs_total;
+        if (s->files_total > wc.files_total) wc.files_total = s->files_total;
+        if (s->skipped_dirs > wc.skipped_dirs) wc.skipped_dirs = s->skipped_dirs;
+        if (s->skipped_files > wc.skipped_files) wc.skipped_files = s->skipped_files;
+        if (s->open_errors > wc.open_errors) wc.open_errors = s->open_errors;
+        if (s->stat_errors > wc.stat_errors) wc.stat_errors = s->stat_errors;
+        if (s->path_errors > wc.path_errors) wc.path_errors = s->path_errors;
+        if (s->stats_avoided > wc.stats_avoided) wc.stats_avoided = s->stats_avoided;
+        if (s->stats_performed > wc.stats_performed) wc.stats_performed = s->stats_performed;
+        if (s->dir_enum_dirs > wc.dir_enum_dirs) wc.dir_enum_dirs = s->dir_enum_dirs;
+        if (s->dir_enum_entries > wc.dir_enum_entries) wc.dir_enum_entries = s->dir_enum_entries;
+        if (s->dir_enum_us > wc.dir_enum_us) wc.dir_enum_us = s->dir_enum_us;
+        if (s->bytes_total > wc.bytes_total) wc.bytes_total = s->bytes_total;
+        if (s->manifest_new > wc.mf_new) wc.mf_new = s->manifest_new;
+        if (s->manifest_changed > wc.mf_changed) wc.mf_changed = s->manifest_changed;
+        if (s->manifest_stale > wc.mf_stale) wc.mf_stale = s->manifest_stale;
+        if (s->manifest_unchanged > wc.mf_unchanged) wc.mf_unchanged = s->manifest_unchanged;
+        if (s->manifest_unchanged_bytes > wc.mf_unchanged_bytes) wc.mf_unchanged_bytes = s->manifest_unchanged_bytes;
+
+        files_read += s->files_read;
+        bytes_read += s->bytes_read;
+        rd_err += s->read_errors;
+        rd_tr += s->read_errors_transient;
+        rd_to += s->read_timeouts;
+        rt_def += s->retry_deferred;
+        rt_rec += s->retry_recovered;
+        ranged += s->ranged_files;
+        h_bytes += s->hash_bytes;
+        h_us += s->hash_us;
+        h_wait += s->hash_wait_us;
+        crc_us += s->crc_us;
+        ver_us += s->verify_us;
+        rs_us += s->retry_sleep_us;
+        smp_files += s->sample_files;
+        smp_regions += s->sample_regions;
+        smp_bytes += s->sample_bytes;
+        smp_span += s->sample_span_bytes;
+        b_full += s->budget_full;
+        b_sampled += s->budget_sampled;
+        b_skipped += s->budget_skipped;
+        b_skipped_bytes += s->budget_skipped_bytes;
+        if (s->budget_full + s->budget_sampled > 0 && (b_share_n == 0 || s->budget_share_min < b_share_min))
+            b_share_min = s->budget_share_min;
+        b_share_n += s->budget_full + s->budget_sampled;
+        b_share_sum += s->budget_share_sum;
+        cons += s->consistency_errors;
+        io_us += s->read_io_us;
+        busy_us += s->read_busy_us;
+        wait_us += s->walk_wait_us;
+        p_ops += s->perf_ops;
+        p_bytes += s->perf_bytes;
+        for (int k = 0; k < 5; k++) p_hist[k] += s->perf_hist[k];
+        p_stalls += s->perf_stalls;
+        p_stall_ms += s->perf_stall_total_ms;
+        lat_merge_all(lat, s->lat);
+        slow_merge(&slow_rate, &s->slow_rate);
+        slow_merge(&slow_time, &s->slow_time);
+        rot_checked += s->bitrot_checked;
+        rot_files += s->bitrot_files;
+        rot_bytes += s->bitrot_bytes;
+        for (int k = 0; k < s->bitrot_count && nrot < BITROT_MAX; k++) rot[nrot++] = s->bitrot[k];
+        bad_files += s->bad_files;
+        bad_ext += s->bad_extents;
+        bad_bytes += s->bad_bytes;
+        bis_reads += s->bisect_reads;
+        bis_bytes += s->bisect_bytes;
+        bis_rec += s->bisect_recovered;
+        for (int k = 0; k < s->bad_count && nbad < BADFILE_MAX; k++) bad[nbad++] = s->bad[k];
+        if (!longest || s->perf_longest_ms > longest->perf_longest_ms) longest = s;
+
+        if (s->first_fail_set && v->first_fail_seq < first_seq) {
+            first = s;
+            first_seq = v->first_fail_seq;
+        }
+        if (v->busy && v->cur_seq < cur_seq) {
+            cur = s;
+            cur_seq = v->cur_seq;
+        }
+        for (int k = 0; k < s->fail_count && k < FAIL_MAX; k++) {
+            fp[nfp] = s->fail_paths[k];
+            fs[nfp] = v->fail_seq[k];
+            nfp++;
+        }
+
+        st->worker_files[i] = s->files_read;
+        st->worker_bytes[i] = s->bytes_read;
+        st->worker_busy_us[i] = s->read_busy_us;
+
+        /* New error lines since the last merge (at most a ring's worth per shard). */
+        int from = pool->shards[i]->err_seen;
+        if (s->err_ring_count - from > ERR_RING_MAX) from = s->err_ring_count - ERR_RING_MAX;
+        for (int k = from; k < s->err_ring_count; k++) err_ring_put(st, s->err_ring[k % ERR_RING_MAX]);
+        pool->shards[i]->err_seen = s->err_ring_count;
+    }
+
+    walk_counts_apply(st, &wc);
+    st->files_read = files_read;
+    st->bytes_read = bytes_read;
+    st->read_errors = rd_err;
+    st->read_errors_transient = rd_tr;
+    st->read_timeouts = rd_to;
+    st->retry_deferred = rt_def;
+    st->retry_recovered = rt_rec;
+    st->ranged_files = ranged;
+    st->hash_bytes = h_bytes;
+    st->hash_us = h_us;
+    st->hash_wait_us = h_wait;
+    st->crc_us = crc_us;
+    st->verify_us = ver_us;
+    st->retry_sleep_us = rs_us;
+    st->sample_files = smp_files;
+    st->sample_regions = smp_regions;
+    st->sample_bytes = smp_bytes;
+    st->sample_span_bytes = smp_span;
+    st->budget_full = b_full;
+    st->budget_sampled = b_sampled;
+    st->budget_skipped = b_skipped;
+    st->budget_skipped_bytes = b_skipped_bytes;
+    st->budget_share_min = b_share_min;
+    st->budget_share_sum = b_share_sum;
+    st->consistency_errors = cons;
+    st->read_io_us = io_us;
+    st->read_busy_us = busy_us;
+    st->walk_wait_us = pool->n ? wait_us / (uint64_t)pool->n : 0;
+    st->perf_ops = p_ops;
+    st->perf_bytes = p_bytes;
+    for (int k = 0; k < 5; k++) st->perf_hist[k] = p_hist[k];
+    st->perf_stalls = p_stalls;
+    st->perf_stall_total_ms = p_stall_ms;
+    memcpy(st->lat, lat, sizeof(st->lat));
+    st->slow_rate = slow_rate;
+    st->slow_time = slow_time;
+    st->bitrot_checked = rot_checked;
+    st->bitrot_files = rot_files;
+    st->bitrot_bytes = rot_bytes;
+    st->bitrot_count = nrot;
+    for (int k = 0; k < nrot; k++) st->bitrot[k] = rot[k];
+    st->bad_files = bad_files;
+    st->bad_extents = bad_ext;
+    st->bad_bytes = bad_bytes;
+    st->bisect_reads = bis_reads;
+    st->bisect_bytes = bis_bytes;
+    st->bisect_recovered = bis_rec;
+    st->bad_count = nbad;
+    for (int k = 0; k < nbad; k++) st->bad[k] = bad[k];
+    if (longest) {
+        st->perf_longest_ms = longest->perf_longest_ms;
+        st->perf_longest_mib_s = longest->perf_longest_mib_s;
+        st->perf_longest_off = longest->perf_longest_off;
+        st->perf_longest_bytes = longest->perf_longest_bytes;
+        snprintf(st->perf_longest_path, sizeof(st->perf_longest_path), "%s", longest->perf_longest_path);
+    }
+
+    if (first) {
+        st->first_fail_set = true;
+        snprintf(st->first_fail_kind, sizeof(st->first_fail_kind), "%s", first->first_fail_kind);
+        snprintf(st->first_fail_path, sizeof(st->first_fail_path), "%s", first->first_fail_path);
+        st->first_fail_off = first->first_fail_off;
+        st->first_fail_bytes = first->first_fail_bytes;
+        st->first_fail_errno = first->first_fail_errno;
+        snprintf(st->first_fail_note, sizeof(st->first_fail_note), "%s", first->first_fail_note);
+    }
+
+    st->fail_count = 0;
+    bool used[(READERS_MAX + 1) * FAIL_MAX] = {0};
+    while (st->fail_count < FAIL_MAX) {
+        int best = -1;
+        for (int k = 0; k < nfp; k++) {
+            if (!used[k] && (best < 0 || fs[k] < fs[best])) best = k;
+        }
+        if (best < 0) break;
+        used[best] = true;
+        bool dup = false;
+        for (int k = 0; k < st->fail_count; k++) {
+            if (strcmp(st->fail_paths[k], fp[best]) == 0) { dup = true; break; }
+        }
+        if (!dup) snprintf(st->fail_paths[st->fail_count++], sizeof(st->fail_paths[0]), "%s", fp[best]);
+    }
+
+    if (cur) {
+        snprintf(st->current_path, sizeof(st->current_path), "%s", cur->current_path);
+        st->current_size = cur->current_size;
+        st->current_planned = cur->current_planned;
+        st->current_done = cur->current_done;
+        st->current_sample = cur->current_sample;
+    }
+
+    /* Checkpoint: the cursors are consistent with the counters only while the locks are held. */
+    ScanJournal* j = pool->journal;
+    bool checkpoint = j && (pool->journal_force || journal_due(j));
+    if (checkpoint) {
+        journal_collect_begin(j);
+        for (int i = 0; i < pool->n; i++) journal_collect(j, &pool->shards[i]->view.cursor, &pool->shards[i]->view.st);
+    }
+
+    for (int i = pool->n - 1; i >= 0; i--) pthread_mutex_unlock(&pool->shards[i]->lock);
+    if (pool->plan) plan_publish(pool->plan, st);
+    if (checkpoint) journal_write(j, st);
+}
+
+void pool_free(ScanPool* pool) {
+    for (int i = 0; i < pool->n; i++) {
+        ReaderShard* sh = pool->shards[i];
+        if (!sh) continue;
+        scan_buffers_free(&sh->bufs);
+        manifest_builder_free(&sh->mf);
+        pthread_mutex_destroy(&sh->lock);
+        free(sh);
+        pool->shards[i] = NULL;
+    }
+    pool->n = 0;
+}
+
+int pool_start(ScanPool* pool, const ScanConfig* cfg, ChunkTuner* tune, BudgetPlan* plan, WorkQueue* q, int want,
+               const ScanStats* base, ScanJournal* journal) {
+    memset(pool, 0, sizeof(*pool));
+    pool->cfg = cfg;
+    pool->tune = tune;
+    pool->plan = plan;
+    pool->q = q;
+    pool->base = base;
+    pool->journal = journal;
+    atomic_init(&pool->ui_beat_ms, now_ms());
+    atomic_init(&pool->cancel, false);
+    atomic_init(&pool->drained, false);
+    atomic_init(&pool->active, 0);
+
+    for (int i = 0; i < want && i < READERS_MAX; i++) {
+        ReaderShard* sh = (ReaderShard*)calloc(1, sizeof(*sh));
+        if (!sh) break;
+        if (!scan_buffers_init(&sh->bufs, cfg)) {
+            free(sh);
+            break;
+        }
+        sh->pool = pool;
+        sh->id = pool->n;
+        pthread_mutex_init(&sh->lock, NULL);
+        pool->shards[pool->n++] = sh;
+
+        atomic_fetch_add_explicit(&pool->active, 1, memory_order_relaxed);
+        if (!worker_start(&sh->thread, reader_main, sh, WORKER_CORE_DEFAULT, 0x20000)) {
+            atomic_fetch_sub_explicit(&pool->active, 1, memory_order_relaxed);
+            pool->n--;
+            scan_buffers_free(&sh->bufs);
+            pthread_mutex_destroy(&sh->lock);
+            free(sh);
+            pool->shards[pool->n] = NULL;
+            break;
+        }
+    }
+    return pool->n;
+}
+
+void pool_run_ui(ScanPool* pool, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update) {
+    for (;;) {
+        pool_merge(pool, st);
+        timeline_sample(st);
+        if (ui_update) ui_update(st, pad, false);
+        atomic_store_explicit(&pool->ui_beat_ms, now_ms(), memory_order_relaxed);
+        if (st->cancelled) {
+            atomic_store_explicit(&pool->cancel, true, memory_order_relaxed);
+            atomic_store_explicit(&pool->q->stop, true, memory_order_relaxed);
+        }
+        if (atomic_load_explicit(&pool->active, memory_order_acquire) == 0) break;
+        svcSleepThread(10 * 1000 * 1000);
+    }
+    for (int i = 0; i < pool->n; i++) worker_join(&pool->shards[i]->thread);
+    pool_merge(pool, st);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "journal.h"
+#include "retry.h"
+
+/*
+ * Each reader writes only its own ScanStats shard and publishes a copy of it (about every
+ * 50 ms) under the shard lock; the UI thread merges the copies into the caller's stats.
+ * Counters are summed, walker counters taken from the newest snapshot, and the first
+ * failure / failing paths ordered by item sequence, so they match a serial scan.
+ */
+typedef struct ScanPool ScanPool;
+
+typedef struct {
+    ScanStats st;
+    uint64_t  first_fail_seq;
+    uint64_t  fail_seq[FAIL_MAX];
+    uint64_t  cur_seq;
+    bool      busy;
+    ResumeCursor cursor;
+} ShardView;
+
+typedef struct {
+    ScanStats       st;          /* first member: reader_tick() gets &st back from the read path */
+    ScanPool*       pool;
+    ScanBuffers     bufs;
+    WorkerThread    thread;
+    uint64_t        first_fail_seq;
+    uint64_t        fail_seq[FAIL_MAX];
+    uint64_t        cur_seq;
+    bool            busy;
+    ResumeCursor    cursor;      /* resume journal: last item taken */
+    ManifestBuilder mf;          /* files this reader verified (manifest) */
+    RetryQueue      retry;       /* regions this reader deferred */
+    uint64_t        pub_last_ms;
+    pthread_mutex_t lock;        /* guards view */
+    ShardView       view;
+    int             err_seen;    /* UI thread: view.st.err_ring_count already merged */
+    int             id;          /* 0-based; names the thread in a trace */
+} ReaderShard;
+
+struct ScanPool {
+    const ScanConfig* cfg;
+    ChunkTuner*       tune;
+    BudgetPlan*       plan;
+    WorkQueue*        q;
+    _Atomic uint64_t  ui_beat_ms;  /* UI thread heartbeat (see reader_tick) */
+    atomic_bool       cancel;
+    atomic_bool       drained;   /* END taken: no further items */
+    atomic_int        active;    /* readers still running */
+    int               n;
+    ReaderShard*      shards[READERS_MAX];
+    const ScanStats*  base;      /* resumed scan: counters of the earlier sessions */
+    ScanJournal*      journal;   /* checkpoints are taken in pool_merge */
+    bool              journal_force;
+};
+
+/* Starts up to 'want' readers on the queue. Returns how many are running. */
+int pool_start(ScanPool* pool, const ScanConfig* cfg, ChunkTuner* tune, BudgetPlan* plan, WorkQueue* q, int want,
+               const ScanStats* base, ScanJournal* journal);
+/* UI thread while the pool runs: merge, draw, forward cancel; returns once all readers exited. */
+void pool_run_ui(ScanPool* pool, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update);
+/* UI thread: folds the published shard views into the caller's stats. */
+void pool_merge(ScanPool* pool, ScanStats* st);
+void pool_free(ScanPool* pool);
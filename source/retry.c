@@ -0,0 +1,283 @@
+#include "retry.h"
+#include "util.h"
+#include "log.h"
+#include "crc32.h"
+
+void retry_queue_free(RetryQueue* q) {
+    if (!q) return;
+    for (int i = 0; i < q->count; i++) free(q->ents[i].path);
+    free(q->ents);
+    for (int i = 0; i < q->nfiles; i++) free(q->files[i].path);
+    free(q->files);
+    memset(q, 0, sizeof(*q));
+}
+
+static uint64_t retry_backoff_us(const ScanConfig* cfg, int attempts) {
+    uint64_t ms = cfg ? (uint64_t)cfg->retry_backoff_ms : 30;
+    if (attempts > 1) ms <<= (attempts - 1 < 8 ? attempts - 1 : 8);
+    return ms * 1000ull;
+}
+
+void retry_sleep(const ScanConfig* cfg, int attempt, ScanStats* st) {
+    uint64_t us = retry_backoff_us(cfg, attempt + 1);
+    svcSleepThread((int64_t)us * 1000);
+    st->retry_sleep_us += us;
+}
+
+bool retry_reserve(RetryQueue* q, const ScanConfig* cfg, int n) {
+    if (!q || !cfg || !cfg->retry_defer || cfg->read_retries <= 0 || !q->cur_path) return false;
+    if (q->count + n > RETRY_QUEUE_MAX) {
+        if (!q->full_logged) {
+            q->full_logged = true;
+            log_pushf("WARN", "Retry queue full (%d regions); further failures are retried in place.", RETRY_QUEUE_MAX);
+        }
+        return false;
+    }
+    if (q->count + n > q->cap) {
+        int ncap = q->cap ? q->cap : 16;
+        while (ncap < q->count + n) ncap *= 2;
+        if (ncap > RETRY_QUEUE_MAX) ncap = RETRY_QUEUE_MAX;
+        RetryEntry* ne = (RetryEntry*)realloc(q->ents, (size_t)ncap * sizeof(*ne));
+        if (!ne) return false;
+        q->ents = ne;
+        q->cap = ncap;
+    }
+    return true;
+}
+
+bool retry_defer(RetryQueue* q, const ScanConfig* cfg, uint64_t off, uint64_t len, int e, bool sample) {
+    if (len == 0 || !retry_reserve(q, cfg, 1)) return false;
+    char* path = strdup(q->cur_path);
+    if (!path) return false;
+    RetryEntry* r = &q->ents[q->count++];
+    memset(r, 0, sizeof(*r));
+    r->path = path;
+    r->be = q->cur_be;
+    r->seq = q->cur_seq;
+    r->off = off;
+    r->len = len;
+    r->reg_off = off;
+    r->reg_len = len;
+    r->sample = sample;
+    r->attempts = 1;
+    r->last_errno = e ? e : EIO;
+    r->due_us = now_us() + retry_backoff_us(cfg, 1);
+    q->cur_deferred++;
+    return true;
+}
+
+void retry_forget_file(RetryQueue* q) {
+    while (q->cur_deferred > 0 && q->count > 0) {
+        free(q->ents[--q->count].path);
+        q->cur_deferred--;
+    }
+}
+
+void retry_hold_file(RetryQueue* q, const WorkItem* it, uint64_t fsize, uint32_t crc) {
+    if (q->nfiles == q->files_cap) {
+        int ncap = q->files_cap ? q->files_cap * 2 : 8;
+        RetryFile* nf = (RetryFile*)realloc(q->files, (size_t)ncap * sizeof(*nf));
+        if (!nf) return;
+        q->files = nf;
+        q->files_cap = ncap;
+    }
+    char* path = strdup(it->path);
+    if (!path) return;
+    RetryFile* f = &q->files[q->nfiles++];
+    f->path = path;
+    f->seq = it->seq;
+    f->size = fsize;
+    f->mtime = it->mtime;
+    f->base = it->base;
+    f->crc = crc;
+}
+
+/* After the drain: a held file whose regions all came back gets its CRC patched and is recorded. */
+static void retry_record_files(ScanRun* run, const RetryQueue* q) {
+    for (int i = 0; i < q->nfiles; i++) {
+        const RetryFile* f = &q->files[i];
+        uint32_t crc = f->crc;
+        bool all = true;
+        int n = 0;
+        for (int k = 0; k < q->count && all; k++) {
+            const RetryEntry* e = &q->ents[k];
+            if (e->seq != f->seq || e->sample || strcmp(e->path, f->path) != 0) continue;
+            n++;
+            if (!e->ok) all = false;
+            /* zeros -> data: XOR in the CRC difference, shifted past the rest of the file */
+            else crc ^= crc32_combine(e->crc ^ crc32_zeros(e->reg_len), 0, f->size - e->reg_off - e->reg_len);
+        }
+        if (!all || n == 0) continue;
+        HashDigest none;
+        memset(&none, 0, sizeof(none));
+        none.algo = HASH_CRC32;
+        file_verified(run, f->path, f->size, f->mtime, f->base, crc, &none);
+    }
+}
+
+
+/* One more attempt at a queued region through a fresh handle. True: read back completely. */
+static bool retry_attempt(ScanRun* run, RetryEntry* e) {
+    ScanStats* st = run->st;
+    ScanBuffers* bufs = run->bufs;
+    size_t cap = bufs->sample_cap;
+    IoFile f;
+    if (!bufs->sample_buf) return false;
+    if (!op_open(e->be, e->path, &f, st->lat)) {
+        e->last_errno = errno ? errno : EIO;
+        return false;
+    }
+    bool ok = true;
+    while (e->len > 0 && !st->cancelled) {
+        size_t want = (e->len < cap) ? (size_t)e->len : cap;
+        size_t r = 0;
+        uint64_t t0 = now_us();
+        bool rd_ok = guarded_pread(&bufs->guard, &f, e->path, &bufs->sample_buf, cap, want, e->off, &r);
+        uint64_t dt = now_us() - t0;
+        int err = errno;
+        if (!f.be) {
+            e->timed_out = (err == ETIMEDOUT);
+            e->last_errno = err;
+            ok = false;
+            break;
+        }
+        if (r > 0) {
+            perf_record(st, r, dt, e->off, e->path);
+            st->bytes_read += r;
+            e->crc = crc32_update(e->crc, bufs->sample_buf, r);
+            e->off += r;
+            e->len -= r;
+        }
+        if (!rd_ok || r == 0) {
+            e->last_errno = rd_ok ? EIO : (err ? err : EIO);   /* r == 0: the file shrank */
+            ok = false;
+            break;
+        }
+    }
+    op_close(&f, e->path, st->lat);
+    return ok && e->len == 0;
+}
+
+/*
+ * A file counts one read error, as when the read stopped at its first failed region. Without
+ * bisection, once a region fails for good the file's other pending regions (adjacent in the
+ * queue) are dropped; with it they are still read, and reported once (retry_report).
+ */
+static int retry_drop_siblings(RetryQueue* q, int i) {
+    const RetryEntry* e = &q->ents[i];
+    int n = 0;
+    for (int d = -1; d <= 1; d += 2) {
+        for (int k = i + d; k >= 0 && k < q->count; k += d) {
+            RetryEntry* o = &q->ents[k];
+            if (o->seq != e->seq || strcmp(o->path, e->path) != 0) break;
+            if (o->done) continue;
+            o->done = true;
+            o->dropped = true;
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+ * Region failed for good: locate its bad extents and read the rest of it. False: bisection off.
+ * When every block of it read after all, the region counts as read back (e->salvaged); its data
+ * was not hashed, so the file still gets no CRC.
+ */
+static bool retry_salvage(ScanRun* run, RetryQueue* q, RetryEntry* e) {
+    Bisect b;
+    IoFile f;
+    if (!bisect_init(&b, &f, e->path, run->cfg, run->st, &q->bad, &run->bufs->guard, &run->bufs->sample_buf, run->bufs->sample_cap)) return false;
+    if (!op_open(e->be, e->path, &f, run->st->lat)) return true;
+    uint64_t bad0 = q->bad.e.bad_bytes;
+    bisect_salvage(&b, e->off, e->len, (e->len < b.cap) ? e->len : b.cap, NULL);
+    op_close(&f, e->path, run->st->lat);
+    if (!b.gone && !run->st->cancelled && q->bad.e.bad_bytes == bad0) {
+        e->salvaged = true;
+        run->st->retry_recovered++;
+    }
+    bad_file_flush(run->st, &q->bad);
+    return true;
+}
+
+void retry_drain(ScanRun* run, RetryQueue* q) {
+    ScanStats* st = run->st;
+    const ScanConfig* cfg = run->cfg;
+    if (!q || q->count == 0) return;
+    st->retry_deferred += (uint64_t)q->count;
+    guard_bind(&run->bufs->guard, st, run->ui_update, run->pad);
+
+    int pending = q->count;
+    while (pending > 0 && !st->cancelled) {
+        uint64_t now = now_us();
+        uint64_t next = UINT64_MAX;
+        for (int i = 0; i < q->count && !st->cancelled; i++) {
+            RetryEntry* e = &q->ents[i];
+            if (e->done) continue;
+            if (e->due_us > now) {
+                if (e->due_us < next) next = e->due_us;
+                continue;
+            }
+            snprintf(st->current_path, sizeof(st->current_path), "%.250s", e->path);
+            st->current_sample = e->sample;
+            if (retry_attempt(run, e)) {
+                e->done = true;
+                e->ok = true;
+                st->retry_recovered++;
+                pending--;
+            } else if (e->timed_out) {
+                e->done = true;
+                pending--;
+                pending -= retry_drop_siblings(q, i);
+            } else if (!st->cancelled) {
+                e->attempts++;
+                if (e->attempts > cfg->read_retries) {
+                    e->done = true;
+                    pending--;
+                    if (!retry_salvage(run, q, e)) pending -= retry_drop_siblings(q, i);
+                } else {
+                    st->read_errors_transient++;
+                    e->due_us = now_us() + retry_backoff_us(cfg, e->attempts);
+                    if (e->due_us < next) next = e->due_us;
+                }
+            }
+            if (run->ui_update) run->ui_update(st, run->pad, false);
+            now = now_us();
+        }
+        if (pending > 0 && next != UINT64_MAX && next > now) {
+            uint64_t wait = next - now;
+            if (wait > 20000) wait = 20000;   /* keep the UI going */
+            svcSleepThread((int64_t)wait * 1000);
+            st->retry_sleep_us += wait;
+            if (run->ui_update) run->ui_update(st, run->pad, false);
+        }
+    }
+    /* Cancelled: what is left counts as failed, one region per file. */
+    for (int i = 0; i < q->count; i++) {
+        if (q->ents[i].done) continue;
+        q->ents[i].done = true;
+        retry_drop_siblings(q, i);
+    }
+    retry_record_files(run, q);
+}
+
+void retry_report(ScanStats* st, const RetryQueue* q, int i) {
+    const RetryEntry* e = &q->ents[i];
+    if (e->ok || e->dropped || e->salvaged) return;
+    for (int k = i - 1; k >= 0; k--) {
+        const RetryEntry* o = &q->ents[k];
+        if (o->seq != e->seq || strcmp(o->path, e->path) != 0) break;
+        if (!o->ok && !o->dropped && !o->salvaged) return;   /* the file is already reported */
+    }
+    if (e->timed_out) {
+        timeout_record(st, e->path, e->off, e->len, "retry read");
+        return;
+    }
+    st->read_errors++;
+    first_fail_capture(st, "READ", e->path, e->off, e->len, e->last_errno, e->sample ? "read_region (retried)" : "full read (retried)");
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s read error @ %llu after %d deferred attempt(s): %s", e->sample ? "Sample" : "Full",
+             (unsigned long long)e->off, e->attempts, strerror(e->last_errno));
+    err_push(st, msg);
+    fail_push_unique(st, e->path);
+}
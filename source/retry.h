@@ -0,0 +1,80 @@
+#pragma once
+#include "bisect.h"
+
+/*
+ * With read_retries > 0 and retry_defer on, a failed read does not sleep and retry in place:
+ * the region goes onto the reader's retry queue and the read goes on past it, so healthy data
+ * keeps streaming. The queue is drained when the reader runs out of work; entries are retried
+ * round-robin, each retry_backoff_ms after its last attempt, doubled per attempt. Counting is
+ * unchanged: a failed attempt that gets another try is transient, a failed last attempt is a
+ * read error. A full read defers only the failed chunk and CRCs zeros in its place; the file is
+ * held on the queue and, once every region is read back, its CRC is patched with theirs and it
+ * is compared and recorded in the manifest like any other (CRC only: a content hash does not
+ * patch).
+ */
+#define RETRY_QUEUE_MAX 512          /* per reader; beyond it failures are retried in place */
+
+typedef struct {
+    char*            path;
+    const IoBackend* be;
+    uint64_t         seq;            /* item order: reports keep traversal order */
+    uint64_t         off;            /* not yet read back: [off, off + len) */
+    uint64_t         len;
+    bool             sample;         /* region of a sampled file (else of a full read) */
+    int              attempts;       /* failed so far */
+    int              last_errno;
+    uint64_t         due_us;
+    bool             done;
+    bool             ok;
+    bool             dropped;        /* another region of the file failed for good */
+    bool             timed_out;      /* a retry hit the read deadline: the file is skipped */
+    bool             salvaged;       /* failed for good, but bisection read every block of it */
+    uint64_t         reg_off;        /* the region as queued */
+    uint64_t         reg_len;
+    uint32_t         crc;            /* of what was read back so far */
+} RetryEntry;
+
+/* A full read with deferred regions, waiting for them to be read back. */
+typedef struct {
+    char*                path;
+    uint64_t             seq;
+    uint64_t             size;
+    int64_t              mtime;
+    const ManifestEntry* base;
+    uint32_t             crc;        /* the deferred regions read as zeros */
+} RetryFile;
+
+struct RetryQueue {
+    RetryEntry*      ents;
+    int              count;
+    int              cap;
+    /* File being read (set before each read) */
+    const char*      cur_path;
+    const IoBackend* cur_be;
+    uint64_t         cur_seq;
+    int              cur_deferred;   /* regions of that file queued */
+    BadFileAcc       bad;            /* its unreadable extents (bisection) */
+    bool             full_logged;
+    RetryFile*       files;
+    int              nfiles;
+    int              files_cap;
+};
+
+void retry_queue_free(RetryQueue* q);
+/* In-place retry (retry_defer off, or the queue is full). */
+void retry_sleep(const ScanConfig* cfg, int attempt, ScanStats* st);
+/* Room for n more entries. False: deferral unavailable (off, no retries, full or out of memory). */
+bool retry_reserve(RetryQueue* q, const ScanConfig* cfg, int n);
+/* Queues [off, off + len) of the current file after its first failed attempt. False: not queued,
+   the caller retries in place. */
+bool retry_defer(RetryQueue* q, const ScanConfig* cfg, uint64_t off, uint64_t len, int e, bool sample);
+/* Drops the current file's queued regions. */
+void retry_forget_file(RetryQueue* q);
+/* A full read with deferred regions waits on the queue for them (no room: it goes unrecorded). */
+void retry_hold_file(RetryQueue* q, const WorkItem* it, uint64_t fsize, uint32_t crc);
+/* Reads the queued regions back, round-robin: an entry is tried when its backoff has passed, so
+   the waits of different regions overlap. Outcomes are only recorded here; retry_report() turns
+   them into errors in queue order. */
+void retry_drain(ScanRun* run, RetryQueue* q);
+/* A region that was not read back is a read error (also when a cancel cut its retries short). */
+void retry_report(ScanStats* st, const RetryQueue* q, int i);
@@ -1,29 +1,17 @@
-#include "scan_engine.h"
+#include "scan_internal.h"
 #include "util.h"
 #include "log.h"
-
-/* --------------------------------------------------------------------------
-   CRC32
-----------------------------------------------------------------------------*/
-static uint32_t crc32_table[256];
-static bool crc32_ready = false;
-
-static void crc32_init(void) {
-    if (crc32_ready) return;
-    for (uint32_t i = 0; i < 256; i++) {
-        uint32_t c = i;
-        for (int k = 0; k < 8; k++) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
-        crc32_table[i] = c;
-    }
-    crc32_ready = true;
-}
-
-static uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
-    const uint8_t* p = (const uint8_t*)data;
-    crc = ~crc;
-    for (size_t i = 0; i < len; i++) crc = crc32_table[(crc ^ p[i]) & 0xFFu] ^ (crc >> 8);
-    return ~crc;
-}
+#include "worker.h"
+#include "crc32.h"
+#include "manifest.h"
+#include "hash.h"
+#include "bisect.h"
+#include "retry.h"
+#include "budget.h"
+#include "journal.h"
+#include "pool.h"
+
+#include <stdatomic.h>
 
 /* --------------------------------------------------------------------------
    Small utilities
@@ -36,15 +24,50 @@ uint64_t scan_stats_elapsed_ms(const ScanStats* st, uint64_t now) {
     return (base > paused) ? (base - paused) : 0;
 }
 
-static void err_push(ScanStats* st, const char* msg) {
-    if (!st || !msg) return;
+const char* scan_phase_name(ScanPhase p) {
+    switch (p) {
+        case PHASE_TRAVERSAL:   return "traversal";
+        case PHASE_STAT:        return "stat";
+        case PHASE_OPEN:        return "open/close";
+        case PHASE_READ:        return "read";
+        case PHASE_HASH:        return "hash/CRC";
+        case PHASE_VERIFY:      return "consistency";
+        case PHASE_RETRY_SLEEP: return "retry sleep";
+        case PHASE_UI:          return "UI update";
+        case PHASE_PAD:         return "pad polling";
+        case PHASE_PAUSE:       return "pause";
+        default:                return "?";
+    }
+}
+
+void scan_phase_times(const ScanStats* st, uint64_t us[PHASE_COUNT]) {
+    const LatHist* l = st->lat;
+    uint64_t rd = l[OP_READ].total_us;
+    us[PHASE_TRAVERSAL] = l[OP_OPENDIR].total_us + l[OP_READDIR].total_us;
+    us[PHASE_STAT] = l[OP_STAT].total_us;
+    us[PHASE_OPEN] = l[OP_OPEN].total_us + l[OP_CLOSE].total_us;
+    us[PHASE_READ] = rd > st->verify_us ? rd - st->verify_us : 0;
+    us[PHASE_HASH] = st->hash_us + st->crc_us;
+    us[PHASE_VERIFY] = st->verify_us;
+    us[PHASE_RETRY_SLEEP] = st->retry_sleep_us;
+    us[PHASE_UI] = st->ui_us;
+    us[PHASE_PAD] = st->pad_us;
+    us[PHASE_PAUSE] = st->paused_total_ms * 1000;
+}
+
+void err_ring_put(ScanStats* st, const char* msg) {
     int idx = st->err_ring_count % ERR_RING_MAX;
     snprintf(st->err_ring[idx], sizeof(st->err_ring[idx]), "%s", msg);
     st->err_ring_count++;
+}
+
+void err_push(ScanStats* st, const char* msg) {
+    if (!st || !msg) return;
+    err_ring_put(st, msg);
     log_push("ERROR", msg);
 }
 
-static void fail_push_unique(ScanStats* st, const char* path) {
+void fail_push_unique(ScanStats* st, const char* path) {
     if (!st || !path || !path[0]) return;
     char t[256];
     snprintf(t, sizeof(t), "%.250s", path);
@@ -58,16 +81,52 @@ static void fail_push_unique(ScanStats* st, const char* path) {
     }
 }
 
-static void largest_update(ScanStats* st, const char* path, uint64_t size) {
-    if (!st || !path || !path[0]) return;
+/* A full read that no longer matches the CRC (or digest) recorded for the same size and mtime.
+   digest: set when only the content digest differs. */
+static void bitrot_push(ScanStats* st, const char* path, uint64_t size, uint32_t crc, const ManifestEntry* base, const HashDigest* digest) {
+    st->bitrot_files++;
+    st->bitrot_bytes += size;
+    if (st->bitrot_count < BITROT_MAX) {
+        BitrotEntry* b = &st->bitrot[st->bitrot_count++];
+        b->crc = crc;
+        b->recorded = base->crc;
+        b->verified_at = base->verified_at;
+        b->size = size;
+        snprintf(b->path, sizeof(b->path), "%.250s", path);
+    }
+
+    char when[16] = "?";
+    time_t t = (time_t)base->verified_at;
+    struct tm tmv;
+    if (localtime_r(&t, &tmv)) strftime(when, sizeof(when), "%Y-%m-%d", &tmv);
+    char msg[256];
+    if (digest) {
+        char hex[2 * HASH_DIGEST_MAX + 1];
+        hash_hex(hex, sizeof(hex), digest);
+        snprintf(msg, sizeof(msg), "Bit-rot: %s %.16s.. differs from %s (CRC equal, size and mtime unchanged): %.120s",
+                 hash_algo_name(digest->algo), hex, when, path);
+    } else {
+        snprintf(msg, sizeof(msg), "Bit-rot: CRC %08X, was %08X on %s (size and mtime unchanged): %.150s",
+                 (unsigned int)crc, (unsigned int)base->crc, when, path);
+    }
+    err_push(st, msg);
+    fail_push_unique(st, path);
+}
+
+/* Keeps tab[] sorted by size (descending); ties keep the earlier path. A path already listed is ignored. */
+static void largest_update(LargestEntry* tab, int* count, const char* path, uint64_t size) {
+    if (!tab || !count || !path || !path[0]) return;
     if (size == 0) return;
 
-    int n = st->largest_count;
+    int n = *count;
     if (n < 0) n = 0;
+    for (int i = 0; i < n; i++) {
+        if (tab[i].size == size && strncmp(tab[i].path, path, sizeof(tab[i].path) - 1) == 0) return;
+    }
 
     int pos = -1;
     for (int i = 0; i < n; i++) {
-        if (size > st->largest[i].size) { pos = i; break; }
+        if (size > tab[i].size) { pos = i; break; }
     }
     if (pos < 0) {
         if (n < LARGEST_MAX) pos = n;
@@ -75,14 +134,14 @@ static void largest_update(ScanStats* st, const char* path, uint64_t size) {
     }
 
     if (n < LARGEST_MAX) n++;
-    for (int i = n - 1; i > pos; i--) st->largest[i] = st->largest[i - 1];
+    for (int i = n - 1; i > pos; i--) tab[i] = tab[i - 1];
 
-    st->largest[pos].size = size;
-    snprintf(st->largest[pos].path, sizeof(st->largest[pos].path), "%.250s", path);
-    st->largest_count = n;
+    tab[pos].size = size;
+    snprintf(tab[pos].path, sizeof(tab[pos].path), "%.250s", path);
+    *count = n;
 }
 
-static void first_fail_capture(ScanStats* st, const char* kind, const char* path, uint64_t off, uint64_t bytes, int err, const char* note) {
+void first_fail_capture(ScanStats* st, const char* kind, const char* path, uint64_t off, uint64_t bytes, int err, const char* note) {
     if (!st || st->first_fail_set) return;
     st->first_fail_set = true;
     snprintf(st->first_fail_kind, sizeof(st->first_fail_kind), "%s", kind ? kind : "FAIL");
@@ -93,8 +152,10 @@ static void first_fail_capture(ScanStats* st, const char* kind, const char* path
     snprintf(st->first_fail_note, sizeof(st->first_fail_note), "%s", note ? note : "");
 }
 
-static void perf_record(ScanStats* st, uint64_t bytes, uint64_t dt_ms, uint64_t off, const char* path) {
+void perf_record(ScanStats* st, uint64_t bytes, uint64_t dt_us, uint64_t off, const char* path) {
     if (!st || bytes == 0) return;
+    st->read_io_us += dt_us;
+    uint64_t dt_ms = dt_us / 1000;
     if (dt_ms == 0) dt_ms = 1;
 
     double secs = (double)dt_ms / 1000.0;
@@ -126,6 +187,46 @@ static void perf_record(ScanStats* st, uint64_t bytes, uint64_t dt_ms, uint64_t
     }
 }
 
+/* --------------------------------------------------------------------------
+   Tracked file-system operations (stall watchdog, latency histograms)
+----------------------------------------------------------------------------*/
+/* lat: the calling thread's histograms (ScanStats.lat or the walker's), or NULL. */
+bool op_open(const IoBackend* be, const char* path, IoFile* f, LatHist* lat) {
+    OpScope o;
+    op_enter(&o, OP_OPEN, path, 0, 0);
+    bool ok = io_open(be, path, f);
+    op_leave(&o, lat);
+    return ok;
+}
+
+void op_close(IoFile* f, const char* path, LatHist* lat) {
+    if (!f->be) return;
+    OpScope o;
+    op_enter(&o, OP_CLOSE, path, 0, 0);
+    io_close(f);
+    op_leave(&o, lat);
+}
+
+static bool op_stat(const IoBackend* be, const char* path, IoStat* out, LatHist* lat) {
+    OpScope o;
+    op_enter(&o, OP_STAT, path, 0, 0);
+    bool ok = io_stat(be, path, out);
+    op_leave(&o, lat);
+    return ok;
+}
+
+static bool op_mtime(const IoBackend* be, const char* path, int64_t* out, LatHist* lat) {
+    OpScope o;
+    op_enter(&o, OP_STAT, path, 0, 0);
+    bool ok = io_mtime(be, path, out);
+    op_leave(&o, lat);
+    return ok;
+}
+
+void lat_merge_all(LatHist* dst, const LatHist* src) {
+    for (int k = 0; k < OP_KIND_COUNT; k++) lat_merge(&dst[k], &src[k]);
+}
+
 /* --------------------------------------------------------------------------
    Filters
 ----------------------------------------------------------------------------*/
@@ -214,47 +315,412 @@ static bool should_skip_file(const char* path, const ScanConfig* cfg) {
 }
 
 /* --------------------------------------------------------------------------
-   Buffer reuse (P1)
+   Read pipeline (full read: scan thread reads, hasher thread runs CRC and the content hash)
 ----------------------------------------------------------------------------*/
-typedef struct {
-    uint8_t* sample_buf;
-    size_t sample_cap;
-    uint8_t* chunk_buf;
-    size_t chunk_cap;
-} ScanBuffers;
+static void pipe_hash_slot(ReadPipe* p, const PipeSlot* s) {
+    uint64_t t0 = now_us();
+    uint64_t tr = trace_begin();
+    p->crc = crc32_update(p->crc, s->buf, s->len);
+    if (s->first) {
+        size_t a = (s->len < SAMPLE_REGION) ? s->len : SAMPLE_REGION;
+        p->first_crc = crc32_update(0, s->buf, a);
+        p->first_crc_set = true;
+    }
+    trace_end(TRACE_CRC, tr, NULL, 0, s->len);
+    if (p->hash.algo != HASH_CRC32) {
+        tr = trace_begin();
+        hash_update(&p->hash, s->buf, s->len);
+        trace_end(TRACE_HASH, tr, NULL, 0, s->len);
+    }
+    p->hash_us += now_us() - t0;
+    p->hash_bytes += s->len;
+}
+
+static void pipe_hasher_main(void* arg) {
+    ReadPipe* p = (ReadPipe*)arg;
+    trace_thread("hasher");
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (p->filled == 0 && !p->stop) pthread_cond_wait(&p->cv_filled, &p->lock);
+        if (p->filled == 0 && p->stop) break;
+
+        PipeSlot* s = &p->slots[p->tail];
+        pthread_mutex_unlock(&p->lock);
+
+        pipe_hash_slot(p, s);
+
+        pthread_mutex_lock(&p->lock);
+        p->done_crc = p->crc;
+        p->done_off += s->len;
+        p->tail = (p->tail + 1) % p->nslots;
+        p->filled--;
+        pthread_cond_signal(&p->cv_free);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+static bool pipe_init(ReadPipe* p, int nslots, size_t slot_cap) {
+    memset(p, 0, sizeof(*p));
+    if (nslots < 2) nslots = 1;
+    if (nslots > PIPELINE_SLOTS_MAX) nslots = PIPELINE_SLOTS_MAX;
+    p->nslots = nslots;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cv_filled, NULL);
+    pthread_cond_init(&p->cv_free, NULL);
+
+    for (int i = 0; i < p->nslots; i++) {
+        p->slots[i].buf = (uint8_t*)io_buf_alloc(slot_cap);
+        if (!p->slots[i].buf) return false;
+        p->slots[i].cap = slot_cap;
+    }
+
+    if (p->nslots >= 2) {
+        /* Hasher on core 1; the scan/UI thread stays on the default core. */
+        p->threaded = worker_start(&p->thread, pipe_hasher_main, p, 1, 0x10000);
+        if (!p->threaded) log_push("WARN", "Hasher thread unavailable; full reads hash inline.");
+    }
+    return true;
+}
+
+static void pipe_free(ReadPipe* p) {
+    if (p->threaded) {
+        pthread_mutex_lock(&p->lock);
+        p->stop = true;
+        pthread_cond_signal(&p->cv_filled);
+        pthread_mutex_unlock(&p->lock);
+        worker_join(&p->thread);
+        p->threaded = false;
+    }
+    if (p->nslots > 0) {
+        pthread_cond_destroy(&p->cv_free);
+        pthread_cond_destroy(&p->cv_filled);
+        pthread_mutex_destroy(&p->lock);
+    }
+    for (int i = 0; i < PIPELINE_SLOTS_MAX; i++) {
+        if (p->slots[i].buf) free(p->slots[i].buf);
+    }
+    memset(p, 0, sizeof(*p));
+}
+
+/* Start of a file, or its continuation at 'off' with 'crc' of the bytes before. The pipe must
+   be drained (pipe_finish) before this. */
+static void pipe_begin(ReadPipe* p, HashAlgo algo, uint32_t crc, uint64_t off) {
+    p->published = 0;
+    p->crc = crc;
+    p->done_crc = crc;
+    p->done_off = off;
+    p->first_crc = 0;
+    p->first_crc_set = false;
+    hash_begin(&p->hash, algo);
+    p->hash_us = 0;
+    p->hash_bytes = 0;
+    p->wait_us = 0;
+}
 
-static void scan_buffers_free(ScanBuffers* b) {
+/* Returns a free slot of at least 'need' bytes (blocks while the ring is full), or NULL on OOM. */
+static uint8_t* pipe_acquire(ReadPipe* p, size_t need) {
+    if (p->threaded) {
+        pthread_mutex_lock(&p->lock);
+        if (p->filled >= p->nslots) {
+            uint64_t t0 = now_us();
+            while (p->filled >= p->nslots) pthread_cond_wait(&p->cv_free, &p->lock);
+            p->wait_us += now_us() - t0;
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    /* The head slot is not visible to the hasher until published. */
+    PipeSlot* s = &p->slots[p->head];
+    if (need > s->cap || !s->buf) {   /* !buf: went with a read that was given up */
+        uint8_t* nb = (uint8_t*)io_buf_alloc(need);
+        if (!nb) return NULL;
+        free(s->buf);
+        s->buf = nb;
+        s->cap = need;
+    }
+    return s->buf;
+}
+
+/* The acquired slot's buffer, for a deadline read that may have to give it away. */
+static uint8_t** pipe_head_buf(ReadPipe* p, size_t* cap) {
+    PipeSlot* s = &p->slots[p->head];
+    *cap = s->cap;
+    return &s->buf;
+}
+
+/* Hands 'len' bytes of the acquired slot to the hasher. */
+static void pipe_publish(ReadPipe* p, size_t len) {
+    PipeSlot* s = &p->slots[p->head];
+    s->len = len;
+    s->first = (p->published == 0);
+    p->published++;
+
+    if (!p->threaded) {
+        pipe_hash_slot(p, s);
+        p->done_crc = p->crc;
+        p->done_off += len;
+        return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->head = (p->head + 1) % p->nslots;
+    p->filled++;
+    pthread_cond_signal(&p->cv_filled);
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* The CRC of the file up to *off, as far as the hasher got. */
+static uint32_t pipe_progress(ReadPipe* p, uint64_t* off) {
+    if (p->threaded) pthread_mutex_lock(&p->lock);
+    uint32_t crc = p->done_crc;
+    *off = p->done_off;
+    if (p->threaded) pthread_mutex_unlock(&p->lock);
+    return crc;
+}
+
+/* Waits until every published slot is hashed, then returns the file's hash state. */
+static void pipe_finish(ReadPipe* p, uint32_t* crc, uint32_t* first_crc, bool* first_crc_set, HashDigest* digest) {
+    if (p->threaded) {
+        pthread_mutex_lock(&p->lock);
+        while (p->filled > 0) pthread_cond_wait(&p->cv_free, &p->lock);
+        pthread_mutex_unlock(&p->lock);
+    }
+    if (crc) *crc = p->crc;
+    if (first_crc) *first_crc = p->first_crc;
+    if (first_crc_set) *first_crc_set = p->first_crc_set;
+    if (digest) hash_final(&p->hash, digest);
+}
+
+/* --------------------------------------------------------------------------
+   Read deadline
+----------------------------------------------------------------------------*/
+/*
+ * With read_deadline_s set, file reads go through an I/O proxy thread (io_pread_deadline) so
+ * a read blocked in a failing card cannot hold the scan: past the deadline it is given up,
+ * recorded as TIMEOUT, and the file is skipped with its handle. While a read is slow, the
+ * waiting thread keeps its UI (or shard) going and honors cancel.
+ */
+static bool guard_init(ReadGuard* g, const ScanConfig* cfg) {
+    memset(g, 0, sizeof(*g));
+    if (!cfg || cfg->read_deadline_s <= 0) return true;
+    g->proxy = io_proxy_new();
+    g->deadline_ms = (uint32_t)cfg->read_deadline_s * 1000u;
+    return g->proxy != NULL;
+}
+
+static void guard_free(ReadGuard* g) {
+    io_proxy_free(g->proxy);
+    memset(g, 0, sizeof(*g));
+}
+
+static bool guard_tick(void* arg) {
+    ReadGuard* g = (ReadGuard*)arg;
+    if (!g->st) return false;
+    if (g->ui_update) g->ui_update(g->st, g->pad, false);
+    return g->st->cancelled;
+}
+
+bool guarded_pread(ReadGuard* g, IoFile* f, const char* path, uint8_t** bufp, size_t cap, size_t len, uint64_t off, size_t* out_read) {
+    OpScope o;
+    op_enter(&o, OP_READ, path, off, len);
+    bool ok;
+    if (!g || !g->proxy) ok = io_pread(f, *bufp, len, off, out_read);
+    else ok = io_pread_deadline(g->proxy, f, bufp, cap, len, off, out_read, g->deadline_ms, guard_tick, g);
+    op_leave(&o, g ? g->lat : NULL);
+    return ok;
+}
+
+void guard_bind(ReadGuard* g, ScanStats* st, ScanUiUpdateFn ui_update, PadState* pad) {
+    g->st = st;
+    g->ui_update = ui_update;
+    g->pad = pad;
+    g->lat = st ? st->lat : NULL;
+}
+
+void timeout_record(ScanStats* st, const char* path, uint64_t off, uint64_t len, const char* note) {
+    st->read_timeouts++;
+    first_fail_capture(st, "TIMEOUT", path, off, len, ETIMEDOUT, note);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Read timed out @ %llu (%llu KiB); file skipped", (unsigned long long)off,
+             (unsigned long long)(len / 1024));
+    err_push(st, msg);
+    fail_push_unique(st, path);
+}
+
+bool read_abandoned(ScanStats* st, const IoFile* f, const char* path, uint64_t off, uint64_t len, const char* note) {
+    if (f->be) return false;
+    if (errno == ETIMEDOUT) timeout_record(st, path, off, len, note);
+    return true;
+}
+
+/* --------------------------------------------------------------------------
+   Buffer reuse (P1)
+----------------------------------------------------------------------------*/
+void scan_buffers_free(ScanBuffers* b) {
     if (!b) return;
     if (b->sample_buf) free(b->sample_buf);
-    if (b->chunk_buf) free(b->chunk_buf);
+    pipe_free(&b->pipe);
+    io_arena_free(&b->dirs);
+    guard_free(&b->guard);
     memset(b, 0, sizeof(*b));
 }
 
-static bool scan_buffers_init_default(ScanBuffers* b) {
+bool scan_buffers_init(ScanBuffers* b, const ScanConfig* cfg) {
     if (!b) return false;
     memset(b, 0, sizeof(*b));
 
     b->sample_cap = SAMPLE_REGION;
-    b->chunk_cap = 1024u * 1024u;
+    if (cfg && (size_t)cfg->sample_region_kib * 1024u > b->sample_cap) b->sample_cap = (size_t)cfg->sample_region_kib * 1024u;
+    b->sample_buf = (uint8_t*)io_buf_alloc(b->sample_cap);
 
-    b->sample_buf = (uint8_t*)malloc(b->sample_cap);
-    b->chunk_buf  = (uint8_t*)malloc(b->chunk_cap);
-
-    if (!b->sample_buf || !b->chunk_buf) {
+    int slots = cfg ? cfg->pipeline_slots : 0;
+    if (!b->sample_buf || !pipe_init(&b->pipe, slots, 1024u * 1024u) || !guard_init(&b->guard, cfg)) {
         scan_buffers_free(b);
         return false;
     }
     return true;
 }
 
-static bool ensure_chunk_cap(ScanBuffers* b, size_t need) {
-    if (!b) return false;
-    if (need <= b->chunk_cap) return true;
-    uint8_t* nb = (uint8_t*)realloc(b->chunk_buf, need);
-    if (!nb) return false;
-    b->chunk_buf = nb;
-    b->chunk_cap = need;
-    return true;
+/* --------------------------------------------------------------------------
+   Chunk auto-tuner (chunk_mode Auto)
+----------------------------------------------------------------------------*/
+/*
+ * Full reads ask the tuner for a chunk size before every read. A probe round hands out the
+ * candidate sizes in turn until each has TUNE_MIN_READS full-length reads and TUNE_MIN_BYTES,
+ * timed like perf_record (io_pread only), then settles on the fastest. The smallest size within
+ * 3% of the best wins, which keeps progress and error offsets fine-grained for no real cost.
+ * The first round covers the whole ladder; every TUNE_REPROBE_US after that, the chosen size
+ * and its two neighbours are probed again, so the choice follows the card as it warms up or
+ * the tree moves to other data. One tuner serves all readers of a run.
+ */
+#define TUNE_MIN_READS   4
+#define TUNE_MIN_BYTES   (4ull * 1024ull * 1024ull)
+#define TUNE_REPROBE_US  (60ull * 1000000ull)
+#define TUNE_START       4          /* 1 MiB until the first round is done */
+
+struct ChunkTuner {
+    pthread_mutex_t lock;
+    bool     probing;
+    uint32_t want;                  /* ladder sizes of the current round (bit i = size i) */
+    int      next;                  /* round-robin cursor over the ladder */
+    int      best;
+    uint32_t rounds;                /* completed rounds */
+    uint64_t steady_since_us;
+    uint64_t win_bytes[TUNE_SIZES]; /* current round */
+    uint64_t win_us[TUNE_SIZES];
+    uint32_t win_reads[TUNE_SIZES];
+    double   mib_s[TUNE_SIZES];     /* result of the last round that probed the size */
+    uint64_t bytes[TUNE_SIZES];     /* all timed full-length reads */
+};
+
+static size_t tune_size(int i) {
+    return (size_t)(64u * 1024u) << i;
+}
+
+static void tune_init(ChunkTuner* t) {
+    memset(t, 0, sizeof(*t));
+    pthread_mutex_init(&t->lock, NULL);
+    t->probing = true;
+    t->want = (1u << TUNE_SIZES) - 1u;
+    t->best = TUNE_START;
+}
+
+static void tune_free(ChunkTuner* t) {
+    pthread_mutex_destroy(&t->lock);
+}
+
+static bool tune_pending(const ChunkTuner* t, int i) {
+    return (t->want & (1u << i)) && (t->win_reads[i] < TUNE_MIN_READS || t->win_bytes[i] < TUNE_MIN_BYTES);
+}
+
+static void tune_round_start(ChunkTuner* t, uint32_t want) {
+    t->probing = true;
+    t->want = want;
+    memset(t->win_bytes, 0, sizeof(t->win_bytes));
+    memset(t->win_us, 0, sizeof(t->win_us));
+    memset(t->win_reads, 0, sizeof(t->win_reads));
+}
+
+/* Ladder index for the next read. */
+static int tune_pick(ChunkTuner* t) {
+    pthread_mutex_lock(&t->lock);
+    if (!t->probing && now_us() - t->steady_since_us >= TUNE_REPROBE_US) {
+        uint32_t want = 1u << t->best;
+        if (t->best > 0) want |= 1u << (t->best - 1);
+        if (t->best < TUNE_SIZES - 1) want |= 1u << (t->best + 1);
+        tune_round_start(t, want);
+    }
+
+    int i = t->best;
+    if (t->probing) {
+        for (int k = 0; k < TUNE_SIZES; k++) {
+            int c = (t->next + k) % TUNE_SIZES;
+            if (tune_pending(t, c)) {
+                i = c;
+                t->next = c + 1;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+    return i;
+}
+
+/* One full-length read of ladder size i took dt_us. */
+static void tune_record(ChunkTuner* t, int i, uint64_t bytes, uint64_t dt_us) {
+    pthread_mutex_lock(&t->lock);
+    t->bytes[i] += bytes;
+    if (t->probing && (t->want & (1u << i))) {
+        t->win_bytes[i] += bytes;
+        t->win_us[i] += dt_us ? dt_us : 1;
+        t->win_reads[i]++;
+
+        bool done = true;
+        for (int k = 0; k < TUNE_SIZES && done; k++) done = !tune_pending(t, k);
+        if (done) {
+            double top = 0.0;
+            for (int k = 0; k < TUNE_SIZES; k++) {
+                if (!(t->want & (1u << k))) continue;
+                t->mib_s[k] = ((double)t->win_bytes[k] / 1048576.0) / ((double)t->win_us[k] / 1000000.0);
+                if (t->mib_s[k] > top) top = t->mib_s[k];
+            }
+            for (int k = 0; k < TUNE_SIZES; k++) {
+                if ((t->want & (1u << k)) && t->mib_s[k] >= top * 0.97) {
+                    t->best = k;
+                    break;
+                }
+            }
+            t->probing = false;
+            t->rounds++;
+            t->steady_since_us = now_us();
+            log_pushf("INFO", "Chunk tuner: %u KiB at %.2f MiB/s (round %u)",
+                      (unsigned)(tune_size(t->best) / 1024u), t->mib_s[t->best], t->rounds);
+        }
+    }
+    pthread_mutex_unlock(&t->lock);
+}
+
+static int tune_current(ChunkTuner* t) {
+    pthread_mutex_lock(&t->lock);
+    int i = t->best;
+    pthread_mutex_unlock(&t->lock);
+    return i;
+}
+
+/* Copies the probe table into the run's stats (after the readers stopped). */
+static void tune_snapshot(ChunkTuner* t, ScanStats* st) {
+    pthread_mutex_lock(&t->lock);
+    st->tune_chunk = (uint32_t)tune_size(t->best);
+    st->tune_rounds = t->rounds;
+    for (int k = 0; k < TUNE_SIZES; k++) {
+        st->tune_bytes[k] = t->bytes[k];
+        st->tune_mib_s[k] = t->mib_s[k];
+        /* Unfinished round: show what it measured so far. */
+        if (t->probing && t->win_reads[k] > 0)
+            st->tune_mib_s[k] = ((double)t->win_bytes[k] / 1048576.0) / ((double)t->win_us[k] / 1000000.0);
+    }
+    pthread_mutex_unlock(&t->lock);
 }
 
 /* --------------------------------------------------------------------------
@@ -266,185 +732,601 @@ static size_t chunk_bytes_from_mode(ChunkMode m) {
         case CHUNK_256K: return 256u * 1024u;
         case CHUNK_512K: return 512u * 1024u;
         case CHUNK_1M:   return 1024u * 1024u;
+        case CHUNK_2M:   return 2u * 1024u * 1024u;
+        case CHUNK_4M:   return 4u * 1024u * 1024u;
+        case CHUNK_8M:   return 8u * 1024u * 1024u;
         default: return 0;
     }
 }
 
-static size_t choose_chunk_auto(uint64_t file_size) {
-    if (file_size >= (1ull * 1024ull * 1024ull * 1024ull)) return 1024u * 1024u;
-    if (file_size >= (256ull * 1024ull * 1024ull)) return 512u * 1024u;
-    if (file_size >= (64ull * 1024ull * 1024ull)) return 256u * 1024u;
-    return 128u * 1024u;
-}
-
-static bool read_region_retry(FILE* f, uint64_t off, uint8_t* buf, size_t want, const ScanConfig* cfg, ScanStats* st, uint32_t* out_crc) {
-    if (fseeko(f, (off_t)off, SEEK_SET) != 0) {
-        st->read_errors++;
-        first_fail_capture(st, "SEEK", st->current_path, off, want, errno, "fseeko");
-        err_push(st, "Seek error");
-        return false;
-    }
-
+/* deferred: set when the failed rest of the region went onto rq (the call still returns true).
+   Reads into bufs->sample_buf. */
+static bool read_region_retry(IoFile* f, uint64_t off, ScanBuffers* bufs, size_t want, const ScanConfig* cfg, ScanStats* st, uint32_t* out_crc, RetryQueue* rq, bool* deferred) {
     int retries = cfg ? cfg->read_retries : 0;
     uint32_t crc = 0;
+    uint64_t pos = off;
+    size_t left = want;
+    if (deferred) *deferred = false;
 
     for (int attempt = 0; attempt <= retries; attempt++) {
-        errno = 0;
-        uint64_t t0 = now_ms();
-        size_t r = fread(buf, 1, want, f);
-        uint64_t dt = now_ms() - t0;
+        size_t r = 0;
+        uint64_t t0 = now_us();
+        bool rd_ok = guarded_pread(&bufs->guard, f, st->current_path, &bufs->sample_buf, bufs->sample_cap, left, pos, &r);
+        uint64_t dt = now_us() - t0;
         int e = errno;
+        if (read_abandoned(st, f, st->current_path, pos, left, "read_region")) return false;
 
         if (r > 0) {
-            crc = crc32_update(crc, buf, r);
+            uint64_t tc = now_us();
+            crc = crc32_update(crc, bufs->sample_buf, r);
+            uint64_t tc1 = now_us();
+            st->crc_us += tc1 - tc;
+            trace_span(TRACE_CRC, tc, tc1, NULL, pos, r);
             st->bytes_read += r;
             st->current_done += r;
-            perf_record(st, r, dt, off, st->current_path);
+            perf_record(st, r, dt, pos, st->current_path);
+            pos += r;
+            left -= r;
         }
 
-        if (!ferror(f)) {
+        if (rd_ok) {
             if (out_crc) *out_crc = crc;
             return true;
         }
 
-        clearerr(f);
         if (attempt < retries) {
             st->read_errors_transient++;
-            svcSleepThread(30 * 1000 * 1000);
+            if (attempt == 0 && deferred && retry_defer(rq, cfg, pos, left, e, true)) {
+                *deferred = true;
+                return true;
+            }
+            retry_sleep(cfg, attempt, st);
             continue;
         }
 
         st->read_errors++;
         first_fail_capture(st, "READ", st->current_path, off, want, e, "read_region");
-        err_push(st, "Read error");
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Sample read error @ %llu: %s", (unsigned long long)off, strerror(e));
+        err_push(st, msg);
+        Bisect b;
+        if (rq && bisect_init(&b, f, st->current_path, cfg, st, &rq->bad, &bufs->guard, &bufs->sample_buf, bufs->sample_cap))
+            bisect_salvage(&b, pos, left, left, &st->current_done);
         return false;
     }
 
     return false;
 }
 
-static bool read_sample(FILE* f, uint64_t size, const ScanConfig* cfg, ScanStats* st, ScanBuffers* bufs, ScanUiUpdateFn ui_update, PadState* pad, uint32_t* out_crc) {
-    if (!bufs || !bufs->sample_buf || bufs->sample_cap < SAMPLE_REGION) return false;
+/* --------------------------------------------------------------------------
+   Sampling (files above large_file_limit)
+----------------------------------------------------------------------------*/
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
 
-    uint8_t* buf = bufs->sample_buf;
-    uint32_t crc_total = 0;
+void sample_plan(SamplePlan* p, uint64_t size, const ScanConfig* cfg, const char* path, double coverage_pct) {
+    memset(p, 0, sizeof(*p));
+    p->size = size;
+    p->region = cfg ? (size_t)cfg->sample_region_kib * 1024u : SAMPLE_REGION;
+    p->mode = cfg ? cfg->sample_mode : SAMPLE_EVEN;
+    if (size <= p->region) {
+        p->region = (size_t)size;
+        p->count = size ? 1 : 0;
+        return;
+    }
 
-    size_t want = (size < SAMPLE_REGION) ? (size_t)size : (size_t)SAMPLE_REGION;
-    uint32_t crc1 = 0;
-    if (!read_region_retry(f, 0, buf, want, cfg, st, &crc1)) return false;
-    crc_total ^= crc1;
-
-    if (ui_update) ui_update(st, pad, false);
-    if (st->cancelled) return false;
-
-    if (cfg && cfg->consistency_check) {
-        uint32_t crc1b = 0;
-        st->current_done -= want;
-        st->bytes_read -= want;
-        if (!read_region_retry(f, 0, buf, want, cfg, st, &crc1b)) return false;
-        st->current_done -= want;
-        st->bytes_read -= want;
-        if (crc1b != crc1) {
-            st->consistency_errors++;
-            first_fail_capture(st, "CONSIST", st->current_path, 0, SAMPLE_REGION, 0, "CRC mismatch");
-            err_push(st, "Consistency mismatch (first region)");
-            return false;
-        }
+    uint64_t n = 2;
+    if (coverage_pct < 0.0) coverage_pct = cfg ? cfg->sample_coverage_pct : 0.0;
+    if (coverage_pct > 0.0) {
+        double want = (double)size * coverage_pct / 100.0 / (double)p->region;
+        uint64_t k = (uint64_t)want;
+        if ((double)k < want) k++;
+        if (k > n) n = k;
+    }
+    if (cfg && cfg->sample_budget_mib > 0) {
+        uint64_t cap = (uint64_t)cfg->sample_budget_mib * 1048576ull / p->region;
+        if (n > cap) n = cap;
     }
+    uint64_t max = size / p->region;
+    if (n > max) n = max;
+    if (n < 2) n = 2;
+    p->count = (n > UINT32_MAX) ? UINT32_MAX : (uint32_t)n;
+
+    uint64_t h = 1469598103934665603ull;   /* FNV-1a */
+    for (const char* c = path ? path : ""; *c; c++) h = (h ^ (uint8_t)*c) * 1099511628211ull;
+    p->seed = mix64((cfg ? cfg->sample_seed : 0) ^ h);
+}
 
-    if (size > SAMPLE_REGION) {
-        uint64_t off = (size > SAMPLE_REGION) ? (size - SAMPLE_REGION) : 0;
-        uint32_t crc2 = 0;
-        if (!read_region_retry(f, off, buf, SAMPLE_REGION, cfg, st, &crc2)) return false;
-        crc_total ^= crc2;
+uint64_t sample_planned_bytes(const SamplePlan* p) {
+    return (uint64_t)p->count * p->region;
+}
 
-        if (ui_update) ui_update(st, pad, false);
-        if (st->cancelled) return false;
+static uint64_t sample_off(const SamplePlan* p, uint32_t k) {
+    uint64_t last = p->size - p->region;
+    if (k == 0 || p->count < 2) return 0;
+    if (k == p->count - 1) return last;
+
+    uint64_t off;
+    if (p->mode == SAMPLE_RANDOM) {
+        uint64_t stratum = p->size / p->count;   /* >= region: count <= size / region */
+        uint64_t lo = stratum * k;
+        off = lo + mix64(p->seed + k) % (stratum - p->region + 1);
+    } else {
+        uint64_t gaps = p->count - 1;
+        off = (last / gaps) * k + (last % gaps) * k / gaps;
+    }
+    return off & ~(uint64_t)(IO_BUF_ALIGN - 1);
+}
 
-        if (cfg && cfg->consistency_check) {
-            uint32_t crc2b = 0;
-            st->current_done -= SAMPLE_REGION;
-            st->bytes_read -= SAMPLE_REGION;
-            if (!read_region_retry(f, off, buf, SAMPLE_REGION, cfg, st, &crc2b)) return false;
-            st->current_done -= SAMPLE_REGION;
-            st->bytes_read -= SAMPLE_REGION;
-            if (crc2b != crc2) {
+static bool read_sample(IoFile* f, const SamplePlan* plan, const ScanConfig* cfg, ScanStats* st, ScanBuffers* bufs, ScanUiUpdateFn ui_update, PadState* pad, uint32_t* out_crc, RetryQueue* rq) {
+    if (!bufs || !bufs->sample_buf || bufs->sample_cap < plan->region) return false;
+
+    uint32_t crc_total = 0;
+
+    /* crc_total is the CRC of the regions back to back. */
+    for (uint32_t k = 0; k < plan->count; k++) {
+        uint64_t off = sample_off(plan, k);
+        size_t len = plan->region;
+        uint32_t crc = 0;
+        bool deferred = false;
+        if (!read_region_retry(f, off, bufs, len, cfg, st, &crc, rq, &deferred)) return false;
+
+        /* A deferred region is compared by nobody: its retry only has to read it back. */
+        if (cfg && cfg->consistency_check && !deferred && !st->cancelled) {
+            /* The second read is not progress: only the first one counts. */
+            uint32_t crc_b = 0;
+            if (!read_region_retry(f, off, bufs, len, cfg, st, &crc_b, NULL, NULL)) return false;
+            st->current_done -= len;
+            st->bytes_read -= len;
+            if (crc_b != crc) {
+                char msg[128];
                 st->consistency_errors++;
-                err_push(st, "Consistency mismatch (last region)");
+                first_fail_capture(st, "CONSIST", st->current_path, off, len, 0, "CRC mismatch (sample region)");
+                snprintf(msg, sizeof(msg), "Consistency mismatch (region %u/%u @ %llu)",
+                         k + 1, plan->count, (unsigned long long)off);
+                err_push(st, msg);
                 return false;
             }
         }
+
+        crc_total = crc32_combine(crc_total, crc, len);
+        st->sample_regions++;
+        st->sample_bytes += len;
+
+        if (ui_update) ui_update(st, pad, false);
+        if (st->cancelled) return false;
     }
 
     if (out_crc) *out_crc = crc_total;
     return !st->cancelled;
 }
 
-static bool read_full(FILE* f, uint64_t size, const ScanConfig* cfg, ScanStats* st, ScanBuffers* bufs, ScanUiUpdateFn ui_update, PadState* pad, uint32_t* out_crc) {
-    size_t chunk = 256u * 1024u;
-    if (cfg) {
-        size_t fixed = chunk_bytes_from_mode(cfg->chunk_mode);
-        chunk = fixed ? fixed : choose_chunk_auto(size);
-    } else {
-        chunk = choose_chunk_auto(size);
+/* --------------------------------------------------------------------------
+   Range reads (one large file, several readers)
+----------------------------------------------------------------------------*/
+/*
+ * A large full read is cut into fixed segments that range workers claim in order; each
+ * worker reads its segments through its own handle and CRCs them, and crc32_combine()
+ * chains the segment CRCs into the whole-file CRC. The calling thread is worker 0 and keeps
+ * the UI going; helpers only touch their private stats, merged after the join.
+ */
+#define RANGE_SEGMENT (32ull * 1024ull * 1024ull)
+
+typedef struct {
+    const char*       path;
+    const ScanConfig* cfg;
+    uint64_t          size;
+    uint32_t          nseg;
+    size_t            chunk;
+    uint32_t*         seg_crc;
+    int*              seg_errno;     /* 0: segment read completely */
+    uint64_t*         seg_fail_off;  /* absolute offset of the failing chunk */
+    bool              defer;         /* retry queue: a segment skips its first failed chunk */
+    uint64_t*         seg_defer_off; /* ... queued after the join (later failures retry in place) */
+    uint64_t*         seg_defer_len;
+    int*              seg_defer_errno;
+    bool              bisect;        /* a failed segment does not stop the others; its rest is bisected after the join */
+    atomic_bool       gone;          /* a read was given up (seg_errno ETIMEDOUT/ECANCELED): the file is skipped */
+    _Atomic uint32_t  next_seg;
+    _Atomic uint64_t  done;          /* bytes read by all workers */
+    atomic_bool       abort;
+    uint32_t          first_crc;     /* first SAMPLE_REGION bytes (consistency check) */
+    bool              first_crc_set;
+} RangeJob;
+
+typedef struct {
+    RangeJob*    job;
+    ScanStats*   ps;        /* private perf/retry counters */
+    IoFile       f;
+    bool         opened;
+    uint8_t*     buf;
+    ReadGuard*   guard;     /* worker 0: the consumer's; helpers: own */
+    ReadGuard    own;
+    WorkerThread thread;
+    bool         started;
+} RangeWorker;
+
+static uint64_t range_seg_len(const RangeJob* job, uint32_t s) {
+    uint64_t off = (uint64_t)s * RANGE_SEGMENT;
+    uint64_t end = off + RANGE_SEGMENT;
+    return ((end < job->size) ? end : job->size) - off;
+}
+
+/* Claims and reads segments until none is left or the job aborts. st/ui_update: worker 0 only. */
+static void range_work(RangeWorker* w, ScanStats* st, uint64_t bytes_base, ScanUiUpdateFn ui_update, PadState* pad) {
+    RangeJob* job = w->job;
+    int retries = job->cfg ? job->cfg->read_retries : 0;
+
+    while (!atomic_load_explicit(&job->abort, memory_order_relaxed)) {
+        uint32_t s = atomic_fetch_add_explicit(&job->next_seg, 1, memory_order_relaxed);
+        if (s >= job->nseg) break;
+
+        uint64_t off = (uint64_t)s * RANGE_SEGMENT;
+        uint64_t end = off + range_seg_len(job, s);
+        uint32_t crc = 0;
+
+        while (off < end) {
+            size_t want = (end - off < job->chunk) ? (size_t)(end - off) : job->chunk;
+            size_t r = 0;
+            bool rd_ok = false;
+            bool deferred = false;
+            int e = 0;
+            for (int attempt = 0; ; attempt++) {
+                uint64_t t0 = now_us();
+                rd_ok = guarded_pread(w->guard, &w->f, job->path, &w->buf, job->chunk, want, off, &r);
+                uint64_t dt = now_us() - t0;
+                e = errno;
+                if (!w->f.be) break;   /* given up */
+                if (r > 0) {
+                    uint64_t tc = now_us();
+                    if (off == 0 && !job->first_crc_set) {
+                        size_t a = (r < SAMPLE_REGION) ? r : SAMPLE_REGION;
+                        job->first_crc = crc32_update(0, w->buf, a);
+                        job->first_crc_set = true;
+                    }
+                    crc = crc32_update(crc, w->buf, r);
+                    uint64_t tc1 = now_us();
+                    w->ps->crc_us += tc1 - tc;
+                    trace_span(TRACE_CRC, tc, tc1, NULL, off, r);
+                    perf_record(w->ps, r, dt, off, job->path);
+                    atomic_fetch_add_explicit(&job->done, r, memory_order_relaxed);
+                    off += r;
+                    want -= r;
+                }
+                if (rd_ok || attempt >= retries) break;
+                w->ps->read_errors_transient++;
+                if (attempt == 0 && job->defer && !job->seg_defer_len[s]) {
+                    deferred = true;
+                    break;
+                }
+                retry_sleep(job->cfg, attempt, w->ps);
+            }
+            if (!w->f.be) {
+                job->seg_errno[s] = e;
+                job->seg_fail_off[s] = off;
+                atomic_store_explicit(&job->gone, true, memory_order_relaxed);
+                atomic_store_explicit(&job->abort, true, memory_order_relaxed);
+                break;
+            }
+            if (deferred) {
+                /* The failed chunk is read back later; zeros stand in for it in the CRC. */
+                job->seg_defer_off[s] = off;
+                job->seg_defer_len[s] = want;
+                job->seg_defer_errno[s] = e ? e : EIO;
+                memset(w->buf, 0, want);
+                crc = crc32_update(crc, w->buf, want);
+                off += want;
+                continue;
+            }
+            if (rd_ok && want > 0) {
+                rd_ok = false;   /* EOF inside the file's listed size: it shrank under us */
+                e = EIO;
+            }
+            if (!rd_ok) {
+                job->seg_errno[s] = e ? e : EIO;
+                job->seg_fail_off[s] = off;
+                if (!job->bisect) atomic_store_explicit(&job->abort, true, memory_order_relaxed);
+                break;
+            }
+
+            if (st) {
+                uint64_t done = atomic_load_explicit(&job->done, memory_order_relaxed);
+                st->current_done = done;
+                st->bytes_read = bytes_base + done;
+                if (ui_update) ui_update(st, pad, false);
+                if (st->cancelled) atomic_store_explicit(&job->abort, true, memory_order_relaxed);
+            }
+        }
+        job->seg_crc[s] = crc;
     }
+}
 
-    if (!bufs || !ensure_chunk_cap(bufs, chunk)) return false;
-    uint8_t* buf = bufs->chunk_buf;
+static void range_helper_main(void* arg) {
+    trace_thread("range");
+    range_work((RangeWorker*)arg, NULL, 0, NULL, NULL);
+}
 
-    uint32_t crc = 0;
-    uint32_t first_crc = 0;
-    bool first_crc_set = false;
+/* Adds a helper's perf/retry counters to st. */
+static void range_merge_perf(ScanStats* st, const ScanStats* ps) {
+    st->read_io_us += ps->read_io_us;
+    st->crc_us += ps->crc_us;
+    st->retry_sleep_us += ps->retry_sleep_us;
+    st->read_errors_transient += ps->read_errors_transient;
+    st->perf_ops += ps->perf_ops;
+    st->perf_bytes += ps->perf_bytes;
+    for (int b = 0; b < 5; b++) st->perf_hist[b] += ps->perf_hist[b];
+    st->perf_stalls += ps->perf_stalls;
+    st->perf_stall_total_ms += ps->perf_stall_total_ms;
+    lat_merge_all(st->lat, ps->lat);
+    if (ps->perf_longest_ms > st->perf_longest_ms) {
+        st->perf_longest_ms = ps->perf_longest_ms;
+        st->perf_longest_mib_s = ps->perf_longest_mib_s;
+        st->perf_longest_off = ps->perf_longest_off;
+        st->perf_longest_bytes = ps->perf_longest_bytes;
+        snprintf(st->perf_longest_path, sizeof(st->perf_longest_path), "%s", ps->perf_longest_path);
+    }
+}
+
+/*
+ * Full read of a large file as parallel ranges. *ranged is false when no helper could be set
+ * up; nothing was read then and the caller falls back to the sequential read.
+ */
+static bool read_full_ranged(IoFile* f, const char* path, uint64_t size, size_t chunk, const ScanConfig* cfg, ScanStats* st, ReadGuard* guard, ScanUiUpdateFn ui_update, PadState* pad, uint32_t* out_crc, uint32_t* out_first_crc, bool* out_first_set, bool* ranged, RetryQueue* rq) {
+    *ranged = false;
+    int nw = cfg->range_threads;
+    if (nw > RANGE_THREADS_MAX) nw = RANGE_THREADS_MAX;
+
+    RangeJob job;
+    memset(&job, 0, sizeof(job));
+    job.path = path;
+    job.cfg = cfg;
+    job.size = size;
+    job.nseg = (uint32_t)((size + RANGE_SEGMENT - 1) / RANGE_SEGMENT);
+    job.chunk = chunk;
+    atomic_init(&job.next_seg, 0);
+    atomic_init(&job.done, 0);
+    atomic_init(&job.abort, false);
+    atomic_init(&job.gone, false);
+    job.bisect = rq && cfg->bisect_min_kib > 0;
+    job.seg_crc = (uint32_t*)calloc(job.nseg, sizeof(uint32_t));
+    job.seg_errno = (int*)calloc(job.nseg, sizeof(int));
+    job.seg_fail_off = (uint64_t*)calloc(job.nseg, sizeof(uint64_t));
+    /* At most one deferred chunk per segment, so the queue room is taken up front. */
+    if (job.nseg <= RETRY_QUEUE_MAX && retry_reserve(rq, cfg, (int)job.nseg)) {
+        job.seg_defer_off = (uint64_t*)calloc(job.nseg, sizeof(uint64_t));
+        job.seg_defer_len = (uint64_t*)calloc(job.nseg, sizeof(uint64_t));
+        job.seg_defer_errno = (int*)calloc(job.nseg, sizeof(int));
+        job.defer = (job.seg_defer_off && job.seg_defer_len && job.seg_defer_errno);
+    }
+
+    RangeWorker w[RANGE_THREADS_MAX];
+    memset(w, 0, sizeof(w));
+    bool setup = (job.seg_crc && job.seg_errno && job.seg_fail_off);
+    for (int i = 0; setup && i < nw; i++) {
+        w[i].job = &job;
+        w[i].ps = (ScanStats*)calloc(1, sizeof(ScanStats));
+        w[i].buf = (uint8_t*)io_buf_alloc(chunk);
+        w[i].guard = (i == 0) ? guard : &w[i].own;
+        if (!w[i].ps || !w[i].buf || (i > 0 && !guard_init(&w[i].own, cfg))) {
+            if (i == 0) setup = false;
+            nw = i;
+            break;
+        }
+        w[i].own.lat = w[i].ps->lat;
+    }
+
+    int running = 0;
+    if (setup) {
+        w[0].f = *f;   /* worker 0 reads through the caller's handle */
+        running = 1;
+        for (int i = 1; i < nw; i++) {
+            /* Own handle per helper: stdio streams and fs sessions are not shared safely. */
+            if (!op_open(f->be, path, &w[i].f, st->lat)) break;
+            w[i].opened = true;
+            if (!worker_start(&w[i].thread, range_helper_main, &w[i], WORKER_CORE_DEFAULT, 0x10000)) break;
+            w[i].started = true;
+            running++;
+        }
+    }
+
+    bool ok = false;
+    if (running > 1) {
+        *ranged = true;
+        st->ranged_files++;
+        uint64_t bytes_base = st->bytes_read;
+        range_work(&w[0], st, bytes_base, ui_update, pad);
+        for (int i = 1; i < nw; i++) {
+            if (w[i].started) worker_join(&w[i].thread);
+        }
+        bool gone = atomic_load_explicit(&job.gone, memory_order_relaxed);
+        if (w[0].f.be) f->pos = w[0].f.pos;
+        else memset(f, 0, sizeof(*f));   /* worker 0's read was given up with the caller's handle */
+
+        uint64_t done = atomic_load_explicit(&job.done, memory_order_relaxed);
+        st->bytes_read = bytes_base + done;
+        st->current_done = done;
+        for (int i = 0; i < nw; i++) range_merge_perf(st, w[i].ps);
+
+        for (uint32_t s = 0; job.defer && !gone && s < job.nseg; s++) {
+            if (!job.seg_defer_len[s] || job.seg_errno[s]) continue;
+            if (!retry_defer(rq, cfg, job.seg_defer_off[s], job.seg_defer_len[s], job.seg_defer_errno[s], false)) {
+                job.seg_errno[s] = job.seg_defer_errno[s];
+                job.seg_fail_off[s] = job.seg_defer_off[s];
+            }
+        }
+
+        ok = !gone;
+        bool timeout_seen = false;
+        for (uint32_t s = 0; s < job.nseg; s++) {
+            if (!job.seg_errno[s]) continue;
+            ok = false;
+            if (job.seg_errno[s] == ETIMEDOUT || job.seg_errno[s] == ECANCELED) {
+                if (job.seg_errno[s] == ETIMEDOUT && !timeout_seen) timeout_record(st, path, job.seg_fail_off[s], chunk, "range read");
+                timeout_seen = true;
+                continue;
+            }
+            uint64_t soff = (uint64_t)s * RANGE_SEGMENT;
+            st->read_errors++;
+            first_fail_capture(st, "READ", path, job.seg_fail_off[s], chunk, job.seg_errno[s], "range read");
+            char msg[256];
+            snprintf(msg, sizeof(msg), "Range read error @ %llu (range %llu+%llu): %s",
+                     (unsigned long long)job.seg_fail_off[s], (unsigned long long)soff,
+                     (unsigned long long)range_seg_len(&job, s), strerror(job.seg_errno[s]));
+            err_push(st, msg);
+        }
+        Bisect b;
+        if (!ok && !gone && job.bisect && bisect_init(&b, &w[0].f, path, cfg, st, &rq->bad, guard, &w[0].buf, chunk)) {
+            for (uint32_t s = 0; s < job.nseg && !st->cancelled; s++) {
+                if (!job.seg_errno[s]) continue;
+                uint64_t end = (uint64_t)s * RANGE_SEGMENT + range_seg_len(&job, s);
+                uint64_t rest = end - job.seg_fail_off[s];
+                bisect_salvage(&b, job.seg_fail_off[s], rest, (rest < chunk) ? rest : chunk, &st->current_done);
+            }
+        }
+
+        if (ok && !st->cancelled) {
+            uint32_t crc = 0;
+            for (uint32_t s = 0; s < job.nseg; s++) crc = crc32_combine(crc, job.seg_crc[s], range_seg_len(&job, s));
+            *out_crc = crc;
+            *out_first_crc = job.first_crc;
+            *out_first_set = job.first_crc_set;
+        }
+        if (st->cancelled) ok = false;
+    } else if (running == 1) {
+        f->pos = w[0].f.pos;
+    }
+
+    for (int i = 1; i < RANGE_THREADS_MAX; i++) {
+        if (w[i].opened) op_close(&w[i].f, path, st->lat);
+        guard_free(&w[i].own);
+    }
+    for (int i = 0; i < RANGE_THREADS_MAX; i++) {
+        free(w[i].ps);
+        free(w[i].buf);
+    }
+    free(job.seg_crc);
+    free(job.seg_errno);
+    free(job.seg_fail_off);
+    free(job.seg_defer_off);
+    free(job.seg_defer_len);
+    free(job.seg_defer_errno);
+    return ok;
+}
 
+/* Sequential full read through the chunk ring. With a tuner, each read takes the size it hands out. */
+/* Where a resume of this read can continue: as far as the hasher got, unless a region went to
+   the retry queue (the CRC has zeros in its place). */
+static void seq_note_crc(ScanStats* st, ReadPipe* pipe, const RetryQueue* rq) {
+    if (rq && rq->cur_deferred > 0) st->current_crc_off = 0;
+    else st->current_crc = pipe_progress(pipe, &st->current_crc_off);
+}
+
+static bool read_full_seq(IoFile* f, uint64_t size, size_t chunk, ChunkTuner* tune, const ScanConfig* cfg, ScanStats* st, ScanBuffers* bufs, ScanUiUpdateFn ui_update, PadState* pad, uint32_t start_crc, uint32_t* out_crc, uint32_t* out_first_crc, bool* out_first_set, HashDigest* out_hash, RetryQueue* rq) {
+    ReadPipe* pipe = &bufs->pipe;
+    pipe_begin(pipe, cfg ? cfg->hash_algo : HASH_CRC32, start_crc, st->current_done);
+    st->current_seq_read = true;
+
+    /* Reads run here; CRC and hash run on the hasher thread over the previous chunks. */
+    bool ok = true;
     while (!st->cancelled) {
-        errno = 0;
         uint64_t off0 = st->current_done;
-        uint64_t t0 = now_ms();
-        size_t r = fread(buf, 1, chunk, f);
-        uint64_t dt = now_ms() - t0;
+        int ti = tune ? tune_pick(tune) : -1;
+        size_t want = (ti >= 0) ? tune_size(ti) : chunk;
+        /* Never more than the rest of the file plus a page (a short read then marks EOF). */
+        uint64_t rest = (size > off0) ? size - off0 : 0;
+        uint64_t cap = (rest + IO_BUF_ALIGN) & ~(uint64_t)(IO_BUF_ALIGN - 1);
+        if (want > cap) want = (size_t)cap;
+
+        uint8_t* buf = pipe_acquire(pipe, want);
+        if (!buf) {
+            err_push(st, "Out of memory (read pipeline)");
+            ok = false;
+            break;
+        }
+
+        size_t r = 0;
+        size_t bcap = 0;
+        uint8_t** bufp = pipe_head_buf(pipe, &bcap);
+        uint64_t t0 = now_us();
+        bool rd_ok = guarded_pread(&bufs->guard, f, st->current_path, bufp, bcap, want, off0, &r);
+        uint64_t dt = now_us() - t0;
+        int last_e = errno;
+        if (read_abandoned(st, f, st->current_path, off0, want, "full read")) {
+            ok = false;
+            break;
+        }
         if (r > 0) {
             perf_record(st, r, dt, off0, st->current_path);
-            crc = crc32_update(crc, buf, r);
-            if (!first_crc_set) {
-                size_t a = (r < SAMPLE_REGION) ? r : SAMPLE_REGION;
-                first_crc = crc32_update(0, buf, a);
-                first_crc_set = true;
-            }
+            if (ti >= 0 && r == want && want == tune_size(ti)) tune_record(tune, ti, r, dt);
+            pipe_publish(pipe, r);
             st->bytes_read += r;
             st->current_done += r;
         }
 
-        if (r < chunk) {
-            if (ferror(f)) {
-                int last_e = errno;
+        if (r < want) {
+            if (!rd_ok) {
                 int retries = cfg ? cfg->read_retries : 0;
-                bool ok = false;
+                /* Deferred: the rest of the chunk is read back at the end, zeros take its place in
+                   the CRC, and the read goes on after it. */
+                uint64_t fail_off = st->current_done;
+                uint64_t gap = (size > fail_off) ? size - fail_off : 0;
+                if (gap > want - r) gap = want - r;
+                if (retries > 0 && gap > 0 && retry_defer(rq, cfg, fail_off, gap, last_e, false)) {
+                    st->read_errors_transient++;
+                    buf = pipe_acquire(pipe, (size_t)gap);
+                    if (!buf) {
+                        err_push(st, "Out of memory (read pipeline)");
+                        ok = false;
+                        break;
+                    }
+                    memset(buf, 0, (size_t)gap);
+                    pipe_publish(pipe, (size_t)gap);
+                    st->current_done += gap;
+                    seq_note_crc(st, pipe, rq);
+                    if (ui_update) ui_update(st, pad, false);
+                    continue;
+                }
+                bool retry_ok = false;
                 for (int attempt = 0; attempt < retries; attempt++) {
-                    clearerr(f);
                     st->read_errors_transient++;
-                    svcSleepThread(30 * 1000 * 1000);
-                    errno = 0;
+                    retry_sleep(cfg, attempt, st);
+                    buf = pipe_acquire(pipe, want);
+                    if (!buf) break;
+                    bufp = pipe_head_buf(pipe, &bcap);
                     uint64_t off0b = st->current_done;
-                    uint64_t t0b = now_ms();
-                    r = fread(buf, 1, chunk, f);
-                    uint64_t dtb = now_ms() - t0b;
-                    int eb = errno;
-                    last_e = eb;
+                    uint64_t t0b = now_us();
+                    rd_ok = guarded_pread(&bufs->guard, f, st->current_path, bufp, bcap, want, off0b, &r);
+                    uint64_t dtb = now_us() - t0b;
+                    last_e = errno;
+                    if (read_abandoned(st, f, st->current_path, off0b, want, "full read")) break;
                     if (r > 0) {
                         perf_record(st, r, dtb, off0b, st->current_path);
-                        crc = crc32_update(crc, buf, r);
+                        pipe_publish(pipe, r);
                         st->bytes_read += r;
                         st->current_done += r;
                     }
-                    if (!ferror(f)) { ok = true; break; }
+                    if (rd_ok) { retry_ok = true; break; }
+                }
+                if (!retry_ok && !f->be) {
+                    ok = false;   /* given up */
+                    break;
                 }
-                if (!ok) {
+                if (!retry_ok) {
                     st->read_errors++;
-                    first_fail_capture(st, "READ", st->current_path, st->current_done, chunk, last_e, "full read");
+                    first_fail_capture(st, "READ", st->current_path, st->current_done, want, last_e, "full read");
                     err_push(st, "Full: read error");
-                    return false;
+                    ok = false;
+                    Bisect b;
+                    if (rq && bisect_init(&b, f, st->current_path, cfg, st, &rq->bad, &bufs->guard, &bufs->sample_buf, bufs->sample_cap) &&
+                        size > st->current_done)
+                        bisect_salvage(&b, st->current_done, size - st->current_done, want - r, &st->current_done);
+                    break;
                 }
-                if (r < chunk && !ferror(f)) {
+                if (r < want) {
                     break;
                 }
             } else {
@@ -452,181 +1334,1593 @@ static bool read_full(FILE* f, uint64_t size, const ScanConfig* cfg, ScanStats*
             }
         }
 
+        seq_note_crc(st, pipe, rq);
         if (ui_update) ui_update(st, pad, false);
     }
 
+    pipe_finish(pipe, out_crc, out_first_crc, out_first_set, out_hash);
+    st->hash_us += pipe->hash_us;
+    st->hash_bytes += pipe->hash_bytes;
+    st->hash_wait_us += pipe->wait_us;
+    return ok;
+}
+
+/* start > 0 continues a resumed file there (sequentially; st->current_done must equal start),
+   start_crc being the CRC-32 of the bytes before it.
+   out_hash gets the content digest (len 0 without hash_algo, or after a ranged or resumed read).
+   With regions deferred to rq, the CRC has zeros in their place and the digest is void. */
+static bool read_full(IoFile* f, const char* path, uint64_t size, uint64_t start, uint32_t start_crc, const ScanConfig* cfg, ScanStats* st, ScanBuffers* bufs, ChunkTuner* tune, ScanUiUpdateFn ui_update, PadState* pad, uint32_t* out_crc, HashDigest* out_hash, RetryQueue* rq) {
+    /* A fixed chunk mode bypasses the tuner; range reads use its current choice. */
+    size_t chunk = cfg ? chunk_bytes_from_mode(cfg->chunk_mode) : 0;
+    if (chunk) tune = NULL;
+    else chunk = tune_size(tune ? tune_current(tune) : TUNE_START);
+
+    if (!bufs) return false;
+
+    uint32_t crc = 0;
+    uint32_t first_crc = 0;
+    bool first_crc_set = false;
+    HashDigest digest;
+    memset(&digest, 0, sizeof(digest));
+    bool ranged = false;
+    bool ok = false;
+    /* Segment CRCs combine; a content hash does not, so it needs the sequential read. */
+    if (start == 0 && path && cfg && cfg->range_threads > 1 && cfg->hash_algo == HASH_CRC32 && size > RANGE_SEGMENT &&
+        size >= (uint64_t)cfg->range_min_mib * 1024ull * 1024ull) {
+        ok = read_full_ranged(f, path, size, chunk, cfg, st, &bufs->guard, ui_update, pad, &crc, &first_crc, &first_crc_set, &ranged, rq);
+    }
+    if (!ranged) ok = read_full_seq(f, size, chunk, tune, cfg, st, bufs, ui_update, pad, start_crc, &crc, &first_crc, &first_crc_set, &digest, rq);
+    if (!ok) return false;
+    if (start > 0) {
+        first_crc_set = false;   /* the first chunk was not this session's */
+        memset(&digest, 0, sizeof(digest));   /* the hash saw only the rest */
+    }
+    if (rq && rq->cur_deferred > 0) first_crc_set = false;   /* the CRC skipped a region */
+
     if (ui_update) ui_update(st, pad, true);
 
-    if (cfg && cfg->consistency_check && first_crc_set && !st->cancelled) {
+    if (cfg && cfg->consistency_check && first_crc_set && !st->cancelled && bufs->sample_buf) {
         size_t want = SAMPLE_REGION;
-        if (fseeko(f, 0, SEEK_SET) == 0) {
-            size_t rr = fread(buf, 1, want, f);
-            if (!ferror(f) && rr > 0) {
-                uint32_t c2 = crc32_update(0, buf, rr);
-                if (c2 != first_crc) {
-                    st->consistency_errors++;
-                    first_fail_capture(st, "CONSIST", st->current_path, 0, SAMPLE_REGION, 0, "CRC mismatch");
-                    err_push(st, "Consistency mismatch (first chunk)");
-                    return false;
-                }
-            } else {
-                int e = errno;
-                clearerr(f);
-                st->read_errors++;
-                first_fail_capture(st, "READ", st->current_path, 0, SAMPLE_REGION, e, "consistency read");
-                err_push(st, "Consistency check read failed");
+        size_t rr = 0;
+        uint64_t tv = now_us();
+        bool rd_ok = guarded_pread(&bufs->guard, f, st->current_path, &bufs->sample_buf, bufs->sample_cap, want, 0, &rr);
+        uint64_t tc = now_us();
+        st->verify_us += tc - tv;
+        if (read_abandoned(st, f, st->current_path, 0, want, "consistency read")) return false;
+        if (rd_ok && rr > 0) {
+            uint32_t c2 = crc32_update(0, bufs->sample_buf, rr);
+            uint64_t tc1 = now_us();
+            st->crc_us += tc1 - tc;
+            trace_span(TRACE_CRC, tc, tc1, NULL, 0, rr);
+            if (c2 != first_crc) {
+                st->consistency_errors++;
+                first_fail_capture(st, "CONSIST", st->current_path, 0, SAMPLE_REGION, 0, "CRC mismatch");
+                err_push(st, "Consistency mismatch (first chunk)");
                 return false;
             }
+        } else {
+            int e = errno;
+            st->read_errors++;
+            first_fail_capture(st, "READ", st->current_path, 0, SAMPLE_REGION, e, "consistency read");
+            err_push(st, "Consistency check read failed");
+            return false;
         }
     }
 
     if (out_crc) *out_crc = crc;
+    if (out_hash) *out_hash = digest;
     return !st->cancelled;
 }
 
 /* --------------------------------------------------------------------------
-   Deep scan traversal
+   Work items (walker -> readers)
 ----------------------------------------------------------------------------*/
-static bool scan_dir_recursive(const char* root, const char* path, int depth, const ScanConfig* cfg, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update, ScanBuffers* bufs) {
-    (void)root;
-    if (st->cancelled) return false;
-    if (depth > 128) {
-        st->path_errors++;
-        err_push(st, "Maximum directory depth reached (possible loop)");
-        return true;
+/*
+ * The walker lists directories, applies the filters and opens files; readers consume the
+ * resulting items. Everything the walker learns travels inside the items (its counters as a
+ * running snapshot, failures as records tagged with the item's traversal sequence), so only
+ * readers write ScanStats and the first failure comes out as in a serial scan.
+ */
+static bool work_item_set_path(WorkItem* it, const char* path) {
+    size_t n = strlen(path) + 1;
+    if (n > it->path_cap) {
+        size_t ncap = it->path_cap ? it->path_cap : 256;
+        while (ncap < n) ncap *= 2;
+        char* np = (char*)realloc(it->path, ncap);
+        if (!np) {
+            if (it->path) it->path[0] = 0;
+            return false;
+        }
+        it->path = np;
+        it->path_cap = ncap;
     }
+    memcpy(it->path, path, n);
+    return true;
+}
 
-    if (should_skip_dir(path, cfg)) {
-        st->skipped_dirs++;
-        return true;
+static void work_item_reset(WorkItem* it) {
+    it->kind = WORK_END;
+    if (it->path) it->path[0] = 0;
+    it->size = 0;
+    it->sample = false;
+    it->opened = false;
+    it->resumed = false;
+    it->resume_off = 0;
+    it->resume_crc = 0;
+    it->entered = false;
+    it->mtime_ok = false;
+    it->mtime = 0;
+    it->base = NULL;
+    it->failed = false;
+    it->fail_listed = false;
+    it->fail_kind[0] = 0;
+    it->fail_note[0] = 0;
+    it->fail_errno = 0;
+    it->fail_msg[0] = 0;
+}
+
+static void walk_counts_from_stats(WalkCounts* c, const ScanStats* st) {
+    c->dirs_total = st->dirs_total;
+    c->files_total = st->files_total;
+    c->skipped_dirs = st->skipped_dirs;
+    c->skipped_files = st->skipped_files;
+    c->open_errors = st->open_errors;
+    c->stat_errors = st->stat_errors;
+    c->path_errors = st->path_errors;
+    c->stats_avoided = st->stats_avoided;
+    c->stats_performed = st->stats_performed;
+    c->dir_enum_dirs = st->dir_enum_dirs;
+    c->dir_enum_entries = st->dir_enum_entries;
+    c->dir_enum_us = st->dir_enum_us;
+    c->bytes_total = st->bytes_total;
+    c->mf_new = st->manifest_new;
+    c->mf_changed = st->manifest_changed;
+    c->mf_stale = st->manifest_stale;
+    c->mf_unchanged = st->manifest_unchanged;
+    c->mf_unchanged_bytes = st->manifest_unchanged_bytes;
+}
+
+void walk_counts_apply(ScanStats* st, const WalkCounts* c) {
+    st->dirs_total = c->dirs_total;
+    st->files_total = c->files_total;
+    st->skipped_dirs = c->skipped_dirs;
+    st->skipped_files = c->skipped_files;
+    st->open_errors = c->open_errors;
+    st->stat_errors = c->stat_errors;
+    st->path_errors = c->path_errors;
+    st->stats_avoided = c->stats_avoided;
+    st->stats_performed = c->stats_performed;
+    st->dir_enum_dirs = c->dir_enum_dirs;
+    st->dir_enum_entries = c->dir_enum_entries;
+    st->dir_enum_us = c->dir_enum_us;
+    st->bytes_total = c->bytes_total;
+    st->manifest_new = c->mf_new;
+    st->manifest_changed = c->mf_changed;
+    st->manifest_stale = c->mf_stale;
+    st->manifest_unchanged = c->mf_unchanged;
+    st->manifest_unchanged_bytes = c->mf_unchanged_bytes;
+}
+
+/* --------------------------------------------------------------------------
+   Throughput timeline
+----------------------------------------------------------------------------*/
+typedef struct ScanTimeline {
+    Timeline tl;
+    ScanUiUpdateFn ui_update;    /* next hook (journal or caller); single reader runs through timeline_ui_tick */
+} ScanTimeline;
+
+/* full: also the watchdog's counts (takes its lock; only when an interval ended). */
+static void timeline_counters(const ScanStats* st, TimelineCounters* c, bool full) {
+    memset(c, 0, sizeof(*c));
+    c->bytes = st->bytes_read;
+    c->reads = st->lat[OP_READ].count;
+    c->files = st->files_read;
+    c->errors = st->read_errors + st->read_timeouts + st->open_errors + st->stat_errors + st->consistency_errors;
+    c->paused = st->paused;
+    if (!full) return;
+    c->stalls = watchdog_stall_count();
+    StallLive live;
+    if (watchdog_live(&live)) c->stalled = (uint32_t)live.stalled;
+}
+
+void timeline_sample(ScanStats* st) {
+    ScanTimeline* t = st->timeline;
+    if (!t) return;
+    uint64_t now = now_ms();
+    bool due = timeline_due(&t->tl, now);
+    TimelineCounters c;
+    timeline_counters(st, &c, due);
+    if (due) timeline_tick(&t->tl, &c, now);
+    else timeline_note(&t->tl, &c);
+}
+
+/* ui_update hook of single-reader runs: a sample when due, then the next hook. */
+static void timeline_ui_tick(ScanStats* st, PadState* pad, bool force) {
+    ScanTimeline* t = st->timeline;
+    timeline_sample(st);
+    if (t->ui_update) t->ui_update(st, pad, force);
+}
+
+static ScanTimeline* timeline_create(const ScanConfig* cfg, const ScanStats* st, ScanUiUpdateFn ui_update) {
+    if (cfg->timeline_sec <= 0) return NULL;
+    ScanTimeline* t = (ScanTimeline*)calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    TimelineCounters c;
+    timeline_counters(st, &c, true);
+    if (!timeline_init(&t->tl, cfg->timeline_sec, &c, now_ms())) {
+        free(t);
+        return NULL;
     }
+    t->ui_update = ui_update;
+    return t;
+}
 
-    DIR* d = opendir(path);
-    if (!d) {
-        st->open_errors++;
-        first_fail_capture(st, "OPEN_DIR", path, 0, 0, errno, "opendir");
-        char msg[256];
-        snprintf(msg, sizeof(msg), "opendir failed: %s (%.180s)", strerror(errno), path);
-        err_push(st, msg);
-        fail_push_unique(st, path);
-        return true;
+/* Closes the last interval, writes the CSV next to the log and frees the timeline. */
+static void timeline_export(ScanStats* st) {
+    ScanTimeline* t = st->timeline;
+    if (!t) return;
+    st->timeline = NULL;
+    TimelineCounters c;
+    timeline_counters(st, &c, true);
+    timeline_finish(&t->tl, &c, now_ms());
+    st->timeline_samples = t->tl.count;
+    st->timeline_interval_s = t->tl.interval_ms / 1000u;
+    st->timeline_write_ok = timeline_write_csv(&t->tl, TIMELINE_PATH);
+    if (st->timeline_write_ok)
+        log_pushf("INFO", "Timeline: %u sample(s) of %u s written to %s", st->timeline_samples, st->timeline_interval_s,
+                  TIMELINE_PATH);
+    else
+        log_pushf("WARN", "Timeline: write to %s failed (%s)", TIMELINE_PATH, strerror(errno));
+    timeline_free(&t->tl);
+    free(t);
+}
+
+/* --------------------------------------------------------------------------
+   Trace export
+----------------------------------------------------------------------------*/
+/* After the walker and the readers are joined (hashers are idle then). */
+static void trace_export(ScanStats* st) {
+    if (!trace_active()) return;
+    TraceResult tr;
+    uint64_t t0 = now_us();
+    bool ok = trace_stop(TRACE_PATH, &tr);
+    st->trace_events = tr.events;
+    st->trace_dropped = tr.dropped;
+    st->trace_write_ok = ok;
+    if (ok)
+        log_pushf("INFO", "Trace: %llu event(s) from %d thread(s) written to %s in %llu ms",
+                  (unsigned long long)tr.events, tr.threads, TRACE_PATH, (unsigned long long)((now_us() - t0) / 1000));
+    else
+        log_pushf("WARN", "Trace: write to %s failed (%s)", TRACE_PATH, strerror(errno));
+    if (tr.dropped)
+        log_pushf("WARN", "Trace: buffer full, %llu later event(s) dropped; raise trace_mib.", (unsigned long long)tr.dropped);
+}
+
+/* --------------------------------------------------------------------------
+   Reader side
+----------------------------------------------------------------------------*/
+void file_verified(ScanRun* run, const char* path, uint64_t fsize, int64_t mtime, const ManifestEntry* base,
+                   uint32_t crc, const HashDigest* digest) {
+    ScanStats* st = run->st;
+    bool rot = base && crc != base->crc;
+    /* Recorded with the same algorithm: the digest must match as well. */
+    bool rot_digest = base && !rot && digest->len > 0 && base->hash_algo == (uint32_t)digest->algo &&
+                      memcmp(base->digest, digest->b, digest->len) != 0;
+    if (base) st->bitrot_checked++;
+    if (rot || rot_digest) bitrot_push(st, path, fsize, crc, base, rot_digest ? digest : NULL);
+    /* A mismatch keeps the recorded entry, so the file is reported again until it is rewritten. */
+    if (!run->mf) return;
+    ManifestEntry e;
+    if (rot || rot_digest) {
+        e = *base;
+        e.flags |= MANIFEST_F_BITROT;
+    } else {
+        memset(&e, 0, sizeof(e));
+        e.size = fsize;
+        e.mtime = mtime;
+        e.verified_at = (int64_t)time(NULL);
+        e.crc = crc;
+        e.hash_algo = (uint32_t)digest->algo;
+        memcpy(e.digest, digest->b, digest->len);
+        if (base && digest->len == 0) {
+            /* Same CRC, no hash this run: the recorded digest still describes the content. */
+            e.hash_algo = base->hash_algo;
+            memcpy(e.digest, base->digest, sizeof(e.digest));
+        }
+    }
+    manifest_builder_add(run->mf, path, &e);
+}
+
+/* Time the reading thread spent on the screen or held by a modal one (pause, help, log). */
+static uint64_t held_us(const ScanStats* st) {
+    return st->ui_us + st->pad_us + st->paused_total_ms * 1000;
+}
+
+static void slow_note_file(ScanStats* st, const char* path, uint64_t us, uint64_t held, uint64_t bytes) {
+    us = us > held ? us - held : 0;
+    slow_add(&st->slow_time, us, us, bytes, path);
+    if (bytes >= SLOW_RATE_MIN_BYTES) slow_add(&st->slow_rate, slow_rate_key(us, bytes), us, bytes, path);
+}
+
+bool work_consume(ScanRun* run, WorkItem* it) {
+    ScanStats* st = run->st;
+    const ScanConfig* cfg = run->cfg;
+    ResumeCursor* cur = run->cursor;
+    walk_counts_apply(st, &it->counts);
+    if (cur) resume_cursor_take(cur, it);
+
+    if (it->failed) {
+        if (it->fail_kind[0]) first_fail_capture(st, it->fail_kind, it->path, 0, 0, it->fail_errno, it->fail_note);
+        err_push(st, it->fail_msg);
+        if (it->fail_listed) fail_push_unique(st, it->path);
     }
 
-    struct dirent* ent;
-    while ((ent = readdir(d)) != NULL) {
-        if (ui_update) ui_update(st, pad, false);
-        if (st->cancelled) break;
-
-        const char* name = ent->d_name;
-        if (!name) continue;
-        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
-
-        char child[PATH_MAX_LOCAL];
-        int n = snprintf(child, sizeof(child), "%s/%s", path, name);
-        if (n <= 0 || (size_t)n >= sizeof(child)) {
-            st->path_errors++;
-            first_fail_capture(st, "PATH", path, 0, 0, 0, "Path too long");
-            err_push(st, "Path too long (snprintf)");
-            continue;
+    if (it->kind != WORK_FILE || !it->opened) return !st->cancelled;
+
+    /* Time budget: the policy is picked as late as possible, when the file is about to be read. */
+    double sample_pct = -1.0;
+    uint64_t plan_bytes = 0;
+    if (run->plan) {
+        PlanChoice ch;
+        while ((ch = plan_decide(run->plan, cfg, it->path, it->size, &sample_pct, &plan_bytes)) == PLAN_HOLD && !st->cancelled) {
+            if (run->ui_update) run->ui_update(st, run->pad, false);
+            svcSleepThread(10 * 1000 * 1000);
         }
+        if (ch == PLAN_HOLD) {
+            op_close(&it->f, it->path, st->lat);
+            it->opened = false;
+            return false;
+        }
+        if (ch == PLAN_SKIP) {
+            /* Not read: a valid old record stays (a pruning run would drop it otherwise). */
+            if (run->mf && it->base) manifest_builder_carry(run->mf, it->path, it->base);
+            st->budget_skipped++;
+            st->budget_skipped_bytes += it->size;
+            op_close(&it->f, it->path, st->lat);
+            it->opened = false;
+            return !st->cancelled;
+        }
+        it->sample = (ch == PLAN_SAMPLE);
+        if (it->sample) st->budget_sampled++;
+        else st->budget_full++;
+        /* Coverage of this file: the share of its bytes the policy reads. */
+        double share = (it->sample && it->size) ? (double)plan_bytes / (double)it->size : 1.0;
+        if (share > 1.0) share = 1.0;
+        if (st->budget_full + st->budget_sampled == 1 || share < st->budget_share_min) st->budget_share_min = share;
+        st->budget_share_sum += share;
+    }
 
-        struct stat s;
-        if (stat(child, &s) != 0) {
-            st->stat_errors++;
-            first_fail_capture(st, "STAT", child, 0, 0, errno, "stat");
-            char msg[256];
-            snprintf(msg, sizeof(msg), "stat failed: %s (%.180s)", strerror(errno), child);
-            err_push(st, msg);
-            fail_push_unique(st, child);
+    uint64_t t0 = now_us();
+    uint64_t held0 = held_us(st);
+    uint64_t bytes0 = st->bytes_read;
+    uint64_t io0 = st->read_io_us;
+    uint64_t fsize = it->size;
+    snprintf(st->current_path, sizeof(st->current_path), "%.250s", it->path);
+    st->current_size = fsize;
+    st->current_done = it->resume_off;
+    st->current_sample = it->sample;
+    st->current_seq_read = (it->resume_off > 0);
+    st->current_crc = it->resume_crc;
+    st->current_crc_off = it->resume_off;
+    if (cur) {
+        cur->busy = true;
+        cur->started = it->resumed;
+    }
+
+    SamplePlan plan;
+    if (it->sample) {
+        sample_plan(&plan, fsize, cfg, it->path, sample_pct);
+        st->current_planned = sample_planned_bytes(&plan);
+        if (!it->resumed) {
+            st->sample_files++;
+            st->sample_span_bytes += fsize;
+        }
+    } else {
+        st->current_planned = fsize;
+    }
+
+    if (run->ui_update) run->ui_update(st, run->pad, true);
+    if (st->cancelled) {
+        op_close(&it->f, it->path, st->lat);
+        it->opened = false;
+        return false;
+    }
+
+    if (!it->resumed) st->files_read++;
+    if (cur) cur->started = true;
+    guard_bind(&run->bufs->guard, st, run->ui_update, run->pad);
+    RetryQueue* rq = run->retry;
+    if (rq) {
+        rq->cur_path = it->path;
+        rq->cur_be = it->f.be;
+        rq->cur_seq = it->seq;
+        rq->cur_deferred = 0;
+    }
+    uint32_t crc = 0;
+    HashDigest digest;
+    memset(&digest, 0, sizeof(digest));
+    bool ok = it->sample ? read_sample(&it->f, &plan, cfg, st, run->bufs, run->ui_update, run->pad, &crc, rq)
+                         : read_full  (&it->f, it->path, fsize, it->resume_off, it->resume_crc, cfg, st, run->bufs, run->tune, run->ui_update, run->pad, &crc, &digest, rq);
+    /* A read given up skips the file: regions queued before it are not retried either. */
+    if (!it->f.be && rq) retry_forget_file(rq);
+    op_close(&it->f, it->path, st->lat);
+    it->opened = false;
+    if (cur && !st->cancelled) cur->busy = false;
+    if (!st->cancelled) slow_note_file(st, it->path, now_us() - t0, held_us(st) - held0, st->bytes_read - bytes0);
+    bool deferred = rq && rq->cur_deferred > 0;
+    if (rq) {
+        bad_file_flush(st, &rq->bad);
+        rq->cur_path = NULL;
+    }
+    /* Only a whole-file CRC is compared and goes into the manifest (a resumed read finishes the
+       CRC it continued from). A sample is none: the old record of an unchanged file stays as it was. */
+    if (ok && it->sample && run->mf && it->base) manifest_builder_carry(run->mf, it->path, it->base);
+    if (ok && it->mtime_ok && !it->sample) {
+        if (!deferred) file_verified(run, it->path, fsize, it->mtime, it->base, crc, &digest);
+        else if (run->mf || it->base) retry_hold_file(rq, it, fsize, crc);
+    }
+    st->read_busy_us += now_us() - t0;
+    if (run->plan) {
+        plan_note(run->plan, plan_bytes, st->bytes_read - bytes0, st->read_io_us - io0);
+        plan_publish(run->plan, st);
+    }
+
+    if (!ok) {
+        fail_push_unique(st, it->path);
+        if (st->cancelled) return false;
+    }
+    return true;
+}
+
+/* --------------------------------------------------------------------------
+   Look-ahead queue (bounded, lock-free)
+----------------------------------------------------------------------------*/
+static bool work_queue_init(WorkQueue* q, int depth) {
+    memset(q, 0, sizeof(*q));
+    if (depth < 1) depth = 1;
+    q->cells = (WorkCell*)calloc((size_t)depth, sizeof(WorkCell));
+    if (!q->cells) return false;
+    q->cap = (uint32_t)depth;
+    for (uint32_t i = 0; i < q->cap; i++) atomic_init(&q->cells[i].seq, i);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->stop, false);
+    return true;
+}
+
+static void work_queue_free(WorkQueue* q) {
+    if (q->cells) {
+        for (uint32_t i = 0; i < q->cap; i++) {
+            WorkItem* it = &q->cells[i].item;
+            if (it->opened) op_close(&it->f, it->path, NULL);   /* published but never taken (cancel) */
+            free(it->path);
+        }
+        free(q->cells);
+    }
+    memset(q, 0, sizeof(*q));
+}
+
+bool work_queue_pop(WorkQueue* q, WorkItem* out) {
+    uint64_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    for (;;) {
+        WorkCell* cell = &q->cells[pos % q->cap];
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t dif = (int64_t)(seq - (pos + 1));
+        if (dif < 0) return false;
+        if (dif > 0) {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+            continue;
+        }
+        if (!atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                   memory_order_relaxed, memory_order_relaxed)) {
             continue;
         }
+        char* spare = out->path;
+        size_t spare_cap = out->path_cap;
+        *out = cell->item;
+        cell->item.path = spare;
+        cell->item.path_cap = spare_cap;
+        cell->item.opened = false;
+        atomic_store_explicit(&cell->seq, pos + q->cap, memory_order_release);
+        return true;
+    }
+}
+
+void queue_backoff(uint32_t* round) {
+    uint32_t r = (*round)++;
+    if (r < 64) {
+        svcSleepThread(0);
+        return;
+    }
+    r -= 64;
+    int64_t ns = 20 * 1000ll << (r < 5 ? r : 5);
+    svcSleepThread(ns);
+}
 
-        if (S_ISDIR(s.st_mode)) {
-            st->dirs_total++;
+/* --------------------------------------------------------------------------
+   Deep scan traversal (iterative walker)
+----------------------------------------------------------------------------*/
+/*
+ * One frame per directory on the current path. A frame's listing lives on the shared
+ * IoDirArena; the path of every frame is a prefix of the walker's single path buffer.
+ * Memory is the listings of the directories on the current path plus one frame each,
+ * so depth is only limited by what the filesystem accepts.
+ */
+typedef struct {
+    size_t first;        /* listing: arena entries [first, first + count) */
+    size_t count;
+    size_t next;         /* next entry to visit */
+    size_t path_len;     /* length of this directory's path in the buffer */
+    size_t mark_count;   /* arena top before the listing (restored on pop) */
+    size_t mark_names;
+} WalkFrame;
 
-            if (should_skip_dir(child, cfg)) {
-                st->skipped_dirs++;
-                continue;
-            }
+typedef struct {
+    char*      path;
+    size_t     len;
+    size_t     cap;
+    WalkFrame* frames;
+    size_t     depth;
+    size_t     frames_cap;
+} Walker;
+
+/*
+ * Walk state. With a queue the walk runs on its own thread and only talks to the readers
+ * through the ring; without one, each item is consumed inline (serial scan).
+ */
+typedef struct {
+    const IoBackend*  io;
+    const ScanConfig* cfg;
+    const char*       root;
+    IoDirArena*       arena;
+    Walker            w;
+    WalkCounts        counts;
+    uint64_t          seq;
+    bool              stopped;
+
+    /* Largest files, kept here in traversal order so the list does not depend on readers. */
+    LargestEntry      largest[LARGEST_MAX];
+    int               largest_count;
+    SlowList          slow_dirs;  /* likewise the slowest listings */
+
+    WorkQueue*        q;
+    WorkItem          inline_item;
+    ScanRun*          run;        /* inline consumer (q == NULL) */
+
+    BudgetPlan*       plan;       /* time budget: per-file policy */
+    bool              prepass;    /* budget pre-pass: list and size files, emit nothing */
+
+    const Manifest*   mf;         /* NULL: no manifest */
+    ManifestBuilder*  mf_keep;    /* incremental: unchanged files, carried into the new manifest */
+    int64_t           mf_stale_before; /* verified before this: stale (0 = never) */
+
+    const ResumeImage* resume;    /* resumed scan: in-flight files and the cursor */
+    bool              restoring;  /* descending to the cursor: listings are not counted again */
+
+    LatHist           lat[OP_KIND_COUNT];   /* listing, stat and open latencies of the walk */
+} WalkCtx;
+
+static bool walk_path_reserve(Walker* w, size_t need) {
+    if (need <= w->cap) return true;
+    size_t ncap = w->cap ? w->cap : 512;
+    while (ncap < need) ncap *= 2;
+    char* np = (char*)realloc(w->path, ncap);
+    if (!np) return false;
+    w->path = np;
+    w->cap = ncap;
+    return true;
+}
 
-            snprintf(st->current_path, sizeof(st->current_path), "%.250s", child);
-            st->current_size = 0;
-            st->current_planned = 0;
-            st->current_done = 0;
-            st->current_sample = false;
+/* Appends "/name" to the current path. */
+static bool walk_path_push(Walker* w, const char* name) {
+    size_t nl = strlen(name);
+    bool slash = (w->len == 0 || w->path[w->len - 1] != '/');
+    if (!walk_path_reserve(w, w->len + (slash ? 1 : 0) + nl + 1)) return false;
+    if (slash) w->path[w->len++] = '/';
+    memcpy(w->path + w->len, name, nl + 1);
+    w->len += nl;
+    return true;
+}
 
-            if (!scan_dir_recursive(root, child, depth + 1, cfg, st, pad, ui_update, bufs)) break;
+static void walk_path_truncate(Walker* w, size_t len) {
+    w->len = len;
+    w->path[len] = 0;
+}
 
-        } else if (S_ISREG(s.st_mode)) {
-            st->files_total++;
-            uint64_t fsize = (uint64_t)s.st_size;
-            largest_update(st, child, fsize);
+static void walk_free(Walker* w) {
+    free(w->path);
+    free(w->frames);
+    memset(w, 0, sizeof(*w));
+}
 
-            if (should_skip_file(child, cfg)) {
-                st->skipped_files++;
-                continue;
+/* Next item to fill (blocks while the ring is full). NULL once the readers have stopped. */
+static WorkItem* walk_item_begin(WalkCtx* c) {
+    if (c->stopped) return NULL;
+    WorkItem* it = &c->inline_item;
+    if (c->q) {
+        WorkQueue* q = c->q;
+        uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        WorkCell* cell = &q->cells[pos % q->cap];
+        uint32_t wait_round = 0;
+        while (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos) {
+            if (atomic_load_explicit(&q->stop, memory_order_relaxed)) {
+                c->stopped = true;
+                return NULL;
             }
+            queue_backoff(&wait_round);
+        }
+        it = &cell->item;
+    }
+    work_item_reset(it);
+    return it;
+}
 
-            bool sample = (!cfg->full_read && fsize > cfg->large_file_limit);
+/* Hands the item to the readers. */
+static void walk_item_commit(WalkCtx* c, WorkItem* it) {
+    it->counts = c->counts;
+    it->seq = c->seq++;
+    if (!c->q) {
+        if (!work_consume(c->run, it)) c->stopped = true;
+        return;
+    }
+    WorkQueue* q = c->q;
+    uint64_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_store_explicit(&q->head, pos + 1, memory_order_relaxed);
+    atomic_store_explicit(&q->cells[pos % q->cap].seq, pos + 1, memory_order_release);
+    if (atomic_load_explicit(&q->stop, memory_order_relaxed)) c->stopped = true;
+}
 
-            snprintf(st->current_path, sizeof(st->current_path), "%.250s", child);
-            st->current_size = fsize;
-            st->current_done = 0;
-            st->current_sample = sample;
+/* Periodic check while listing (every 64 entries). Returns false once the scan is stopping. */
+static bool walk_tick(WalkCtx* c) {
+    if (c->q) {
+        if (atomic_load_explicit(&c->q->stop, memory_order_relaxed)) c->stopped = true;
+        return !c->stopped;
+    }
+    ScanRun* run = c->run;
+    walk_counts_apply(run->st, &c->counts);
+    if (run->ui_update) run->ui_update(run->st, run->pad, false);
+    if (run->st->cancelled) c->stopped = true;
+    return !c->stopped;
+}
 
-            if (sample) {
-                uint64_t want = SAMPLE_REGION;
-                uint64_t p1 = (fsize < want) ? fsize : want;
-                uint64_t p2 = (fsize > want) ? want : 0;
-                st->current_planned = p1 + p2;
-            } else {
-                st->current_planned = fsize;
-            }
+/* Records a failure. msg == NULL formats "<note> failed: <strerror> (<path>)". */
+static void walk_emit_fail(WalkCtx* c, const char* kind, const char* note, int err, const char* path, const char* msg, bool listed) {
+    if (c->prepass) return;   /* the scan itself reports it */
+    WorkItem* it = walk_item_begin(c);
+    if (!it) return;
+    it->kind = WORK_FAIL;
+    work_item_set_path(it, path);
+    it->failed = true;
+    it->fail_listed = listed;
+    snprintf(it->fail_kind, sizeof(it->fail_kind), "%s", kind ? kind : "");
+    snprintf(it->fail_note, sizeof(it->fail_note), "%s", note ? note : "");
+    it->fail_errno = err;
+    /* A partial listing is still walked: a resume continues inside that directory. */
+    it->entered = (kind && strcmp(kind, "READ_DIR") == 0);
+    if (msg) snprintf(it->fail_msg, sizeof(it->fail_msg), "%s", msg);
+    else snprintf(it->fail_msg, sizeof(it->fail_msg), "%s failed: %s (%.180s)", note, strerror(err), path);
+    walk_item_commit(c, it);
+}
 
-            if (ui_update) ui_update(st, pad, true);
-            if (st->cancelled) break;
+/* Opens the item's file, or turns the item into its open failure. */
+static void walk_item_open(WalkCtx* c, WorkItem* it) {
+    if (op_open(c->io, it->path, &it->f, c->lat)) {
+        it->opened = true;
+        return;
+    }
+    int e = errno;
+    c->counts.open_errors++;
+    it->failed = true;
+    it->fail_listed = true;
+    snprintf(it->fail_kind, sizeof(it->fail_kind), "OPEN_FILE");
+    snprintf(it->fail_note, sizeof(it->fail_note), "open");
+    it->fail_errno = e;
+    snprintf(it->fail_msg, sizeof(it->fail_msg), "open failed: %s (%.180s)", strerror(e), it->path);
+}
 
-            FILE* f = fopen(child, "rb");
-            if (!f) {
-                st->open_errors++;
-                first_fail_capture(st, "OPEN_FILE", child, 0, 0, errno, "fopen");
-                char msg[256];
-                snprintf(msg, sizeof(msg), "fopen failed: %s (%.180s)", strerror(errno), child);
-                err_push(st, msg);
-                fail_push_unique(st, child);
+/*
+ * Classifies a file against its manifest entry e (NULL: none). Returns true if an incremental scan
+ * skips it (same size and mtime, verified within stale_days); its entry then carries over as is.
+ * *base is set to the entry when size and mtime match: a full read is checked against its CRC.
+ */
+static bool walk_manifest_check(WalkCtx* c, const char* path, const ManifestEntry* e, uint64_t fsize, int64_t mtime,
+                                bool mtime_ok, const ManifestEntry** base) {
+    *base = NULL;
+    if (!e) {
+        c->counts.mf_new++;
+        return false;
+    }
+    if (!mtime_ok || e->size != fsize || e->mtime != mtime) {
+        c->counts.mf_changed++;
+        return false;
+    }
+    *base = e;
+    if ((e->flags & MANIFEST_F_BITROT) || (c->mf_stale_before && e->verified_at < c->mf_stale_before)) {
+        c->counts.mf_stale++;
+        return false;
+    }
+    c->counts.mf_unchanged++;
+    c->counts.mf_unchanged_bytes += fsize;
+    if (!c->cfg->incremental) return false;
+    if (c->mf_keep && !c->prepass) manifest_builder_carry(c->mf_keep, path, e);
+    return true;
+}
+
+/* A metadata request of its own (the listing or stat had no mtime): counted with the stat() calls. */
+static bool walk_mtime(WalkCtx* c, const char* path, int64_t* out) {
+    c->counts.stats_performed++;
+    return op_mtime(c->io, path, out, c->lat);
+}
+
+/*
+ * Regular file: filter, pre-open and hand over. The mtime is fetched only where the manifest
+ * needs it and the stat did not give it: to compare an entry of the same size, and to record a
+ * file read in full. A time-budget pre-pass classifies files only when it may skip them.
+ */
+static void walk_file(WalkCtx* c, const char* path, const IoStat* s) {
+    uint64_t fsize = s->size;
+    c->counts.files_total++;
+    largest_update(c->largest, &c->largest_count, path, fsize);
+
+    if (should_skip_file(path, c->cfg)) {
+        c->counts.skipped_files++;
+        return;
+    }
+
+    int64_t mtime = s->mtime;
+    bool mtime_ok = s->has_mtime;
+    bool mtime_tried = s->has_mtime;
+    const ManifestEntry* base = NULL;
+    if (c->cfg->manifest && (!c->prepass || c->cfg->incremental)) {
+        const ManifestEntry* e = manifest_find(c->mf, path);
+        if (e && e->size == fsize && !mtime_tried) {
+            mtime_ok = walk_mtime(c, path, &mtime);
+            mtime_tried = true;
+        }
+        if (walk_manifest_check(c, path, e, fsize, mtime, mtime_ok, &base)) return;
+    }
+
+    c->counts.bytes_total += fsize;
+    if (c->prepass) {
+        plan_add(c->plan, fsize);
+        return;
+    }
+
+    WorkItem* it = walk_item_begin(c);
+    if (!it) return;
+    if (!work_item_set_path(it, path)) {
+        c->counts.path_errors++;
+        it->kind = WORK_FAIL;
+        it->failed = true;
+        snprintf(it->fail_msg, sizeof(it->fail_msg), "Out of memory (path buffer)");
+        walk_item_commit(c, it);
+        return;
+    }
+
+    it->kind = WORK_FILE;
+    it->size = fsize;
+    it->sample = (!c->cfg->full_read && fsize > c->cfg->large_file_limit);
+    if (c->cfg->manifest && !mtime_tried && !it->sample) mtime_ok = walk_mtime(c, path, &mtime);
+    it->mtime = mtime;
+    it->mtime_ok = mtime_ok;
+    it->base = base;
+    walk_item_open(c, it);
+    walk_item_commit(c, it);
+}
+
+/* Resume: the files that were in flight go first (their sizes were counted before). */
+static void walk_resume_files(WalkCtx* c) {
+    const ResumeImage* r = c->resume;
+    for (uint32_t i = 0; i < r->nfiles && !c->stopped; i++) {
+        const ResumeFile* rf = &r->files[i];
+        WorkItem* it = walk_item_begin(c);
+        if (!it) return;
+        if (!work_item_set_path(it, rf->path)) {
+            c->counts.path_errors++;
+            it->kind = WORK_FAIL;
+            it->failed = true;
+            snprintf(it->fail_msg, sizeof(it->fail_msg), "Out of memory (path buffer)");
+            walk_item_commit(c, it);
+            continue;
+        }
+        it->kind = WORK_FILE;
+        it->size = rf->size;
+        it->sample = rf->sample;
+        it->resumed = rf->started;
+        it->resume_off = rf->off;
+        /* A file read from its start, or continued from the CRC of the part before while it is
+           unchanged, goes into the manifest. */
+        if (c->cfg->manifest && !rf->sample && (rf->off == 0 || rf->crc_set)) {
+            it->mtime_ok = walk_mtime(c, rf->path, &it->mtime);
+            if (rf->off > 0 && it->mtime != rf->mtime) it->mtime_ok = false;
+            it->resume_crc = rf->crc;
+            const ManifestEntry* e = it->mtime_ok ? manifest_find(c->mf, rf->path) : NULL;
+            if (e && e->size == rf->size && e->mtime == it->mtime) it->base = e;
+        }
+        walk_item_open(c, it);
+        walk_item_commit(c, it);
+    }
+}
+
+/* Lists the directory at the current path and pushes its frame. */
+static bool walk_enter(WalkCtx* c) {
+    Walker* w = &c->w;
+    IoDirArena* arena = c->arena;
+    if (w->depth == w->frames_cap) {
+        size_t ncap = w->frames_cap ? w->frames_cap * 2 : 32;
+        WalkFrame* nf = (WalkFrame*)realloc(w->frames, ncap * sizeof(*nf));
+        if (!nf) {
+            c->counts.path_errors++;
+            walk_emit_fail(c, NULL, NULL, ENOMEM, w->path, "Out of memory (directory stack)", false);
+            return false;
+        }
+        w->frames = nf;
+        w->frames_cap = ncap;
+    }
+
+    const char* path = w->path;
+    WalkFrame fr;
+    memset(&fr, 0, sizeof(fr));
+    fr.path_len = w->len;
+    fr.mark_count = arena->count;
+    fr.mark_names = arena->names_len;
+
+    /* The whole listing is read up front (batched) and processed from memory. */
+    int list_errno = 0;
+    uint64_t t0 = now_us();
+    bool listed = io_list_dir(c->io, path, arena, &fr.first, &fr.count, &list_errno, c->lat);
+    int e = errno;
+    uint64_t dt = now_us() - t0;
+    if (!c->restoring) c->counts.dir_enum_us += dt;
+
+    if (!listed) {
+        c->counts.open_errors++;
+        walk_emit_fail(c, "OPEN_DIR", "opendir", e, path, NULL, true);
+        return false;
+    }
+    if (!c->restoring) {
+        c->counts.dir_enum_dirs++;
+        c->counts.dir_enum_entries += fr.count;
+        slow_add(&c->slow_dirs, slow_dir_key(dt, fr.count), dt, fr.count, path);
+    }
+
+    if (list_errno && !c->restoring) {
+        c->counts.open_errors++;
+        walk_emit_fail(c, "READ_DIR", "readdir", list_errno, path, NULL, true);
+    }
+
+    w->frames[w->depth++] = fr;
+    return true;
+}
+
+static void walk_leave(WalkCtx* c) {
+    Walker* w = &c->w;
+    WalkFrame* fr = &w->frames[--w->depth];
+    io_arena_truncate(c->arena, fr->mark_count, fr->mark_names);
+    if (w->depth > 0) walk_path_truncate(w, w->frames[w->depth - 1].path_len);
+}
+
+/* Serial scans show the directory being listed; with look-ahead the readers own the display. */
+static void walk_note_dir(WalkCtx* c, const char* path) {
+    if (c->q) return;
+    ScanStats* st = c->run->st;
+    snprintf(st->current_path, sizeof(st->current_path), "%.250s", path);
+    st->current_size = 0;
+    st->current_planned = 0;
+    st->current_done = 0;
+    st->current_sample = false;
+}
+
+/*
+ * Resume: with the root listed, descends to the journal's cursor by name (entries before it
+ * on every level are done) and leaves the walk just after it. A name that is gone rescans its
+ * directory from the start.
+ */
+static void walk_restore(WalkCtx* c) {
+    const ResumeImage* r = c->resume;
+    Walker* w = &c->w;
+    size_t rl = strlen(c->root);
+    if (strncmp(r->cursor, c->root, rl) != 0) {
+        log_pushf("WARN", "Resume: cursor %.120s is outside %.60s; walking the whole tree.", r->cursor, c->root);
+        return;
+    }
+    const char* rel = r->cursor + rl;
+    char name[RESUME_PATH_MAX];
+    while (*rel == '/') rel++;
+    while (*rel && w->depth > 0) {
+        const char* slash = strchr(rel, '/');
+        size_t n = slash ? (size_t)(slash - rel) : strlen(rel);
+        memcpy(name, rel, n);
+        name[n] = 0;
+        rel += n;
+        while (*rel == '/') rel++;
+
+        WalkFrame* fr = &w->frames[w->depth - 1];
+        size_t i = 0;
+        while (i < fr->count && strcmp(io_arena_name(c->arena, &c->arena->ents[fr->first + i]), name) != 0) i++;
+        if (i == fr->count) {
+            log_pushf("WARN", "Resume: %.80s is gone; %.120s is scanned again.", name, w->path);
+            return;
+        }
+        fr->next = i + 1;
+        if (!*rel && !r->cursor_enter) return;
+
+        size_t dir_len = fr->path_len;
+        if (!walk_path_push(w, name)) {
+            walk_path_truncate(w, dir_len);
+            return;
+        }
+        if (!walk_enter(c)) {
+            walk_path_truncate(w, dir_len);
+            return;
+        }
+    }
+}
+
+static void scan_walk(WalkCtx* c) {
+    Walker* w = &c->w;
+    const ScanConfig* cfg = c->cfg;
+    IoDirArena* arena = c->arena;
+    memset(w, 0, sizeof(*w));
+
+    if (c->resume) walk_resume_files(c);
+
+    if (c->resume && c->resume->cursor_end) {
+        /* The walk had finished; only the in-flight files were left. */
+    } else if (should_skip_dir(c->root, cfg)) {
+        c->counts.skipped_dirs++;
+    } else {
+        size_t rl = strlen(c->root);
+        if (walk_path_reserve(w, rl + 1)) {
+            memcpy(w->path, c->root, rl + 1);
+            w->len = rl;
+            c->restoring = (c->resume && c->resume->cursor_set);
+            if (walk_enter(c) && c->restoring) walk_restore(c);
+            c->restoring = false;
+        } else {
+            c->counts.path_errors++;
+            walk_emit_fail(c, NULL, NULL, ENOMEM, c->root, "Out of memory (path buffer)", false);
+        }
+    }
+
+    while (w->depth > 0 && !c->stopped) {
+        WalkFrame* fr = &w->frames[w->depth - 1];
+        if (fr->next >= fr->count) {
+            walk_leave(c);
+            continue;
+        }
+
+        size_t i = fr->next++;
+        size_t dir_len = fr->path_len;
+        if ((i % 64) == 0 && !walk_tick(c)) break;
+
+        /* By value: the arena can move while a subdirectory is listed. */
+        const IoDirEntry ent = arena->ents[fr->first + i];
+
+        if (!walk_path_push(w, io_arena_name(arena, &ent))) {
+            walk_path_truncate(w, dir_len);
+            c->counts.path_errors++;
+            walk_emit_fail(c, "PATH", "Path buffer", ENOMEM, w->path, "Out of memory (path buffer)", false);
+            continue;
+        }
+        const char* child = w->path;
+
+        /* Type and size come from the directory read when the backend provides them. */
+        IoStat s;
+        memset(&s, 0, sizeof(s));
+        bool meta_ok = false;
+        if (ent.type == IO_ENT_DIR) {
+            s.is_dir = true;
+            meta_ok = true;
+        } else if (ent.type == IO_ENT_FILE && ent.has_size) {
+            s.is_reg = true;
+            s.size = ent.size;
+            meta_ok = true;
+        } else if (ent.type == IO_ENT_OTHER) {
+            meta_ok = true;
+        }
+
+        if (meta_ok) {
+            c->counts.stats_avoided++;
+        } else {
+            c->counts.stats_performed++;
+            if (!op_stat(c->io, child, &s, c->lat)) {
+                c->counts.stat_errors++;
+                walk_emit_fail(c, "STAT", "stat", errno, child, NULL, true);
+                walk_path_truncate(w, dir_len);
                 continue;
             }
+        }
 
-            st->files_read++;
-            uint32_t crc = 0;
-            bool ok = sample ? read_sample(f, fsize, cfg, st, bufs, ui_update, pad, &crc)
-                             : read_full  (f, fsize, cfg, st, bufs, ui_update, pad, &crc);
-            fclose(f);
+        if (s.is_dir) {
+            c->counts.dirs_total++;
+            if (!should_skip_dir(child, cfg)) {
+                walk_note_dir(c, child);
+                /* Descend: the child's frame now owns the extended path. */
+                if (walk_enter(c)) continue;
+            } else {
+                c->counts.skipped_dirs++;
+            }
+        } else if (s.is_reg) {
+            walk_file(c, child, &s);
+        }
+
+        walk_path_truncate(w, dir_len);
+    }
+
+    while (w->depth > 0) walk_leave(c);
+    walk_free(w);
+    if (c->prepass) return;
+
+    WorkItem* it = walk_item_begin(c);
+    if (it) {
+        it->kind = WORK_END;
+        walk_item_commit(c, it);
+    }
+}
 
-            if (!ok) {
-                fail_push_unique(st, child);
-                if (st->cancelled) break;
+static void walk_thread_main(void* arg) {
+    trace_thread("walker");
+    scan_walk((WalkCtx*)arg);
+}
+
+/* Single reader on the UI thread: consumes items until the walker's END or a cancel. */
+static void scan_read_queued(ScanRun* run, WorkQueue* q) {
+    ScanStats* st = run->st;
+    WorkItem it;
+    memset(&it, 0, sizeof(it));
+    for (;;) {
+        if (!work_queue_pop(q, &it)) {
+            /* Walker behind (listing, stat, open): keep the UI responsive while waiting. */
+            uint64_t t0 = now_us();
+            uint32_t wait_round = 0;
+            bool got = false;
+            while (!st->cancelled && !(got = work_queue_pop(q, &it))) {
+                if (run->ui_update) run->ui_update(st, run->pad, false);
+                queue_backoff(&wait_round);
             }
+            st->walk_wait_us += now_us() - t0;
+            if (!got) break;
         }
+
+        bool end = (it.kind == WORK_END);
+        bool go = work_consume(run, &it);
+        if (end || !go) break;
     }
+    free(it.path);
+}
 
-    closedir(d);
-    return !st->cancelled;
+/* Time budget: lists the tree on the calling thread (UI stays live) and sizes what the scan will read. */
+static void plan_prepass(BudgetPlan* plan, const char* root, const ScanConfig* cfg, const IoBackend* io, IoDirArena* arena, ScanRun* run,
+                         const Manifest* mf, int64_t mf_stale_before) {
+    ScanStats* st = run->st;
+    uint64_t t0 = now_us();
+    WalkCtx* c = (WalkCtx*)calloc(1, sizeof(*c));
+    if (c) {
+        c->io = io;
+        c->cfg = cfg;
+        c->root = root;
+        c->arena = arena;
+        c->run = run;
+        c->plan = plan;
+        c->prepass = true;
+        c->mf = mf;
+        c->mf_stale_before = mf_stale_before;
+        st->budget_planning = true;
+        scan_walk(c);
+        st->budget_planning = false;
+        plan->pre_enum_us = c->counts.dir_enum_us;
+        free(c);
+    } else {
+        log_push("WARN", "Time budget: pre-pass skipped (out of memory); every file is read.");
+    }
+    plan->scan_start_us = now_us();
+    st->budget_pre_files = plan->pre_files;
+    st->budget_pre_bytes = plan->pre_bytes;
+    st->budget_pre_ms = (plan->scan_start_us - t0) / 1000;
+    log_pushf("INFO", "Time budget %d min: pre-pass found %llu files, %.1f MiB in %llu ms",
+              cfg->time_budget_min, (unsigned long long)plan->pre_files, (double)plan->pre_bytes / 1048576.0,
+              (unsigned long long)st->budget_pre_ms);
 }
 
-bool scan_engine_run(const char* root, const ScanConfig* cfg, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update) {
-    if (!root || !cfg || !st) return false;
+/* One log line per entry of the slowest lists, slowest first. */
+static void slow_log(const ScanStats* st) {
+    SlowEntry e[SLOW_MAX];
+    char disp[112];
+    int n = slow_sorted(&st->slow_rate, e);
+    for (int i = 0; i < n; i++) {
+        tail_ellipsize(disp, sizeof(disp), e[i].path, 100);
+        log_pushf("INFO", "Slowest file %d by rate: %.2f MiB/s, %.1f MiB in %.1f ms: %s", i + 1, slow_mib_s(&e[i]),
+                  (double)e[i].n / 1048576.0, (double)e[i].us / 1000.0, disp);
+    }
+    n = slow_sorted(&st->slow_time, e);
+    for (int i = 0; i < n; i++) {
+        tail_ellipsize(disp, sizeof(disp), e[i].path, 100);
+        log_pushf("INFO", "Slowest file %d by time: %.1f ms, %.1f MiB: %s", i + 1, (double)e[i].us / 1000.0,
+                  (double)e[i].n / 1048576.0, disp);
+    }
+    n = slow_sorted(&st->slow_dirs, e);
+    for (int i = 0; i < n; i++) {
+        tail_ellipsize(disp, sizeof(disp), e[i].path, 100);
+        log_pushf("INFO", "Slowest directory %d: %llu us per entry, %llu entries in %.1f ms: %s", i + 1,
+                  (unsigned long long)e[i].key, (unsigned long long)e[i].n, (double)e[i].us / 1000.0, disp);
+    }
+}
 
-    crc32_init();
+/* A fresh scan (resume == NULL) or the continuation of a journaled one. */
+static bool scan_exec(const char* root, const ScanConfig* cfg, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update, const ResumeImage* resume) {
+    uint64_t t_start = now_us();
 
+    crc32_init();
+    if (cfg->hash_algo != HASH_CRC32) hash_init();
+
+    /* Run-local copy: a random-sampling seed of 0 becomes a fresh one, logged for repeat runs. */
+    ScanConfig run_cfg = *cfg;
+    if (run_cfg.sample_mode == SAMPLE_RANDOM && run_cfg.sample_seed == 0)
+        run_cfg.sample_seed = mix64(now_us() ^ ((uint64_t)time(NULL) << 20)) | 1u;
+    if (resume && run_cfg.time_budget_min > 0) {
+        log_push("INFO", "Resume: the time budget is not carried over; the rest of the tree is read in full.");
+        run_cfg.time_budget_min = 0;
+    }
+    cfg = &run_cfg;
+    st->sample_seed = run_cfg.sample_mode == SAMPLE_RANDOM ? run_cfg.sample_seed : 0;
+    watchdog_start((uint32_t)cfg->stall_ms);
+    if (cfg->trace_mib > 0 && !trace_start((uint32_t)cfg->trace_mib))
+        log_pushf("WARN", "Trace: no memory for %d MiB; no trace this run.", cfg->trace_mib);
+
+    /* Everything the cleanup tail releases; an early exit jumps there with what it has. */
+    bool ok = false;
     ScanBuffers bufs;
-    if (!scan_buffers_init_default(&bufs)) {
+    memset(&bufs, 0, sizeof(bufs));
+    ChunkTuner tune;
+    tune_init(&tune);
+    Manifest mf_old;
+    ManifestBuilder mf_keep;
+    ManifestBuilder mf_self;
+    memset(&mf_old, 0, sizeof(mf_old));
+    memset(&mf_keep, 0, sizeof(mf_keep));
+    memset(&mf_self, 0, sizeof(mf_self));
+    RetryQueue retry;
+    memset(&retry, 0, sizeof(retry));
+    WalkCtx* walk = NULL;
+    ScanJournal* journal = NULL;
+    BudgetPlan budget;
+    BudgetPlan* plan = NULL;
+    ScanPool pool;
+    memset(&pool, 0, sizeof(pool));
+
+    int readers = cfg->reader_threads;
+    if (readers < 1) readers = 1;
+    if (readers > READERS_MAX) readers = READERS_MAX;
+    /* With a pool the UI thread does not read; it only needs the walker's arena. */
+    if (readers == 1 && !scan_buffers_init(&bufs, cfg)) {
         err_push(st, "Out of memory (scan buffers)");
-        return false;
+        goto cleanup;
+    }
+
+    const IoBackend* io = io_backend_select(cfg->io_backend);
+    snprintf(st->run_io_backend, sizeof(st->run_io_backend), "%s", io_backend_name(io));
+    log_pushf("INFO", "I/O backend: %s", io_backend_name(io));
+
+    ScanRun run = { cfg, st, pad, ui_update, &bufs, &tune, NULL, NULL, cfg->manifest ? &mf_self : NULL, &retry };
+    walk = (WalkCtx*)calloc(1, sizeof(*walk));
+    if (!walk) {
+        err_push(st, "Out of memory (walker)");
+        goto cleanup;
+    }
+    walk->io = io;
+    walk->cfg = cfg;
+    walk->root = root;
+    walk->arena = &bufs.dirs;
+    walk->run = &run;
+    if (resume) {
+        walk->resume = resume;
+        walk_counts_from_stats(&walk->counts, st);
+        walk->largest_count = st->largest_count;
+        for (int i = 0; i < st->largest_count; i++) walk->largest[i] = st->largest[i];
+        walk->slow_dirs = st->slow_dirs;
+    }
+
+    /* Manifest: the walker classifies files against it; readers record what they verify. */
+    st->manifest_on = cfg->manifest;
+    st->incremental_on = cfg->manifest && cfg->incremental;
+    if (cfg->manifest) {
+        uint64_t t0 = now_us();
+        if (manifest_load(&mf_old, MANIFEST_PATH)) {
+            walk->mf = &mf_old;
+            st->manifest_loaded = mf_old.count;
+        } else if (errno == ENOENT) {
+            log_push("INFO", "Manifest: none yet; every file is new.");
+        } else {
+            log_pushf("WARN", "Manifest: %s unreadable (%s); starting a new one.", MANIFEST_PATH, strerror(errno));
+        }
+        st->manifest_load_ms = (now_us() - t0) / 1000;
+        walk->mf_keep = &mf_keep;
+        if (cfg->stale_days > 0) walk->mf_stale_before = (int64_t)time(NULL) - (int64_t)cfg->stale_days * 86400;
+        log_pushf("INFO", "Manifest: %llu entries loaded in %llu ms; %s, stale after %d day(s)",
+                  (unsigned long long)st->manifest_loaded, (unsigned long long)st->manifest_load_ms,
+                  st->incremental_on ? "incremental" : "full scan", cfg->stale_days);
+    }
+
+    /* Resume journal: single reader checkpoints from its ui_update hook, a pool from pool_merge. */
+    if (cfg->checkpoint_sec > 0) {
+        journal = journal_create(root, cfg, resume, ui_update);
+        if (journal) {
+            st->journal = journal;
+            run.cursor = &journal->self;
+            run.ui_update = journal_ui_tick;
+        } else {
+            log_push("WARN", "Resume journal: out of memory; this scan cannot be resumed.");
+        }
+    }
+
+    if (cfg->time_budget_min > 0) {
+        plan = &budget;
+        plan_init(plan, cfg, readers, t_start);
+        st->budget_on = true;
+        plan_prepass(plan, root, cfg, io, &bufs.dirs, &run, walk->mf, walk->mf_stale_before);
+        if (st->cancelled) {
+            ok = true;
+            goto cleanup;
+        }
+        walk->plan = plan;
+        run.plan = plan;
+    }
+
+    /* Look-ahead: the walker runs on core 2 (UI on the default core, hashers on core 1).
+       A reader pool always needs the walker thread and at least one queued file per reader. */
+    int depth = cfg->lookahead_depth;
+    if (readers > 1 && depth < readers) depth = readers;
+    WorkQueue q;
+    WorkerThread walker;
+    bool threaded = false;
+    if (depth > 0 && work_queue_init(&q, depth)) {
+        walk->q = &q;
+        threaded = worker_start(&walker, walk_thread_main, walk, 2, 0x20000);
+        if (!threaded) {
+            walk->q = NULL;
+            work_queue_free(&q);
+            log_push("WARN", "Walker thread unavailable; scanning without look-ahead.");
+        }
+    }
+
+    int started = 0;
+    if (threaded && readers > 1) {
+        started = pool_start(&pool, cfg, &tune, plan, &q, readers, resume ? &resume->st : NULL, journal);
+        if (started < readers) log_pushf("WARN", "Reader pool: %d of %d threads started.", started, readers);
+    }
+    if (!threaded || started == 0) {
+        readers = 1;
+        if (!bufs.sample_buf && !scan_buffers_init(&bufs, cfg)) {
+            err_push(st, "Out of memory (scan buffers)");
+            if (threaded) {
+                atomic_store_explicit(&q.stop, true, memory_order_relaxed);
+                worker_join(&walker);
+                work_queue_free(&q);
+            }
+            goto cleanup;
+        }
+    } else {
+        readers = started;
+    }
+
+    st->run_lookahead = threaded ? depth : 0;
+    st->run_readers = readers;
+    log_pushf("INFO", "Look-ahead: %d, readers: %d", st->run_lookahead, st->run_readers);
+    if (!cfg->full_read) {
+        char budget[32];
+        if (cfg->sample_budget_mib > 0) snprintf(budget, sizeof(budget), "%d MiB", cfg->sample_budget_mib);
+        else snprintf(budget, sizeof(budget), "none");
+        log_pushf("INFO", "Sampling: %s, %d KiB regions, coverage %.2f%%, budget %s, seed %llu",
+                  sample_mode_name(cfg->sample_mode), cfg->sample_region_kib, cfg->sample_coverage_pct, budget,
+                  (unsigned long long)st->sample_seed);
+    }
+
+    if (journal && started == 0) journal_writer_start(journal);
+
+    /* Timeline: a pool samples in pool_run_ui, a single reader from its ui_update hook. */
+    ScanTimeline* timeline = timeline_create(cfg, st, run.ui_update);
+    if (timeline) {
+        st->timeline = timeline;
+        if (started == 0) run.ui_update = timeline_ui_tick;
+    } else if (cfg->timeline_sec > 0) {
+        log_push("WARN", "Timeline: out of memory; no timeline this run.");
     }
 
-    bool ok = scan_dir_recursive(root, root, 0, cfg, st, pad, ui_update, &bufs);
+    uint64_t t_run = now_us();
+    if (threaded) {
+        if (started > 0) pool_run_ui(&pool, st, pad, ui_update);
+        else scan_read_queued(&run, &q);
+        atomic_store_explicit(&q.stop, true, memory_order_relaxed);
+        worker_join(&walker);
+        work_queue_free(&q);   /* closes files opened ahead of a cancel */
+    } else {
+        scan_walk(walk);
+    }
+    /* Regions deferred by this thread (serial walk or single reader); pool readers drain their own. */
+    retry_drain(&run, &retry);
+    for (int i = 0; i < retry.count; i++) retry_report(st, &retry, i);
+    retry_queue_free(&retry);
+    t_run = now_us() - t_run;
+    timeline_export(st);
+    watchdog_stop(&st->stalls);
+    trace_export(st);
+
+    /* Cancelled: a last checkpoint (before the walker's look-ahead totals land in st); done: no resume. */
+    if (journal) {
+        bool threaded_writes = journal->threaded;
+        journal_writer_stop(journal);   /* before the discard: no checkpoint may land after it */
+        if (!st->cancelled) {
+            scan_resume_discard();
+        } else if (started > 0) {
+            pool.journal_force = true;
+            pool_merge(&pool, st);
+        } else {
+            journal_checkpoint_self(journal, st);
+        }
+        /* Written on the reading thread (no writer thread): the time its reads stood still. */
+        char where[64] = "";
+        if (started == 0 && !threaded_writes)
+            snprintf(where, sizeof(where), " on the reading thread (%.1f%% of its read time)",
+                     st->read_io_us ? 100.0 * (double)journal->write_us / (double)st->read_io_us : 0.0);
+        log_pushf("INFO", "Resume journal: %u checkpoint(s), %llu ms writing%s%s", journal->writes,
+                  (unsigned long long)(journal->write_us / 1000), where, journal->failed ? " (write failed)" : "");
+    }
 
+    /* Walker totals and largest files are final once the walk is over (also on cancel). */
+    walk_counts_apply(st, &walk->counts);
+    lat_merge_all(st->lat, walk->lat);
+    st->largest_count = walk->largest_count;
+    for (int i = 0; i < walk->largest_count; i++) st->largest[i] = walk->largest[i];
+    st->slow_dirs = walk->slow_dirs;
+    if (started == 0) {
+        st->worker_files[0] = st->files_read;
+        st->worker_bytes[0] = st->bytes_read;
+        st->worker_busy_us[0] = st->read_busy_us;
+    }
+
+    /*
+     * Manifest: the old entries plus what this run verified or carried over. A scan that went
+     * through its whole tree in one session also drops the entries under its root it neither
+     * verified nor carried over (deleted or changed files, read errors); sampled and budget-skipped
+     * files of unchanged size and mtime keep theirs.
+     */
+    if (cfg->manifest) {
+        ManifestBuilder* parts[READERS_MAX + 2];
+        int np = 0;
+        parts[np++] = &mf_keep;
+        parts[np++] = &mf_self;
+        for (int i = 0; i < pool.n; i++) parts[np++] = &pool.shards[i]->mf;
+        bool oom = false;
+        for (int i = 0; i < np; i++) {
+            st->manifest_recorded += parts[i]->count - parts[i]->carried;
+            if (parts[i]->oom) oom = true;
+        }
+        if (oom) log_push("WARN", "Manifest: out of memory while recording; some files are missing and count as new next time.");
+
+        bool prune = !st->cancelled && st->resumes == 0;
+        uint64_t t0 = now_us();
+        st->manifest_write_ok = manifest_write(MANIFEST_PATH, walk->mf, parts, np, prune ? root : NULL, &st->manifest_written);
+        st->manifest_write_ms = (now_us() - t0) / 1000;
+        if (st->manifest_write_ok) {
+            log_pushf("INFO", "Manifest: %llu entries written in %llu ms (%llu verified this run)",
+                      (unsigned long long)st->manifest_written, (unsigned long long)st->manifest_write_ms,
+                      (unsigned long long)st->manifest_recorded);
+        } else {
+            log_pushf("WARN", "Manifest: write to %s failed (%s)", MANIFEST_PATH, strerror(errno));
+        }
+        log_pushf("INFO", "Manifest: new %llu, changed %llu, stale %llu, unchanged %llu (%.1f MiB)%s",
+                  (unsigned long long)st->manifest_new, (unsigned long long)st->manifest_changed,
+                  (unsigned long long)st->manifest_stale, (unsigned long long)st->manifest_unchanged,
+                  (double)st->manifest_unchanged_bytes / 1048576.0, st->incremental_on ? ", not read" : "");
+        if (st->bitrot_files > 0)
+            log_pushf("ERROR", "Bit-rot: %llu of %llu file(s) checked against their recorded CRC changed (%.1f MiB)",
+                      (unsigned long long)st->bitrot_files, (unsigned long long)st->bitrot_checked,
+                      (double)st->bitrot_bytes / 1048576.0);
+        else
+            log_pushf("INFO", "Bit-rot: none (%llu file(s) checked against their recorded CRC)",
+                      (unsigned long long)st->bitrot_checked);
+    }
+    if (chunk_bytes_from_mode(cfg->chunk_mode) == 0) tune_snapshot(&tune, st);
+    if (plan) plan_publish(plan, st);
+
+    log_pushf("INFO", "Traversal: %llu stat() calls, %llu avoided (directory entry metadata)",
+              (unsigned long long)st->stats_performed, (unsigned long long)st->stats_avoided);
+    log_pushf("INFO", "Enumeration: %llu dirs, %llu entries in %llu ms; file reads %llu ms",
+              (unsigned long long)st->dir_enum_dirs, (unsigned long long)st->dir_enum_entries,
+              (unsigned long long)(st->dir_enum_us / 1000), (unsigned long long)(st->read_io_us / 1000));
+    if (threaded) {
+        log_pushf("INFO", "Look-ahead: reader waited %llu ms for the walker",
+                  (unsigned long long)(st->walk_wait_us / 1000));
+    }
+    if (st->ranged_files > 0)
+        log_pushf("INFO", "Range reads: %llu file(s), %d readers each", (unsigned long long)st->ranged_files, cfg->range_threads);
+    if (st->bad_files > 0)
+        log_pushf("ERROR", "Bad regions: %llu file(s), %llu extent(s), %llu KiB unreadable (%llu bisection reads, %.1f MiB)",
+                  (unsigned long long)st->bad_files, (unsigned long long)st->bad_extents,
+                  (unsigned long long)(st->bad_bytes / 1024), (unsigned long long)st->bisect_reads,
+                  (double)st->bisect_bytes / 1048576.0);
+    if (st->bisect_recovered > 0)
+        log_pushf("WARN", "Bisection: %llu KiB of failed spans read fine when confirmed block by block",
+                  (unsigned long long)(st->bisect_recovered / 1024));
+    if (st->read_timeouts > 0)
+        log_pushf("ERROR", "Read deadline: %llu read(s) given up after %d s, files skipped (%d still hanging)",
+                  (unsigned long long)st->read_timeouts, cfg->read_deadline_s, io_reads_hanging());
+    if (st->stalls.count > 0) {
+        const StallStats* sl = &st->stalls;
+        log_pushf("WARN", "Stalls: %llu operation(s) over %d ms, %llu ms in total, longest %llu ms (%s)",
+                  (unsigned long long)sl->count, cfg->stall_ms, (unsigned long long)sl->total_ms,
+                  (unsigned long long)sl->max_ms, op_kind_name(sl->max_kind));
+        log_pushf("WARN", "Stall durations: <1s %llu, 1-2s %llu, 2-5s %llu, 5-10s %llu, 10-30s %llu, >=30s %llu",
+                  (unsigned long long)sl->hist[0], (unsigned long long)sl->hist[1], (unsigned long long)sl->hist[2],
+                  (unsigned long long)sl->hist[3], (unsigned long long)sl->hist[4], (unsigned long long)sl->hist[5]);
+    }
+    for (int k = 0; k < OP_KIND_COUNT; k++) {
+        LatSummary l;
+        lat_summarize(&st->lat[k], &l);
+        if (!l.count) continue;
+        char mean[16], p[LAT_PCTS][16], mx[16];
+        lat_format(mean, sizeof(mean), l.mean_us);
+        for (int i = 0; i < LAT_PCTS; i++) lat_format(p[i], sizeof(p[i]), l.p_us[i]);
+        lat_format(mx, sizeof(mx), l.max_us);
+        log_pushf("INFO", "Latency %s: %llu op(s), mean %s, p50 %s, p90 %s, p99 %s, p99.9 %s, max %s", op_kind_name((OpKind)k),
+                  (unsigned long long)l.count, mean, p[0], p[1], p[2], p[3], mx);
+    }
+    uint64_t ph[PHASE_COUNT];
+    scan_phase_times(st, ph);
+    uint64_t wall_us = (scan_stats_elapsed_ms(st, now_ms()) + st->resume_prior_ms + st->paused_total_ms) * 1000;
+    for (int k = 0; k < PHASE_COUNT; k++) {
+        if (!ph[k]) continue;
+        log_pushf("INFO", "Phase %s: %.1f ms (%.1f%% of wall time)", scan_phase_name((ScanPhase)k), (double)ph[k] / 1000.0,
+                  wall_us ? 100.0 * (double)ph[k] / (double)wall_us : 0.0);
+    }
+    slow_log(st);
+    if (st->retry_deferred > 0)
+        log_pushf("INFO", "Deferred retries: %llu region(s), %llu read back, %llu failed (backoff %d ms, %d attempt(s))",
+                  (unsigned long long)st->retry_deferred, (unsigned long long)st->retry_recovered,
+                  (unsigned long long)(st->retry_deferred - st->retry_recovered), cfg->retry_backoff_ms, cfg->read_retries);
+    if (st->hash_bytes > 0) {
+        /* Hasher throughput next to the card's: the hasher is the bottleneck when readers wait on it. */
+        double hash_mib_s = st->hash_us ? ((double)st->hash_bytes / 1048576.0) / ((double)st->hash_us / 1e6) : 0.0;
+        double read_mib_s = st->read_io_us ? ((double)st->bytes_read / 1048576.0) / ((double)st->read_io_us / 1e6) : 0.0;
+        char algo[48] = "crc32";
+        if (cfg->hash_algo != HASH_CRC32)
+            snprintf(algo, sizeof(algo), "crc32 + %s (%s)", hash_algo_name(cfg->hash_algo), hash_kernel_name(cfg->hash_algo));
+        log_pushf("INFO", "Hash: %s, hasher %.0f MiB/s vs. card %.1f MiB/s; readers waited %llu ms on the hasher",
+                  algo, hash_mib_s, read_mib_s, (unsigned long long)(st->hash_wait_us / 1000));
+    }
+    if (st->budget_on) {
+        uint64_t kept = st->budget_full + st->budget_sampled;
+        log_pushf("INFO", "Time budget: %d min, %lld s left; files full %llu, sampled %llu, skipped %llu (%.1f MiB); %u re-plans",
+                  cfg->time_budget_min, (long long)(st->budget_left_ms / 1000),
+                  (unsigned long long)st->budget_full, (unsigned long long)st->budget_sampled,
+                  (unsigned long long)st->budget_skipped, (double)st->budget_skipped_bytes / 1048576.0, st->budget_solves);
+        log_pushf("INFO", "Time budget coverage per file read: mean %.1f%%, lowest %.2f%%; last share %.1f%%, %.1f%% of files kept",
+                  kept ? 100.0 * st->budget_share_sum / (double)kept : 100.0, kept ? st->budget_share_min * 100.0 : 100.0,
+                  st->budget_frac * 100.0, st->budget_keep * 100.0);
+    }
+    log_pushf("INFO", "Verified: %.1f MiB of %.1f MiB (%.2f%% of the tree's bytes)",
+              (double)st->bytes_read / 1048576.0, (double)st->bytes_total / 1048576.0,
+              st->bytes_total ? 100.0 * (double)st->bytes_read / (double)st->bytes_total : 100.0);
+    if (st->sample_files > 0) {
+        log_pushf("INFO", "Sampled: %llu files, %llu regions, %.1f MiB of %.1f MiB (%.3f%%)",
+                  (unsigned long long)st->sample_files, (unsigned long long)st->sample_regions,
+                  (double)st->sample_bytes / 1048576.0, (double)st->sample_span_bytes / 1048576.0,
+                  st->sample_span_bytes ? 100.0 * (double)st->sample_bytes / (double)st->sample_span_bytes : 0.0);
+    }
+    if (st->tune_chunk) {
+        log_pushf("INFO", "Chunk tuner: chose %u KiB after %u round(s)", (unsigned)(st->tune_chunk / 1024u), st->tune_rounds);
+        for (int i = 0; i < TUNE_SIZES; i++) {
+            if (st->tune_mib_s[i] <= 0.0) continue;
+            log_pushf("INFO", "Chunk probe: %5u KiB %8.2f MiB/s (%.1f MiB read)", (unsigned)(tune_size(i) / 1024u),
+                      st->tune_mib_s[i], (double)st->tune_bytes[i] / 1048576.0);
+        }
+    }
+    double run_s = (double)t_run / 1000000.0;
+    for (int i = 0; i < st->run_readers; i++) {
+        log_pushf("INFO", "Reader %d: %llu files, %.1f MiB, %.2f MiB/s, busy %.0f%%", i + 1,
+                  (unsigned long long)st->worker_files[i], (double)st->worker_bytes[i] / 1048576.0,
+                  run_s > 0.0 ? (double)st->worker_bytes[i] / 1048576.0 / run_s : 0.0,
+                  t_run ? 100.0 * (double)st->worker_busy_us[i] / (double)t_run : 0.0);
+    }
+    ok = true;
+
+cleanup:
+    /* After a finished run the watchdog and the trace are already stopped (no-ops then). */
+    watchdog_stop(NULL);
+    trace_stop(NULL, NULL);
+    if (journal) {
+        free(journal);
+        st->journal = NULL;
+    }
+    manifest_close(&mf_old);
+    manifest_builder_free(&mf_keep);
+    manifest_builder_free(&mf_self);
+    pool_free(&pool);
+    if (plan) plan_free(plan);
+    tune_free(&tune);
+    if (walk) free(walk->inline_item.path);
+    free(walk);
     scan_buffers_free(&bufs);
     return ok;
 }
+
+bool scan_engine_run(const char* root, const ScanConfig* cfg, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update) {
+    if (!root || !cfg || !st) return false;
+    /* A new scan replaces whatever was left to resume. */
+    if (cfg->checkpoint_sec > 0) scan_resume_discard();
+    return scan_exec(root, cfg, st, pad, ui_update, NULL);
+}
+
+bool scan_engine_resume(ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update) {
+    if (!st) return false;
+    ResumeImage* im = (ResumeImage*)malloc(sizeof(*im));
+    if (!im) {
+        err_push(st, "Out of memory (resume journal)");
+        return false;
+    }
+    if (!resume_load(im)) {
+        log_push("WARN", "Resume: no usable journal (missing, damaged or from another version).");
+        free(im);
+        return false;
+    }
+
+    /* The counters continue; the session state (clock, display, pause, cancel) stays the caller's. */
+    ScanStats ui = *st;
+    *st = im->st;
+    st->cancelled = false;
+    st->ui_active = ui.ui_active;
+    st->ui_drawn = ui.ui_drawn;
+    st->ui_start_ms = ui.ui_start_ms;
+    st->ui_last_ms = ui.ui_last_ms;
+    st->input_last_ms = ui.input_last_ms;
+    st->paused = ui.paused;
+    st->pause_start_ms = ui.pause_start_ms;
+    st->paused_total_ms = ui.paused_total_ms;
+    st->cancel_hold_start_ms = ui.cancel_hold_start_ms;
+    st->cancel_prompt_active = ui.cancel_prompt_active;
+    st->speed_last_ms = ui.speed_last_ms;
+    st->speed_mib_s = 0.0;
+    st->wall_start = ui.wall_start;
+    memcpy(st->wall_start_str, ui.wall_start_str, sizeof(st->wall_start_str));
+    st->run_full_read = ui.run_full_read;
+    st->run_large_limit = ui.run_large_limit;
+    st->run_retries = ui.run_retries;
+    st->run_consistency = ui.run_consistency;
+    st->run_skip_folders = ui.run_skip_folders;
+    st->run_skip_exts = ui.run_skip_exts;
+    st->run_chunk = ui.run_chunk;
+    memset(st->worker_files, 0, sizeof(st->worker_files));
+    memset(st->worker_bytes, 0, sizeof(st->worker_bytes));
+    memset(st->worker_busy_us, 0, sizeof(st->worker_busy_us));
+    st->current_path[0] = 0;
+    st->current_size = 0;
+    st->current_planned = 0;
+    st->current_done = 0;
+    st->current_sample = false;
+    st->current_seq_read = false;
+    st->current_crc_off = 0;
+    st->budget_on = false;
+    st->budget_planning = false;
+    st->journal = NULL;
+    st->timeline = NULL;
+    st->resumes++;
+    st->resume_prior_ms = im->elapsed_ms;
+
+    /* Restarted reads: the bytes they had counted are read again. */
+    for (uint32_t i = 0; i < im->nfiles; i++) {
+        const ResumeFile* rf = &im->files[i];
+        uint64_t u = rf->undo < st->bytes_read ? rf->undo : st->bytes_read;
+        st->bytes_read -= u;
+        if (rf->sample) st->sample_bytes -= u < st->sample_bytes ? u : st->sample_bytes;
+    }
+    st->speed_last_bytes = st->bytes_read;
+    im->st = *st;   /* a reader pool adds its shards to these counters */
+
+    log_pushf("INFO", "Resuming Deep Check of %s: %llu files, %.1f MiB done, %u file(s) in flight, %llu s so far",
+              im->root, (unsigned long long)st->files_read, (double)st->bytes_read / 1048576.0, im->nfiles,
+              (unsigned long long)(im->elapsed_ms / 1000));
+    bool ok = scan_exec(im->root, &im->cfg, st, pad, ui_update, im);
+    free(im);
+    return ok;
+}
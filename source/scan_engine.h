@@ -1,6 +1,10 @@
 #pragma once
 #include "app.h"
 #include "config.h"
+#include "slowest.h"
+#include "timeline.h"
+#include "trace.h"
+#include "watchdog.h"
 
 typedef struct {
     uint64_t dirs_total;
@@ -11,6 +15,9 @@ typedef struct {
     uint64_t open_errors;
     uint64_t read_errors;          /* persistent */
     uint64_t read_errors_transient;/* recovered by retry */
+    uint64_t read_timeouts;        /* reads given up at read_deadline_s (file skipped) */
+    uint64_t retry_deferred;       /* failed regions queued for a later retry */
+    uint64_t retry_recovered;      /* ... of which read back on a later attempt */
     uint64_t stat_errors;
     uint64_t path_errors;
     uint64_t consistency_errors;
@@ -18,6 +25,113 @@ typedef struct {
     uint64_t skipped_dirs;
     uint64_t skipped_files;
 
+    /* Traversal metadata: entries typed/sized from the directory read vs. stat() fallbacks */
+    uint64_t stats_avoided;
+    uint64_t stats_performed;
+
+    /* Directory enumeration (batched listing), timed apart from file reads */
+    uint64_t dir_enum_dirs;
+    uint64_t dir_enum_entries;
+    uint64_t dir_enum_us;
+    uint64_t read_io_us;
+    uint64_t walk_wait_us;         /* look-ahead: reader idle, waiting for the walker (mean per reader) */
+    uint64_t read_busy_us;         /* time spent reading files, all readers */
+    uint64_t ranged_files;         /* large files read as parallel ranges */
+    uint64_t hash_bytes;           /* full reads through the hasher (CRC-32 + content hash) */
+    uint64_t hash_us;              /* hasher busy time */
+    uint64_t hash_wait_us;         /* readers blocked on the hasher (ring full) */
+    uint64_t crc_us;               /* CRC passes outside the hasher (sampled regions, ranges) */
+    uint64_t verify_us;            /* consistency re-reads (their CRC counts in crc_us) */
+    uint64_t retry_sleep_us;       /* back-off before retried reads */
+    uint64_t ui_us;                /* running-screen redraws (set by the UI) */
+    uint64_t pad_us;               /* input polling (set by the UI) */
+
+    /* Sample mode: files sampled, regions read, region bytes, total size of the sampled files */
+    uint64_t sample_files;
+    uint64_t sample_regions;
+    uint64_t sample_bytes;
+    uint64_t sample_span_bytes;
+    uint64_t sample_seed;          /* random sampling: effective seed (0 = even spacing) */
+
+    /* Time budget (time_budget_min > 0). bytes_total is kept for every run: size of the files
+       found after filters, the base of the "verified" share. */
+    uint64_t bytes_total;
+    bool     budget_on;
+    bool     budget_planning;      /* metadata pre-pass running */
+    double   budget_frac;          /* share of each file read (1 = full) */
+    double   budget_keep;          /* share of files read at all */
+    int64_t  budget_left_ms;
+    uint32_t budget_solves;        /* times the policy was re-solved */
+    uint64_t budget_pre_files;
+    uint64_t budget_pre_bytes;
+    uint64_t budget_pre_ms;
+    uint64_t budget_full;          /* files by policy */
+    uint64_t budget_sampled;
+    uint64_t budget_skipped;
+    uint64_t budget_skipped_bytes;
+    double   budget_share_min;     /* per file read (full + sampled): planned bytes / size */
+    double   budget_share_sum;
+
+    /* Chunk auto-tuner (chunk_mode Auto); tune_chunk 0 = fixed chunk size */
+    uint32_t tune_chunk;           /* chosen chunk in bytes */
+    uint32_t tune_rounds;          /* completed probe rounds */
+    double   tune_mib_s[TUNE_SIZES];  /* 64 KiB << i: last probed MiB/s (0 = not probed) */
+    uint64_t tune_bytes[TUNE_SIZES];  /* bytes of timed full-length reads */
+
+    /* Per reader thread (index < run_readers) */
+    uint64_t worker_files[READERS_MAX];
+    uint64_t worker_bytes[READERS_MAX];
+    uint64_t worker_busy_us[READERS_MAX];
+
+    /* File manifest. Files found are classified against it by the walker; an incremental scan
+       skips the unchanged ones (counted in files_total, not in bytes_total). */
+    bool     manifest_on;
+    bool     incremental_on;
+    uint64_t manifest_loaded;      /* entries in the manifest at start */
+    uint64_t manifest_written;     /* entries written at the end */
+    uint64_t manifest_recorded;    /* files verified by this run and recorded */
+    uint64_t manifest_new;         /* not listed */
+    uint64_t manifest_changed;     /* size or mtime differs */
+    uint64_t manifest_stale;       /* unchanged, verified more than stale_days ago */
+    uint64_t manifest_unchanged;   /* unchanged and verified recently (incremental: not read) */
+    uint64_t manifest_unchanged_bytes;
+    uint64_t manifest_load_ms;
+    uint64_t manifest_write_ms;
+    bool     manifest_write_ok;
+
+    /* Bit-rot: files read in full whose size and mtime match the manifest, compared by CRC */
+    uint64_t bitrot_checked;
+    uint64_t bitrot_files;         /* CRC differs: content changed without a write */
+    uint64_t bitrot_bytes;
+    BitrotEntry bitrot[BITROT_MAX];
+    int      bitrot_count;         /* listed (the first BITROT_MAX) */
+
+    /* Bad regions: failed reads bisected down to bisect_min_kib, the rest of the file read on */
+    uint64_t bad_files;
+    uint64_t bad_extents;          /* adjacent unreadable blocks count as one extent */
+    uint64_t bad_bytes;
+    uint64_t bisect_reads;         /* reads spent localizing them */
+    uint64_t bisect_bytes;
+    uint64_t bisect_recovered;     /* bytes of blocks in failed spans that read when confirmed */
+    BadFileEntry bad[BADFILE_MAX];
+    int      bad_count;            /* listed (the first BADFILE_MAX) */
+
+    /* Resume journal */
+    uint32_t resumes;              /* times this scan was resumed */
+    uint64_t resume_prior_ms;      /* scan time of the sessions before the last resume */
+    struct ScanJournal* journal;   /* engine-owned while a run writes checkpoints */
+
+    /* Throughput timeline (timeline_sec), exported as CSV at the end */
+    struct ScanTimeline* timeline; /* engine-owned while a run samples it */
+    uint32_t timeline_samples;
+    uint32_t timeline_interval_s;  /* after doublings on long runs */
+    bool     timeline_write_ok;
+
+    /* Trace mode (trace_mib): Chrome trace JSON written at the end */
+    uint64_t trace_events;         /* 0: no trace this run */
+    uint64_t trace_dropped;        /* after the buffer filled */
+    bool     trace_write_ok;
+
     bool cancelled;
 
     /* UI */
@@ -46,6 +160,9 @@ typedef struct {
     uint64_t current_planned;
     uint64_t current_done;
     bool     current_sample;
+    bool     current_seq_read;     /* read front to back: a resume continues at current_done */
+    uint32_t current_crc;          /* ... or at current_crc_off, with the CRC-32 of the bytes before it */
+    uint64_t current_crc_off;      /* 0: no CRC to continue from */
 
     char err_ring[ERR_RING_MAX][256];
     int  err_ring_count;
@@ -54,6 +171,12 @@ typedef struct {
     LargestEntry largest[LARGEST_MAX];
     int largest_count;
 
+    /* Slowest files (by rate, files of SLOW_RATE_MIN_BYTES or more, and by time) and directories
+       (listing time per entry). A file's time leaves out screen updates and pauses. */
+    SlowList slow_rate;
+    SlowList slow_time;
+    SlowList slow_dirs;
+
     /* First failing paths (unique, truncated) */
     char fail_paths[FAIL_MAX][256];
     int fail_count;
@@ -69,6 +192,8 @@ typedef struct {
     uint64_t perf_longest_off;
     uint64_t perf_longest_bytes;
     char     perf_longest_path[256];
+    StallStats stalls;     /* stall watchdog: operations in flight past stall_ms */
+    LatHist  lat[OP_KIND_COUNT];   /* latency per operation kind (this thread's, merged at the end) */
 
     /* First failure context (first non-OK condition) */
     bool     first_fail_set;
@@ -87,6 +212,9 @@ typedef struct {
     bool run_skip_folders;
     bool run_skip_exts;
     ChunkMode run_chunk;
+    char run_io_backend[16];   /* effective backend, set by the engine */
+    int  run_lookahead;        /* effective look-ahead depth (0 = serial walk) */
+    int  run_readers;          /* reader threads that ran */
 } ScanStats;
 
 typedef void (*ScanUiUpdateFn)(ScanStats* st, PadState* pad, bool force);
@@ -94,8 +222,58 @@ typedef void (*ScanUiUpdateFn)(ScanStats* st, PadState* pad, bool force);
 /* Elapsed wall time excluding pauses (milliseconds). */
 uint64_t scan_stats_elapsed_ms(const ScanStats* st, uint64_t now_ms);
 
+/*
+ * Where a Deep Check spent its time. File-system phases are the totals of the latency histograms
+ * (read less the consistency re-reads); hash is the hasher plus the CRC passes outside it. Times
+ * are per thread, so with several readers, the walker or the hasher running they overlap and add
+ * up to more than the wall time.
+ */
+typedef enum {
+    PHASE_TRAVERSAL = 0,   /* directory opens and listings */
+    PHASE_STAT,
+    PHASE_OPEN,            /* opens and closes */
+    PHASE_READ,
+    PHASE_HASH,            /* CRC-32 and content hash */
+    PHASE_VERIFY,          /* consistency re-reads */
+    PHASE_RETRY_SLEEP,
+    PHASE_UI,
+    PHASE_PAD,
+    PHASE_PAUSE,
+    PHASE_COUNT
+} ScanPhase;
+
+const char* scan_phase_name(ScanPhase p);
+void scan_phase_times(const ScanStats* st, uint64_t us[PHASE_COUNT]);
+
 /*
  * Performs the deep traversal+read. UI/input handling remains in the caller via ui_update.
  * Returns true if traversal completed (even with errors). Returns false only on fatal setup failure.
  */
 bool scan_engine_run(const char* root, const ScanConfig* cfg, ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update);
+
+/*
+ * Resume journal. With checkpoint_sec > 0 a Deep Check saves its position (traversal cursor,
+ * files being read and their offsets, counters) to SCAN_RESUME_PATH every few seconds and when
+ * cancelled; the file is removed once a scan completes.
+ */
+#ifndef SCAN_RESUME_DIR
+#define SCAN_RESUME_DIR "sdmc:/switch"
+#endif
+#define SCAN_RESUME_PATH SCAN_RESUME_DIR "/sdcheck.resume"
+
+typedef struct {
+    char       root[256];
+    ScanConfig cfg;             /* settings of the interrupted run */
+    uint64_t   files_read;
+    uint64_t   bytes_read;
+    uint64_t   bytes_total;     /* in scope as far as the walk got */
+    uint64_t   elapsed_ms;      /* scan time so far, all sessions */
+    int64_t    saved_at;        /* time() of the last checkpoint */
+} ScanResumeInfo;
+
+/* True if a journal from this build exists and is intact. */
+bool scan_resume_peek(ScanResumeInfo* out);
+void scan_resume_discard(void);
+
+/* Continues the journaled scan with its own root and settings (st as for scan_engine_run). */
+bool scan_engine_resume(ScanStats* st, PadState* pad, ScanUiUpdateFn ui_update);
@@ -0,0 +1,255 @@
+#pragma once
+#include "scan_engine.h"
+#include "scan_io.h"
+#include "worker.h"
+#include "manifest.h"
+#include "hash.h"
+
+#include <stdatomic.h>
+
+/*
+ * What the scan engine's modules share: the reporting helpers, the read buffers, the work
+ * items and the per-reader run state of scan_engine.c. Not part of the engine's interface
+ * (scan_engine.h); only the engine's own sources include this.
+ */
+
+typedef struct ChunkTuner   ChunkTuner;     /* scan_engine.c */
+typedef struct BudgetPlan   BudgetPlan;     /* budget.h */
+typedef struct ResumeCursor ResumeCursor;   /* journal.h */
+typedef struct RetryQueue   RetryQueue;     /* retry.h */
+
+/* --------------------------------------------------------------------------
+   Reporting
+----------------------------------------------------------------------------*/
+/* Error ring only (a pool's UI thread copies readers' entries that were logged already). */
+void err_ring_put(ScanStats* st, const char* msg);
+/* Error ring and log. */
+void err_push(ScanStats* st, const char* msg);
+/* Adds path to the failing-paths list once. */
+void fail_push_unique(ScanStats* st, const char* path);
+/* The first failure of the run (later calls do nothing). */
+void first_fail_capture(ScanStats* st, const char* kind, const char* path, uint64_t off, uint64_t bytes, int err, const char* note);
+/* One timed read: throughput histogram, stalls and the longest read. */
+void perf_record(ScanStats* st, uint64_t bytes, uint64_t dt_us, uint64_t off, const char* path);
+/* A read given up at the deadline: the file is skipped. */
+void timeout_record(ScanStats* st, const char* path, uint64_t off, uint64_t len, const char* note);
+
+/* --------------------------------------------------------------------------
+   Tracked file-system operations
+----------------------------------------------------------------------------*/
+/* lat: the calling thread's histograms (ScanStats.lat or the walker's), or NULL. */
+bool op_open(const IoBackend* be, const char* path, IoFile* f, LatHist* lat);
+void op_close(IoFile* f, const char* path, LatHist* lat);
+/* Adds src's histograms to dst. */
+void lat_merge_all(LatHist* dst, const LatHist* src);
+
+/* --------------------------------------------------------------------------
+   Read pipeline
+----------------------------------------------------------------------------*/
+typedef struct {
+    uint8_t* buf;
+    size_t   cap;
+    size_t   len;
+    bool     first;    /* first data of the file: also yields the consistency CRC */
+} PipeSlot;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cv_filled;   /* reader -> hasher */
+    pthread_cond_t  cv_free;     /* hasher -> reader */
+
+    PipeSlot slots[PIPELINE_SLOTS_MAX];
+    int      nslots;
+    int      head;               /* next slot the reader fills */
+    int      tail;               /* next slot the hasher consumes */
+    int      filled;             /* published, not yet hashed */
+    bool     stop;
+
+    /* Per-file hash state; owned by the hasher while slots are in flight. */
+    uint32_t crc;
+    uint32_t first_crc;
+    bool     first_crc_set;
+    HashState hash;              /* content hash (hash.algo HASH_CRC32: none) */
+    uint64_t hash_us;            /* hasher busy time for this file */
+    uint64_t hash_bytes;
+    uint64_t published;          /* reader side: slots published for this file */
+    uint64_t wait_us;            /* reader side: blocked on a full ring (hasher behind) */
+    uint32_t done_crc;           /* crc as of done_off, under lock: where a resume can continue */
+    uint64_t done_off;
+
+    WorkerThread thread;
+    bool     threaded;           /* false: hash inline on the scan thread */
+} ReadPipe;
+
+/* --------------------------------------------------------------------------
+   Read deadline
+----------------------------------------------------------------------------*/
+typedef struct {
+    IoProxy*       proxy;
+    uint32_t       deadline_ms;
+    ScanStats*     st;          /* UI hook while waiting; NULL on range helpers */
+    ScanUiUpdateFn ui_update;
+    PadState*      pad;
+    LatHist*       lat;         /* read latencies of the owning thread */
+} ReadGuard;
+
+/* io_pread through the guard. On a timeout f is closed for good (f->be NULL) and *bufp replaced.
+   path: for the stall watchdog. */
+bool guarded_pread(ReadGuard* g, IoFile* f, const char* path, uint8_t** bufp, size_t cap, size_t len, uint64_t off, size_t* out_read);
+/* Right after guarded_pread: true when the read was given up and the handle went with it.
+   Records the timeout (a cancel while the read hung is not a finding). */
+bool read_abandoned(ScanStats* st, const IoFile* f, const char* path, uint64_t off, uint64_t len, const char* note);
+/* The UI hook a guarded read keeps going while it waits. */
+void guard_bind(ReadGuard* g, ScanStats* st, ScanUiUpdateFn ui_update, PadState* pad);
+
+/* --------------------------------------------------------------------------
+   Sampling (files above large_file_limit)
+----------------------------------------------------------------------------*/
+/*
+ * A sampled file is cut into 'count' equal strata that contribute one region each. The first
+ * region is the head and the last the tail, as before; the ones between are evenly spaced or
+ * sit at a random offset inside their stratum. Random offsets come from the run seed and the
+ * path, so a seed reproduces the same regions whichever reader gets the file. The count
+ * follows sample_coverage, is capped by sample_budget_mib, and is never below head + tail.
+ */
+typedef struct {
+    uint64_t   size;
+    size_t     region;
+    uint32_t   count;
+    SampleMode mode;
+    uint64_t   seed;
+} SamplePlan;
+
+/* splitmix64 finalizer */
+uint64_t mix64(uint64_t x);
+/* coverage_pct < 0: sample_coverage from the config. */
+void sample_plan(SamplePlan* p, uint64_t size, const ScanConfig* cfg, const char* path, double coverage_pct);
+uint64_t sample_planned_bytes(const SamplePlan* p);
+
+/* --------------------------------------------------------------------------
+   Buffer reuse
+----------------------------------------------------------------------------*/
+typedef struct {
+    uint8_t* sample_buf;
+    size_t sample_cap;
+    ReadPipe pipe;         /* full-read chunk ring */
+    IoDirArena dirs;       /* listings of the directories on the current path */
+    ReadGuard guard;       /* deadline reads of the thread that owns these buffers */
+} ScanBuffers;
+
+bool scan_buffers_init(ScanBuffers* b, const ScanConfig* cfg);
+void scan_buffers_free(ScanBuffers* b);
+
+/* --------------------------------------------------------------------------
+   Work items (walker -> readers)
+----------------------------------------------------------------------------*/
+typedef enum {
+    WORK_FILE = 0,   /* regular file to read (or that failed to open) */
+    WORK_FAIL,       /* directory, stat or path failure */
+    WORK_END         /* walk finished */
+} WorkKind;
+
+typedef struct {
+    uint64_t dirs_total;
+    uint64_t files_total;
+    uint64_t skipped_dirs;
+    uint64_t skipped_files;
+    uint64_t open_errors;
+    uint64_t stat_errors;
+    uint64_t path_errors;
+    uint64_t stats_avoided;
+    uint64_t stats_performed;
+    uint64_t dir_enum_dirs;
+    uint64_t dir_enum_entries;
+    uint64_t dir_enum_us;
+    uint64_t bytes_total;
+    uint64_t mf_new;
+    uint64_t mf_changed;
+    uint64_t mf_stale;
+    uint64_t mf_unchanged;
+    uint64_t mf_unchanged_bytes;
+} WalkCounts;
+
+typedef struct {
+    WorkKind   kind;
+    uint64_t   seq;             /* traversal order */
+    char*      path;            /* owned by the item, reused */
+    size_t     path_cap;
+    uint64_t   size;
+    bool       sample;
+    bool       opened;
+    IoFile     f;
+    bool       resumed;         /* in flight at the checkpoint: already counted */
+    uint64_t   resume_off;      /* ... and read front to back up to here */
+    uint32_t   resume_crc;      /* ... with this CRC-32 of the bytes before (mtime_ok: file unchanged since) */
+    bool       entered;         /* READ_DIR failure: the walk went on into the directory */
+    bool       mtime_ok;        /* manifest: mtime read */
+    int64_t    mtime;
+    const ManifestEntry* base;  /* manifest: same size and mtime (the loaded manifest outlives the items) */
+
+    bool       failed;          /* failure record (WORK_FAIL, or a WORK_FILE that did not open) */
+    bool       fail_listed;     /* also goes to the failing-paths list */
+    char       fail_kind[16];   /* empty: not a first-failure candidate */
+    char       fail_note[16];
+    int        fail_errno;
+    char       fail_msg[256];
+
+    WalkCounts counts;          /* walker totals as of this item */
+} WorkItem;
+
+/* Walker totals into the stats (they replace the stats' own). */
+void walk_counts_apply(ScanStats* st, const WalkCounts* c);
+
+/* --------------------------------------------------------------------------
+   Look-ahead queue (bounded, lock-free)
+----------------------------------------------------------------------------*/
+/*
+ * Bounded MPMC ring with a sequence number per cell (Vyukov). Cell i is free for position p
+ * when seq == p, holds the item of position p when seq == p + 1, and is released for
+ * p + cap by the reader that took it. The walker is the only producer; one or more readers
+ * claim positions with a CAS on 'tail' and copy the item out (swapping path buffers), so a
+ * cell is free again as soon as its file is taken. Full or empty rings are waited out with
+ * short sleeps; the UI thread keeps drawing meanwhile.
+ */
+typedef struct {
+    _Atomic uint64_t seq;
+    WorkItem         item;
+} WorkCell;
+
+typedef struct {
+    WorkCell*        cells;
+    uint32_t         cap;
+    _Atomic uint64_t head;       /* next position the walker fills */
+    _Atomic uint64_t tail;       /* next position a reader takes */
+    atomic_bool      stop;       /* readers -> walker: cancelled */
+} WorkQueue;
+
+/* Takes the next item into *out; the cell keeps out's previous path buffer. False if empty. */
+bool work_queue_pop(WorkQueue* q, WorkItem* out);
+/* Queue waits: yield for the first rounds (the other side is usually about to move), then
+   sleep from 20 us doubling up to 640 us. 'round' starts at 0 for each wait. */
+void queue_backoff(uint32_t* round);
+
+/* --------------------------------------------------------------------------
+   Reader side
+----------------------------------------------------------------------------*/
+typedef struct {
+    const ScanConfig* cfg;
+    ScanStats*        st;
+    PadState*         pad;
+    ScanUiUpdateFn    ui_update;
+    ScanBuffers*      bufs;
+    ChunkTuner*       tune;
+    BudgetPlan*       plan;       /* NULL: no time budget */
+    ResumeCursor*     cursor;     /* NULL: no resume journal */
+    ManifestBuilder*  mf;         /* NULL: no manifest; files verified in full are recorded here */
+    RetryQueue*       retry;      /* NULL: failed reads are retried in place */
+} ScanRun;
+
+/* A file read in full this session: compared with its manifest entry (bit-rot), then recorded. */
+void file_verified(ScanRun* run, const char* path, uint64_t fsize, int64_t mtime, const ManifestEntry* base,
+                   uint32_t crc, const HashDigest* digest);
+/* Applies one item to the stats and reads its file. Returns false if the scan was cancelled. */
+bool work_consume(ScanRun* run, WorkItem* it);
+/* Throughput timeline: called with the merged counters (UI thread). */
+void timeline_sample(ScanStats* st);
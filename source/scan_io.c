@@ -0,0 +1,661 @@
+#include "scan_io.h"
+#include "log.h"
+#include "util.h"
+#include "worker.h"
+#include "watchdog.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#if !defined(__SWITCH__) && defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+typedef struct {
+    union {
+        DIR*  dp;
+        int   fd;
+#ifdef __SWITCH__
+        FsDir nx;
+#endif
+    } h;
+} IoDir;
+
+struct IoBackend {
+    const char* name;
+    bool (*open)(const char* path, IoFile* f);
+    bool (*pread)(IoFile* f, void* buf, size_t len, uint64_t off, size_t* out_read);
+    void (*close)(IoFile* f);
+    bool (*stat)(const char* path, IoStat* out);
+    bool (*mtime)(const char* path, int64_t* out);
+    bool (*opendir)(const char* path, IoDir* d);
+    int  (*read_batch)(IoDir* d, IoDirArena* a);   /* entries appended, 0 at end, -1 + errno */
+    void (*closedir)(IoDir* d);
+};
+
+/* --------------------------------------------------------------------------
+   Listing arena
+----------------------------------------------------------------------------*/
+static bool is_dot_name(const char* n) {
+    return n[0] == '.' && (n[1] == 0 || (n[1] == '.' && n[2] == 0));
+}
+
+static bool arena_push(IoDirArena* a, const char* name, size_t len, IoEntryType type, bool has_size, uint64_t size) {
+    if (a->count == a->cap) {
+        size_t ncap = a->cap ? a->cap * 2 : 512;
+        IoDirEntry* ne = (IoDirEntry*)realloc(a->ents, ncap * sizeof(*ne));
+        if (!ne) { errno = ENOMEM; return false; }
+        a->ents = ne;
+        a->cap = ncap;
+    }
+    if (a->names_len + len + 1 > a->names_cap) {
+        size_t ncap = a->names_cap ? a->names_cap : 16384;
+        while (ncap < a->names_len + len + 1) ncap *= 2;
+        char* nn = (char*)realloc(a->names, ncap);
+        if (!nn) { errno = ENOMEM; return false; }
+        a->names = nn;
+        a->names_cap = ncap;
+    }
+
+    IoDirEntry* e = &a->ents[a->count++];
+    e->name_off = a->names_len;
+    e->type = type;
+    e->has_size = has_size;
+    e->size = size;
+    memcpy(a->names + a->names_len, name, len);
+    a->names[a->names_len + len] = 0;
+    a->names_len += len + 1;
+    return true;
+}
+
+static bool arena_batch(IoDirArena* a, size_t bytes) {
+    if (a->batch_cap >= bytes) return true;
+    void* nb = malloc(bytes);
+    if (!nb) { errno = ENOMEM; return false; }
+    free(a->batch);
+    a->batch = nb;
+    a->batch_cap = bytes;
+    return true;
+}
+
+void io_arena_truncate(IoDirArena* a, size_t count, size_t names_len) {
+    if (count < a->count) a->count = count;
+    if (names_len < a->names_len) a->names_len = names_len;
+}
+
+void io_arena_free(IoDirArena* a) {
+    free(a->ents);
+    free(a->names);
+    free(a->batch);
+    memset(a, 0, sizeof(*a));
+}
+
+/* --------------------------------------------------------------------------
+   Shared POSIX pieces (stdio and posix backends)
+----------------------------------------------------------------------------*/
+static bool px_stat(const char* path, IoStat* out) {
+    struct stat s;
+    if (stat(path, &s) != 0) return false;
+    out->is_dir = S_ISDIR(s.st_mode);
+    out->is_reg = S_ISREG(s.st_mode);
+    out->size = (uint64_t)s.st_size;
+    out->has_mtime = true;
+    out->mtime = (int64_t)s.st_mtime;
+    return true;
+}
+
+static bool px_mtime(const char* path, int64_t* out) {
+    struct stat s;
+    if (stat(path, &s) != 0) return false;
+    *out = (int64_t)s.st_mtime;
+    return true;
+}
+
+static bool px_opendir(const char* path, IoDir* d) {
+    d->h.dp = opendir(path);
+    return d->h.dp != NULL;
+}
+
+static IoEntryType px_dtype(const struct dirent* ent) {
+#ifdef DT_UNKNOWN
+    /* Symlinks stay UNKNOWN so the stat() fallback follows them like before. */
+    switch (ent->d_type) {
+        case DT_REG:     return IO_ENT_FILE;
+        case DT_DIR:     return IO_ENT_DIR;
+        case DT_UNKNOWN:
+        case DT_LNK:     return IO_ENT_UNKNOWN;
+        default:         return IO_ENT_OTHER;
+    }
+#else
+    (void)ent;
+    return IO_ENT_UNKNOWN;
+#endif
+}
+
+static int px_read_batch(IoDir* d, IoDirArena* a) {
+    int n = 0;
+    while (n < IO_DIR_BATCH) {
+        errno = 0;
+        struct dirent* ent = readdir(d->h.dp);
+        if (!ent) {
+            if (errno) return -1;
+            break;
+        }
+        if (is_dot_name(ent->d_name)) continue;
+        if (!arena_push(a, ent->d_name, strlen(ent->d_name), px_dtype(ent), false, 0)) return -1;
+        n++;
+    }
+    return n;
+}
+
+static void px_closedir(IoDir* d) {
+    if (d->h.dp) closedir(d->h.dp);
+    d->h.dp = NULL;
+}
+
+/* --------------------------------------------------------------------------
+   stdio backend
+----------------------------------------------------------------------------*/
+static bool stdio_open(const char* path, IoFile* f) {
+    f->h.fp = fopen(path, "rb");
+    f->pos = 0;
+    return f->h.fp != NULL;
+}
+
+static bool stdio_pread(IoFile* f, void* buf, size_t len, uint64_t off, size_t* out_read) {
+    *out_read = 0;
+    if (f->pos != off) {
+        if (fseeko(f->h.fp, (off_t)off, SEEK_SET) != 0) return false;
+        f->pos = off;
+    }
+
+    errno = 0;
+    size_t r = fread(buf, 1, len, f->h.fp);
+    *out_read = r;
+    f->pos += r;
+    if (ferror(f->h.fp)) {
+        int e = errno ? errno : EIO;
+        clearerr(f->h.fp);
+        f->pos = UINT64_MAX; /* stream position unknown: seek on the next read */
+        errno = e;
+        return false;
+    }
+    return true;
+}
+
+static void stdio_close(IoFile* f) {
+    if (f->h.fp) fclose(f->h.fp);
+    f->h.fp = NULL;
+}
+
+static const IoBackend g_io_stdio = {
+    "stdio", stdio_open, stdio_pread, stdio_close, px_stat, px_mtime, px_opendir, px_read_batch, px_closedir
+};
+
+/* --------------------------------------------------------------------------
+   posix backend (host)
+----------------------------------------------------------------------------*/
+#ifndef __SWITCH__
+static bool posix_open(const char* path, IoFile* f) {
+    f->h.fd = open(path, O_RDONLY);
+    f->pos = 0;
+    return f->h.fd >= 0;
+}
+
+static bool posix_pread(IoFile* f, void* buf, size_t len, uint64_t off, size_t* out_read) {
+    size_t done = 0;
+    *out_read = 0;
+    while (done < len) {
+        ssize_t r = pread(f->h.fd, (uint8_t*)buf + done, len - done, (off_t)(off + done));
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (r == 0) break;
+        done += (size_t)r;
+        *out_read = done;
+    }
+    return true;
+}
+
+static void posix_close(IoFile* f) {
+    if (f->h.fd >= 0) close(f->h.fd);
+    f->h.fd = -1;
+}
+
+#ifdef __linux__
+/* Directory listing straight from getdents64: one syscall fills a 64 KiB batch. */
+typedef struct {
+    uint64_t       d_ino;
+    int64_t        d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[];
+} LinuxDirent64;
+
+static bool gd_opendir(const char* path, IoDir* d) {
+    d->h.fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return d->h.fd >= 0;
+}
+
+static int gd_read_batch(IoDir* d, IoDirArena* a) {
+    const size_t cap = 64u * 1024u;
+    if (!arena_batch(a, cap)) return -1;
+
+    for (;;) {
+        long nread = syscall(SYS_getdents64, d->h.fd, a->batch, cap);
+        if (nread < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (nread == 0) return 0;
+
+        int n = 0;
+        for (long off = 0; off < nread;) {
+            const LinuxDirent64* e = (const LinuxDirent64*)((const char*)a->batch + off);
+            off += e->d_reclen;
+            if (is_dot_name(e->d_name)) continue;
+
+            IoEntryType t = IO_ENT_OTHER;
+            if (e->d_type == DT_REG) t = IO_ENT_FILE;
+            else if (e->d_type == DT_DIR) t = IO_ENT_DIR;
+            else if (e->d_type == DT_UNKNOWN || e->d_type == DT_LNK) t = IO_ENT_UNKNOWN;
+
+            if (!arena_push(a, e->d_name, strlen(e->d_name), t, false, 0)) return -1;
+            n++;
+        }
+        if (n > 0) return n;   /* a batch of only "." / "..": keep reading */
+    }
+}
+
+static void gd_closedir(IoDir* d) {
+    if (d->h.fd >= 0) close(d->h.fd);
+    d->h.fd = -1;
+}
+
+static const IoBackend g_io_posix = {
+    "posix", posix_open, posix_pread, posix_close, px_stat, px_mtime, gd_opendir, gd_read_batch, gd_closedir
+};
+#else
+static const IoBackend g_io_posix = {
+    "posix", posix_open, posix_pread, posix_close, px_stat, px_mtime, px_opendir, px_read_batch, px_closedir
+};
+#endif
+#endif
+
+/* --------------------------------------------------------------------------
+   native backend (libnx fs on the SD card)
+----------------------------------------------------------------------------*/
+#ifdef __SWITCH__
+static FsFileSystem* g_nx_fs = NULL;
+
+static int nx_errno(Result rc) {
+    if (R_MODULE(rc) == 2 && R_DESCRIPTION(rc) == 1) return ENOENT; /* fs: PathNotFound */
+    return EIO;
+}
+
+/* "sdmc:/a//b" -> "/a/b" */
+static bool nx_path(const char* in, char out[FS_MAX_PATH]) {
+    if (strncmp(in, "sdmc:", 5) != 0) { errno = EXDEV; return false; }
+    const char* p = in + 5;
+
+    size_t n = 0;
+    out[n++] = '/';
+    for (; *p; p++) {
+        if (*p == '/' && out[n - 1] == '/') continue;
+        if (n + 1 >= FS_MAX_PATH) { errno = ENAMETOOLONG; return false; }
+        out[n++] = *p;
+    }
+    out[n] = 0;
+    return true;
+}
+
+static bool nx_open(const char* path, IoFile* f) {
+    char p[FS_MAX_PATH];
+    if (!nx_path(path, p)) return false;
+    Result rc = fsFsOpenFile(g_nx_fs, p, FsOpenMode_Read, &f->h.nx);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+    f->pos = 0;
+    return true;
+}
+
+static bool nx_pread(IoFile* f, void* buf, size_t len, uint64_t off, size_t* out_read) {
+    size_t done = 0;
+    *out_read = 0;
+    while (done < len) {
+        u64 got = 0;
+        Result rc = fsFileRead(&f->h.nx, (s64)(off + done), (uint8_t*)buf + done, len - done, FsReadOption_None, &got);
+        if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+        if (got == 0) break;
+        done += (size_t)got;
+        *out_read = done;
+    }
+    return true;
+}
+
+static void nx_close(IoFile* f) {
+    fsFileClose(&f->h.nx);
+}
+
+static bool nx_stat(const char* path, IoStat* out) {
+    char p[FS_MAX_PATH];
+    if (!nx_path(path, p)) return false;
+
+    FsDirEntryType type;
+    Result rc = fsFsGetEntryType(g_nx_fs, p, &type);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+
+    out->is_dir = (type == FsDirEntryType_Dir);
+    out->is_reg = (type == FsDirEntryType_File);
+    out->has_mtime = false;
+    out->size = 0;
+    if (!out->is_reg) return true;
+
+    FsFile f;
+    rc = fsFsOpenFile(g_nx_fs, p, FsOpenMode_Read, &f);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+    s64 size = 0;
+    rc = fsFileGetSize(&f, &size);
+    fsFileClose(&f);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+    out->size = (uint64_t)size;
+    return true;
+}
+
+/* One metadata request per file; only made when the manifest needs it (see walk_file). */
+static bool nx_mtime(const char* path, int64_t* out) {
+    char p[FS_MAX_PATH];
+    if (!nx_path(path, p)) return false;
+    FsTimeStampRaw ts;
+    Result rc = fsFsGetFileTimeStampRaw(g_nx_fs, p, &ts);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+    if (!ts.is_valid) { errno = ENOTSUP; return false; }
+    *out = (int64_t)ts.modified;
+    return true;
+}
+
+static bool nx_opendir(const char* path, IoDir* d) {
+    char p[FS_MAX_PATH];
+    if (!nx_path(path, p)) return false;
+    Result rc = fsFsOpenDirectory(g_nx_fs, p, FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &d->h.nx);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return false; }
+    return true;
+}
+
+static int nx_read_batch(IoDir* d, IoDirArena* a) {
+    if (!arena_batch(a, IO_DIR_BATCH * sizeof(FsDirectoryEntry))) return -1;
+    FsDirectoryEntry* ents = (FsDirectoryEntry*)a->batch;
+
+    s64 total = 0;
+    Result rc = fsDirRead(&d->h.nx, &total, IO_DIR_BATCH, ents);
+    if (R_FAILED(rc)) { errno = nx_errno(rc); return -1; }
+
+    for (s64 i = 0; i < total; i++) {
+        const FsDirectoryEntry* e = &ents[i];
+        size_t len = strnlen(e->name, sizeof(e->name));
+        bool is_dir = (e->type == FsDirEntryType_Dir);
+        if (!arena_push(a, e->name, len, is_dir ? IO_ENT_DIR : IO_ENT_FILE, !is_dir, is_dir ? 0 : (uint64_t)e->file_size)) return -1;
+    }
+    return (int)total;
+}
+
+static void nx_closedir(IoDir* d) {
+    fsDirClose(&d->h.nx);
+}
+
+static const IoBackend g_io_native = {
+    "native", nx_open, nx_pread, nx_close, nx_stat, nx_mtime, nx_opendir, nx_read_batch, nx_closedir
+};
+#endif
+
+/* --------------------------------------------------------------------------
+   Selection and dispatch
+----------------------------------------------------------------------------*/
+const IoBackend* io_backend_select(IoBackendMode mode) {
+#ifdef __SWITCH__
+    if (mode == IO_BACKEND_AUTO || mode == IO_BACKEND_NATIVE || mode == IO_BACKEND_POSIX) {
+        if (!g_nx_fs) g_nx_fs = fsdevGetDeviceFileSystem("sdmc");
+        if (g_nx_fs) return &g_io_native;   /* else: sdmc not mounted through fsdev */
+    }
+    return &g_io_stdio;
+#else
+    if (mode == IO_BACKEND_STDIO) return &g_io_stdio;
+    return &g_io_posix;
+#endif
+}
+
+const char* io_backend_name(const IoBackend* be) {
+    return be ? be->name : "none";
+}
+
+bool io_open(const IoBackend* be, const char* path, IoFile* f) {
+    memset(f, 0, sizeof(*f));
+    f->be = be;
+    return be->open(path, f);
+}
+
+bool io_pread(IoFile* f, void* buf, size_t len, uint64_t off, size_t* out_read) {
+    return f->be->pread(f, buf, len, off, out_read);
+}
+
+void io_close(IoFile* f) {
+    if (f->be) f->be->close(f);
+    f->be = NULL;
+}
+
+bool io_stat(const IoBackend* be, const char* path, IoStat* out) {
+    memset(out, 0, sizeof(*out));
+    return be->stat(path, out);
+}
+
+bool io_mtime(const IoBackend* be, const char* path, int64_t* out) {
+    *out = 0;
+    return be->mtime(path, out);
+}
+
+bool io_list_dir(const IoBackend* be, const char* path, IoDirArena* a, size_t* out_first, size_t* out_count, int* out_read_errno,
+                 LatHist* lat) {
+    *out_first = a->count;
+    *out_count = 0;
+    *out_read_errno = 0;
+
+    IoDir d;
+    memset(&d, 0, sizeof(d));
+    OpScope o;
+    op_enter(&o, OP_OPENDIR, path, 0, 0);
+    bool opened = be->opendir(path, &d);
+    op_leave(&o, lat);
+    if (!opened) return false;
+
+    for (;;) {
+        op_enter(&o, OP_READDIR, path, 0, 0);
+        int n = be->read_batch(&d, a);
+        op_leave(&o, lat);
+        if (n < 0) { *out_read_errno = errno ? errno : EIO; break; }
+        if (n == 0) break;
+    }
+    be->closedir(&d);
+
+    *out_count = a->count - *out_first;
+    return true;
+}
+
+void* io_buf_alloc(size_t size) {
+    size_t n = (size + IO_BUF_ALIGN - 1) & ~(size_t)(IO_BUF_ALIGN - 1);
+    if (n == 0) n = IO_BUF_ALIGN;
+    return aligned_alloc(IO_BUF_ALIGN, n);
+}
+
+/* --------------------------------------------------------------------------
+   Deadline reads
+----------------------------------------------------------------------------*/
+#define IO_HANGING_MAX 8     /* reads left blocked before deadlines are given up on */
+
+/*
+ * One proxy thread and its request slot. A core whose read was given up belongs to its
+ * thread from then on; it is not freed (libnx touches the Thread object after the entry
+ * function returns), only the handle and buffer are released.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cv;
+    WorkerThread    thread;
+    IoFile          f;          /* copy of the caller's handle for the current read */
+    void*           buf;
+    size_t          len;
+    uint64_t        off;
+    size_t          done;
+    bool            ok;
+    int             err;
+    bool            pending;    /* posted, not served yet */
+    bool            quit;
+    bool            orphan;     /* given up */
+} IoProxyCore;
+
+struct IoProxy {
+    IoProxyCore* core;
+    bool         direct_logged;
+};
+
+static atomic_int g_io_hanging;
+
+static void proxy_main(void* arg) {
+    IoProxyCore* c = (IoProxyCore*)arg;
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        while (!c->pending && !c->quit) pthread_cond_wait(&c->cv, &c->lock);
+        if (c->quit) break;
+        pthread_mutex_unlock(&c->lock);
+
+        size_t r = 0;
+        bool ok = io_pread(&c->f, c->buf, c->len, c->off, &r);
+        int e = errno;
+
+        pthread_mutex_lock(&c->lock);
+        c->ok = ok;
+        c->done = r;
+        c->err = e;
+        c->pending = false;
+        if (c->orphan) break;
+        pthread_cond_broadcast(&c->cv);
+    }
+    bool orphan = c->orphan;
+    pthread_mutex_unlock(&c->lock);
+
+    if (orphan) {
+        io_close(&c->f);
+        free(c->buf);
+        c->buf = NULL;
+        atomic_fetch_sub_explicit(&g_io_hanging, 1, memory_order_relaxed);
+    }
+}
+
+static IoProxyCore* proxy_core_new(void) {
+    IoProxyCore* c = (IoProxyCore*)calloc(1, sizeof(*c));
+    if (!c) return NULL;
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cv, NULL);
+    if (!worker_start(&c->thread, proxy_main, c, WORKER_CORE_DEFAULT, 0x10000)) {
+        pthread_cond_destroy(&c->cv);
+        pthread_mutex_destroy(&c->lock);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+static void proxy_core_free(IoProxyCore* c) {
+    pthread_mutex_lock(&c->lock);
+    c->quit = true;
+    pthread_cond_broadcast(&c->cv);
+    pthread_mutex_unlock(&c->lock);
+    worker_join(&c->thread);
+    pthread_cond_destroy(&c->cv);
+    pthread_mutex_destroy(&c->lock);
+    free(c);
+}
+
+IoProxy* io_proxy_new(void) {
+    return (IoProxy*)calloc(1, sizeof(IoProxy));
+}
+
+void io_proxy_free(IoProxy* p) {
+    if (!p) return;
+    if (p->core) proxy_core_free(p->core);
+    free(p);
+}
+
+int io_reads_hanging(void) {
+    return atomic_load_explicit(&g_io_hanging, memory_order_relaxed);
+}
+
+bool io_pread_deadline(IoProxy* p, IoFile* f, uint8_t** bufp, size_t buf_cap, size_t len, uint64_t off, size_t* out_read,
+                       uint32_t deadline_ms, IoWaitFn tick, void* tick_arg) {
+    if (!p || deadline_ms == 0) return io_pread(f, *bufp, len, off, out_read);
+    if (atomic_load_explicit(&g_io_hanging, memory_order_relaxed) >= IO_HANGING_MAX) {
+        if (!p->direct_logged) {
+            p->direct_logged = true;
+            log_pushf("WARN", "%d reads are still hanging; further reads have no deadline.", IO_HANGING_MAX);
+        }
+        return io_pread(f, *bufp, len, off, out_read);
+    }
+    if (!p->core) p->core = proxy_core_new();
+    if (!p->core) return io_pread(f, *bufp, len, off, out_read);
+
+    IoProxyCore* c = p->core;
+    pthread_mutex_lock(&c->lock);
+    c->f = *f;
+    c->buf = *bufp;
+    c->len = len;
+    c->off = off;
+    c->pending = true;
+    pthread_cond_broadcast(&c->cv);
+
+    uint64_t t0 = now_ms();
+    int why = 0;
+    while (c->pending) {
+        uint64_t el = now_ms() - t0;
+        if (el >= deadline_ms) {
+            why = ETIMEDOUT;
+            break;
+        }
+        uint64_t slice = deadline_ms - el;
+        if (slice > 100) slice = 100;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t ns = (uint64_t)ts.tv_nsec + slice * 1000000ull;
+        ts.tv_sec += (time_t)(ns / 1000000000ull);
+        ts.tv_nsec = (long)(ns % 1000000000ull);
+        pthread_cond_timedwait(&c->cv, &c->lock, &ts);
+        if (c->pending && tick) {
+            pthread_mutex_unlock(&c->lock);
+            bool stop = tick(tick_arg);
+            pthread_mutex_lock(&c->lock);
+            if (stop && c->pending) {
+                why = ECANCELED;
+                break;
+            }
+        }
+    }
+
+    if (!why) {
+        *f = c->f;   /* stdio: stream position */
+        *out_read = c->done;
+        bool ok = c->ok;
+        int e = c->err;
+        pthread_mutex_unlock(&c->lock);
+        if (!ok) errno = e;
+        return ok;
+    }
+
+    /* Given up: the handle and buffer go with the blocked thread. */
+    c->orphan = true;
+    worker_detach(&c->thread);
+    atomic_fetch_add_explicit(&g_io_hanging, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&c->lock);
+    p->core = NULL;
+    memset(f, 0, sizeof(*f));
+    *bufp = (uint8_t*)io_buf_alloc(buf_cap);
+    *out_read = 0;
+    errno = why;
+    return false;
+}
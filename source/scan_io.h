@@ -0,0 +1,121 @@
+#pragma once
+#include "app.h"
+#include "config.h"
+#include "latency.h"
+
+/*
+ * I/O backends for the Deep Check engine.
+ *   stdio  - fopen/fread/readdir through newlib (FILE buffering, original behavior)
+ *   native - libnx fsFile/fsDir on the SD filesystem; reads land directly in the caller's buffer
+ *   posix  - open/pread/readdir (host builds)
+ * Errors follow the libc convention: false + errno.
+ */
+typedef struct IoBackend IoBackend;
+
+typedef struct {
+    const IoBackend* be;
+    union {
+        FILE*  fp;
+        int    fd;
+#ifdef __SWITCH__
+        FsFile nx;
+#endif
+    } h;
+    uint64_t pos;       /* stdio: stream position (skips redundant seeks) */
+} IoFile;
+
+typedef struct {
+    bool     is_dir;
+    bool     is_reg;
+    bool     has_mtime;  /* the backend's stat gave it (POSIX): no io_mtime() needed */
+    uint64_t size;
+    int64_t  mtime;
+} IoStat;
+
+typedef enum {
+    IO_ENT_UNKNOWN = 0,  /* backend/filesystem did not say: stat() the path */
+    IO_ENT_FILE,
+    IO_ENT_DIR,
+    IO_ENT_OTHER         /* neither (device, socket, ...) */
+} IoEntryType;
+
+typedef struct {
+    size_t      name_off;   /* into IoDirArena.names (NUL-terminated) */
+    IoEntryType type;
+    bool        has_size;
+    uint64_t    size;       /* files, when has_size */
+} IoDirEntry;
+
+/*
+ * Growable store for directory listings, used as a stack: a listing is appended on top,
+ * processed from memory, then dropped with io_arena_truncate(). Nothing is freed between
+ * directories, so enumeration does not allocate once the arena has grown.
+ */
+typedef struct {
+    IoDirEntry* ents;
+    size_t      count;
+    size_t      cap;
+    char*       names;
+    size_t      names_len;
+    size_t      names_cap;
+    void*       batch;      /* backend scratch for one batch read */
+    size_t      batch_cap;
+} IoDirArena;
+
+#define IO_DIR_BATCH 256    /* entries per fsDirRead / readdir batch */
+
+/* Read buffers are allocated with this alignment (page size; no bounce copies in fsFileRead). */
+#define IO_BUF_ALIGN 0x1000u
+
+/* Resolves AUTO and modes this build/device does not support. Never returns NULL. */
+const IoBackend* io_backend_select(IoBackendMode mode);
+const char* io_backend_name(const IoBackend* be);
+
+bool io_open(const IoBackend* be, const char* path, IoFile* f);
+/* Reads up to len bytes at off (short only at EOF). On error *out_read holds the bytes read before it. */
+bool io_pread(IoFile* f, void* buf, size_t len, uint64_t off, size_t* out_read);
+void io_close(IoFile* f);
+
+bool io_stat(const IoBackend* be, const char* path, IoStat* out);
+/* Modification time in seconds (manifest), when io_stat() did not give it. */
+bool io_mtime(const IoBackend* be, const char* path, int64_t* out);
+
+/*
+ * Lists a whole directory onto the arena ("." and ".." are never included): entries
+ * [*out_first, *out_first + *out_count). Returns false if the directory cannot be opened.
+ * A read error part-way keeps the entries read so far and sets *out_read_errno.
+ * The open and each batch read are tracked by the stall watchdog and timed into lat (may be NULL).
+ */
+bool io_list_dir(const IoBackend* be, const char* path, IoDirArena* a, size_t* out_first, size_t* out_count, int* out_read_errno,
+                 LatHist* lat);
+
+static inline const char* io_arena_name(const IoDirArena* a, const IoDirEntry* e) {
+    return a->names + e->name_off;
+}
+
+void io_arena_truncate(IoDirArena* a, size_t count, size_t names_len);
+void io_arena_free(IoDirArena* a);
+
+/* Aligned read buffer (size rounded up to IO_BUF_ALIGN); release with free(). */
+void* io_buf_alloc(size_t size);
+
+/*
+ * Reads with a deadline. A card that hangs blocks fsFileRead/fread with no way to interrupt
+ * it, so the read is handed to the proxy's thread and the caller waits at most deadline_ms,
+ * calling tick (if set) about every 100 ms; tick returning true gives the read up early.
+ * Given up, the call returns false with errno ETIMEDOUT (ECANCELED from tick) and the read is
+ * left to finish on its own: the blocked thread keeps f's handle and *bufp and releases them
+ * if the read ever returns. f is cleared (io_close is a no-op) and *bufp is replaced with a
+ * fresh buffer of buf_cap bytes (NULL if that fails); the proxy starts a new thread for the
+ * next read. Without a proxy, with deadline_ms 0 or with too many reads left hanging, the
+ * read is issued directly.
+ */
+typedef struct IoProxy IoProxy;
+typedef bool (*IoWaitFn)(void* arg);
+
+IoProxy* io_proxy_new(void);
+void io_proxy_free(IoProxy* p);
+bool io_pread_deadline(IoProxy* p, IoFile* f, uint8_t** bufp, size_t buf_cap, size_t len, uint64_t off, size_t* out_read,
+                       uint32_t deadline_ms, IoWaitFn tick, void* tick_arg);
+/* Reads given up and still blocked. */
+int io_reads_hanging(void);
@@ -0,0 +1,59 @@
+#include "slowest.h"
+
+static void slow_swap(SlowEntry* a, SlowEntry* b) {
+    SlowEntry t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void slow_sift_down(SlowList* l, int i) {
+    for (;;) {
+        int m = i, a = 2 * i + 1, b = a + 1;
+        if (a < l->count && l->e[a].key < l->e[m].key) m = a;
+        if (b < l->count && l->e[b].key < l->e[m].key) m = b;
+        if (m == i) return;
+        slow_swap(&l->e[i], &l->e[m]);
+        i = m;
+    }
+}
+
+static void slow_put(SlowList* l, const SlowEntry* x) {
+    if (l->count < SLOW_MAX) {
+        int i = l->count++;
+        l->e[i] = *x;
+        while (i > 0 && l->e[(i - 1) / 2].key > l->e[i].key) {
+            slow_swap(&l->e[(i - 1) / 2], &l->e[i]);
+            i = (i - 1) / 2;
+        }
+        return;
+    }
+    if (x->key <= l->e[0].key) return;
+    l->e[0] = *x;
+    slow_sift_down(l, 0);
+}
+
+void slow_add(SlowList* l, uint64_t key, uint64_t us, uint64_t n, const char* path) {
+    if (!path || !path[0] || !slow_ranks(l, key)) return;
+    SlowEntry x;
+    x.key = key;
+    x.us = us;
+    x.n = n;
+    snprintf(x.path, sizeof(x.path), "%.250s", path);
+    slow_put(l, &x);
+}
+
+void slow_merge(SlowList* dst, const SlowList* src) {
+    for (int i = 0; i < src->count; i++) slow_put(dst, &src->e[i]);
+}
+
+int slow_sorted(const SlowList* l, SlowEntry out[SLOW_MAX]) {
+    SlowList h = *l;
+    int n = h.count;
+    /* Heap sort: the root is the least slow, so it goes to the back. */
+    for (int i = n - 1; i >= 0; i--) {
+        out[i] = h.e[0];
+        h.e[0] = h.e[--h.count];
+        slow_sift_down(&h, 0);
+    }
+    return n;
+}
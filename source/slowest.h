@@ -0,0 +1,45 @@
+#pragma once
+#include "app.h"
+
+/*
+ * The N slowest files and directories of a Deep Check, to tell a card that is slow everywhere
+ * from one that is slow in one part of the tree. Each list is a min-heap on a slowness key with
+ * the least slow entry at the root: a candidate is compared with that one value and, when it
+ * ranks, replaces it in O(log N) (the path is copied only then). Sorted once for display.
+ */
+#define SLOW_MAX            5     /* per list: the summary page and the log show them all */
+#define SLOW_RATE_MIN_BYTES (1024 * 1024)   /* smaller files rank by time only: their rate is latency */
+
+typedef struct {
+    uint64_t key;          /* larger is slower */
+    uint64_t us;
+    uint64_t n;            /* files: bytes read; directories: entries */
+    char     path[256];
+} SlowEntry;
+
+typedef struct {
+    SlowEntry e[SLOW_MAX];
+    int       count;
+} SlowList;
+
+/* True when an entry with this key would be kept (checked before building its path). */
+static inline bool slow_ranks(const SlowList* l, uint64_t key) {
+    return l->count < SLOW_MAX || key > l->e[0].key;
+}
+
+void slow_add(SlowList* l, uint64_t key, uint64_t us, uint64_t n, const char* path);
+void slow_merge(SlowList* dst, const SlowList* src);
+/* Slowest first into out; returns the count. */
+int slow_sorted(const SlowList* l, SlowEntry out[SLOW_MAX]);
+
+/* Keys: time per MiB for a file's rate, time per entry for a directory listing. */
+static inline uint64_t slow_rate_key(uint64_t us, uint64_t bytes) {
+    return bytes ? us * 1048576ull / bytes : 0;
+}
+static inline uint64_t slow_dir_key(uint64_t us, uint64_t entries) {
+    return us / (entries ? entries : 1);
+}
+/* MiB/s of a file entry. */
+static inline double slow_mib_s(const SlowEntry* e) {
+    return e->us ? ((double)e->n / 1048576.0) / ((double)e->us / 1e6) : 0.0;
+}
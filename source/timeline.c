@@ -0,0 +1,104 @@
+#include "timeline.h"
+
+static uint32_t sat32(uint64_t v) {
+    return v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+bool timeline_init(Timeline* tl, int interval_s, const TimelineCounters* c, uint64_t now) {
+    memset(tl, 0, sizeof(*tl));
+    if (interval_s <= 0) return false;
+    tl->s = (TimelineSample*)calloc(TIMELINE_MAX, sizeof(TimelineSample));
+    if (!tl->s) return false;
+    tl->interval_ms = (uint32_t)interval_s * 1000u;
+    tl->t0_ms = now;
+    tl->last_ms = now;
+    tl->last = *c;
+    return true;
+}
+
+void timeline_free(Timeline* tl) {
+    free(tl->s);
+    memset(tl, 0, sizeof(*tl));
+}
+
+/* Full buffer: pairs of samples become one at twice the interval (TIMELINE_MAX is even, so the
+   open interval still starts on a boundary). */
+static void timeline_coarsen(Timeline* tl) {
+    uint32_t n = tl->count / 2;
+    for (uint32_t i = 0; i < n; i++) {
+        const TimelineSample* a = &tl->s[2 * i];
+        const TimelineSample* b = &tl->s[2 * i + 1];
+        TimelineSample m;
+        m.bytes = a->bytes + b->bytes;
+        m.reads = sat32((uint64_t)a->reads + b->reads);
+        m.files = sat32((uint64_t)a->files + b->files);
+        m.errors = sat32((uint64_t)a->errors + b->errors);
+        m.stalls = sat32((uint64_t)a->stalls + b->stalls);
+        m.stalled = a->stalled > b->stalled ? a->stalled : b->stalled;
+        m.paused = b->paused;
+        tl->s[i] = m;
+    }
+    tl->count = n;
+    tl->interval_ms *= 2;
+    tl->merges++;
+}
+
+static void timeline_put(Timeline* tl, const TimelineCounters* c, bool with_delta, bool noted) {
+    if (tl->count == TIMELINE_MAX) timeline_coarsen(tl);
+    TimelineSample* x = &tl->s[tl->count++];
+    memset(x, 0, sizeof(*x));
+    x->stalled = (uint16_t)(c->stalled > UINT16_MAX ? UINT16_MAX : c->stalled);
+    x->paused = c->paused;
+    if (!with_delta) return;
+    TimelineCounters to = *c;
+    if (noted) {
+        to = tl->seen;
+        to.stalls = tl->last.stalls;
+    }
+    x->bytes = to.bytes - tl->last.bytes;
+    x->reads = sat32(to.reads - tl->last.reads);
+    x->files = sat32(to.files - tl->last.files);
+    x->errors = sat32(to.errors - tl->last.errors);
+    x->stalls = sat32(to.stalls - tl->last.stalls);
+    tl->last = to;
+}
+
+void timeline_tick(Timeline* tl, const TimelineCounters* c, uint64_t now) {
+    while (timeline_due(tl, now)) {
+        /* The first interval gets what was noted in it, the one that ends last the rest of the growth. */
+        bool last = now - tl->last_ms < 2ull * tl->interval_ms;
+        uint32_t len = tl->interval_ms;
+        timeline_put(tl, c, last || tl->seen_set, !last && tl->seen_set);
+        tl->seen_set = false;
+        tl->last_ms += len;
+    }
+}
+
+void timeline_finish(Timeline* tl, const TimelineCounters* c, uint64_t now) {
+    if (!tl->s) return;
+    timeline_tick(tl, c, now);
+    if (now > tl->last_ms) {
+        tl->tail_ms = (uint32_t)(now - tl->last_ms);
+        timeline_put(tl, c, true, false);
+        tl->last_ms = now;
+    }
+}
+
+bool timeline_write_csv(const Timeline* tl, const char* path) {
+    if (!tl->s) return false;
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "t_s,dur_s,bytes,mib_s,reads,files,errors,stalls,stalled,paused\n");
+    for (uint32_t i = 0; i < tl->count; i++) {
+        const TimelineSample* x = &tl->s[i];
+        uint32_t dur = (i + 1 == tl->count && tl->tail_ms) ? tl->tail_ms : tl->interval_ms;
+        double secs = (double)dur / 1000.0;
+        fprintf(f, "%llu,%.3f,%llu,%.2f,%u,%u,%u,%u,%u,%u\n",
+                (unsigned long long)((uint64_t)i * tl->interval_ms / 1000u), secs, (unsigned long long)x->bytes,
+                (double)x->bytes / 1048576.0 / secs, x->reads, x->files, x->errors, x->stalls, (unsigned)x->stalled,
+                (unsigned)x->paused);
+    }
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
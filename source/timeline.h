@@ -0,0 +1,74 @@
+#pragma once
+#include "app.h"
+
+/*
+ * Throughput timeline of a Deep Check: bytes read, reads, files, errors and stalls per fixed
+ * interval (timeline_sec, default 1 s), so thermal throttling, an exhausted SLC cache or periodic
+ * controller hiccups show over a long scan where the end-of-run averages hide them. Samples go into
+ * a buffer allocated at the start; when it is full, neighbouring samples are merged and the
+ * interval doubles, so the whole run stays covered in fixed memory. Exported as CSV at the end.
+ *
+ * Single writer: the thread that draws the UI samples the merged counters. Between samples it
+ * notes them, so work is put in the interval it was last seen in; work done while that thread was
+ * blocked lands in the interval in which it completed (the ones before it read as zero).
+ */
+#ifndef TIMELINE_DIR
+#define TIMELINE_DIR "sdmc:"
+#endif
+#define TIMELINE_PATH TIMELINE_DIR "/sdcheck_timeline.csv"
+
+#define TIMELINE_MAX 8192   /* samples: 2.3 h at 1 s before the interval doubles */
+
+/* Running totals at one point in time; the timeline stores their differences. */
+typedef struct {
+    uint64_t bytes;
+    uint64_t reads;
+    uint64_t files;
+    uint64_t errors;
+    uint64_t stalls;      /* flagged operations that completed */
+    uint32_t stalled;     /* flagged operations in flight */
+    bool     paused;
+} TimelineCounters;
+
+typedef struct {
+    uint64_t bytes;
+    uint32_t reads;
+    uint32_t files;
+    uint32_t errors;
+    uint32_t stalls;
+    uint16_t stalled;     /* most in flight at a sample in the interval */
+    uint16_t paused;      /* the interval ended paused */
+} TimelineSample;
+
+typedef struct {
+    TimelineSample* s;
+    uint32_t count;
+    uint32_t interval_ms;
+    uint32_t merges;            /* times the interval doubled */
+    uint64_t t0_ms;             /* start of sample 0 */
+    uint64_t last_ms;           /* start of the open interval */
+    uint32_t tail_ms;           /* length of the last sample when it is partial (0: full) */
+    TimelineCounters last;      /* totals at last_ms */
+    TimelineCounters seen;      /* totals at the last note in the open interval */
+    bool     seen_set;
+} Timeline;
+
+/* interval_s 0 or out of memory: false, and the other calls do nothing. */
+bool timeline_init(Timeline* tl, int interval_s, const TimelineCounters* c, uint64_t now);
+void timeline_free(Timeline* tl);
+/* True once the open interval has ended (so the caller gathers counters only then). */
+static inline bool timeline_due(const Timeline* tl, uint64_t now) {
+    return tl->s && now - tl->last_ms >= tl->interval_ms;
+}
+/* Between samples: remembers bytes, reads, files and errors (stalls are taken at samples only). */
+static inline void timeline_note(Timeline* tl, const TimelineCounters* c) {
+    tl->seen = *c;
+    tl->seen_set = true;
+}
+/* Closes every interval that ended before now: what was noted goes into the open one, the rest
+   of the counters' growth into the last one. */
+void timeline_tick(Timeline* tl, const TimelineCounters* c, uint64_t now);
+/* Closes the open (partial) interval too; call once at the end. */
+void timeline_finish(Timeline* tl, const TimelineCounters* c, uint64_t now);
+/* One CSV row per sample. */
+bool timeline_write_csv(const Timeline* tl, const char* path);
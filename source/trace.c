@@ -0,0 +1,201 @@
+#include "trace.h"
+#include "util.h"
+
+#include <stdatomic.h>
+
+#define TRACE_THREADS 64        /* the last one is shared by any further threads */
+#define TRACE_NO_STR  UINT32_MAX
+
+typedef struct {
+    uint64_t ts_us;             /* now_us() at the start */
+    uint64_t off;
+    uint32_t dur_us;
+    uint32_t len;
+    uint32_t str;               /* offset into the string buffer, or TRACE_NO_STR */
+    uint8_t  kind;
+    uint8_t  tid;
+    uint16_t pad;
+} TraceEvent;
+
+static struct {
+    TraceEvent* ev;
+    uint64_t    cap;
+    char*       str;
+    uint64_t    str_cap;
+    uint64_t    t0_us;
+    char        names[TRACE_THREADS][24];   /* each written by its own thread only */
+} g_tr;
+
+static atomic_bool        g_tr_on;
+static atomic_ullong      g_tr_n;       /* slots claimed (may pass cap: those are dropped) */
+static atomic_ullong      g_tr_str_used;
+static atomic_uint        g_tr_tids;
+static atomic_uint        g_tr_gen;     /* run number: thread ids are per run */
+static _Thread_local unsigned t_gen;
+static _Thread_local unsigned t_tid;
+
+static unsigned trace_tid(void) {
+    unsigned gen = atomic_load_explicit(&g_tr_gen, memory_order_relaxed);
+    if (t_gen != gen) {
+        t_gen = gen;
+        t_tid = atomic_fetch_add_explicit(&g_tr_tids, 1, memory_order_relaxed);
+        if (t_tid >= TRACE_THREADS) t_tid = TRACE_THREADS - 1;
+    }
+    return t_tid;
+}
+
+bool trace_start(uint32_t mib) {
+    if (mib == 0) return false;
+    if (mib > TRACE_MIB_MAX) mib = TRACE_MIB_MAX;
+    uint64_t bytes = (uint64_t)mib << 20;
+    /* An eighth for the paths of opens, stats and directory listings. */
+    g_tr.str_cap = bytes / 8;
+    g_tr.cap = (bytes - g_tr.str_cap) / sizeof(TraceEvent);
+    g_tr.ev = (TraceEvent*)malloc((size_t)(g_tr.cap * sizeof(TraceEvent)));
+    g_tr.str = (char*)malloc((size_t)g_tr.str_cap);
+    if (!g_tr.ev || !g_tr.str) {
+        free(g_tr.ev);
+        free(g_tr.str);
+        memset(&g_tr, 0, sizeof(g_tr));
+        return false;
+    }
+    memset(g_tr.names, 0, sizeof(g_tr.names));
+    g_tr.t0_us = now_us();
+    atomic_store_explicit(&g_tr_n, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_tr_str_used, 0, memory_order_relaxed);
+    atomic_store_explicit(&g_tr_tids, 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_tr_gen, 1, memory_order_relaxed);
+    atomic_store_explicit(&g_tr_on, true, memory_order_release);
+    trace_thread("main");
+    return true;
+}
+
+bool trace_active(void) {
+    return atomic_load_explicit(&g_tr_on, memory_order_acquire);
+}
+
+void trace_thread(const char* name) {
+    if (!atomic_load_explicit(&g_tr_on, memory_order_acquire)) return;
+    unsigned tid = trace_tid();
+    if (tid < TRACE_THREADS - 1) snprintf(g_tr.names[tid], sizeof(g_tr.names[tid]), "%s", name);
+}
+
+uint64_t trace_begin(void) {
+    return atomic_load_explicit(&g_tr_on, memory_order_relaxed) ? now_us() : 0;
+}
+
+void trace_end(int kind, uint64_t t0, const char* path, uint64_t off, uint64_t len) {
+    if (t0) trace_span(kind, t0, now_us(), path, off, len);
+}
+
+void trace_span(int kind, uint64_t t0, uint64_t t1, const char* path, uint64_t off, uint64_t len) {
+    if (!t0 || !atomic_load_explicit(&g_tr_on, memory_order_relaxed)) return;
+    uint64_t i = atomic_fetch_add_explicit(&g_tr_n, 1, memory_order_relaxed);
+    if (i >= g_tr.cap) return;
+    TraceEvent* e = &g_tr.ev[i];
+    e->ts_us = t0;
+    e->off = off;
+    e->dur_us = (t1 - t0 > UINT32_MAX) ? UINT32_MAX : (uint32_t)(t1 - t0);
+    e->len = (len > UINT32_MAX) ? UINT32_MAX : (uint32_t)len;
+    e->str = TRACE_NO_STR;
+    e->kind = (uint8_t)kind;
+    e->tid = (uint8_t)trace_tid();
+    e->pad = 0;
+    if (path) {
+        uint64_t n = strlen(path) + 1;
+        uint64_t o = atomic_fetch_add_explicit(&g_tr_str_used, n, memory_order_relaxed);
+        if (o + n <= g_tr.str_cap) {
+            memcpy(g_tr.str + o, path, (size_t)n);
+            e->str = (uint32_t)o;
+        }
+    }
+}
+
+static const char* trace_kind_name(int k) {
+    if (k < OP_KIND_COUNT) return op_kind_name((OpKind)k);
+    switch (k) {
+        case TRACE_CRC:  return "crc";
+        case TRACE_HASH: return "hash";
+        case TRACE_UI:   return "ui";
+        case TRACE_PAD:  return "pad";
+        default:         return "?";
+    }
+}
+
+static const char* trace_kind_cat(int k) {
+    if (k < OP_KIND_COUNT) return "io";
+    return (k == TRACE_CRC || k == TRACE_HASH) ? "cpu" : "ui";
+}
+
+static void json_str(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static bool trace_write(const char* path, uint64_t n, int threads) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    setvbuf(f, NULL, _IOFBF, 64 * 1024);
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"sdcheck\"}}");
+    for (int t = 0; t < threads; t++) {
+        char name[32];
+        if (g_tr.names[t][0]) snprintf(name, sizeof(name), "%s", g_tr.names[t]);
+        else snprintf(name, sizeof(name), "thread %d", t);
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", t);
+        json_str(f, name);
+        fprintf(f, "}}");
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        const TraceEvent* e = &g_tr.ev[i];
+        uint64_t ts = e->ts_us > g_tr.t0_us ? e->ts_us - g_tr.t0_us : 0;
+        fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u",
+                trace_kind_name(e->kind), trace_kind_cat(e->kind), (unsigned)e->tid, (unsigned long long)ts, e->dur_us);
+        if (e->len || e->str != TRACE_NO_STR) {
+            fprintf(f, ",\"args\":{");
+            if (e->len) fprintf(f, "\"off\":%llu,\"len\":%u%s", (unsigned long long)e->off, e->len, e->str != TRACE_NO_STR ? "," : "");
+            if (e->str != TRACE_NO_STR) {
+                fprintf(f, "\"path\":");
+                json_str(f, g_tr.str + e->str);
+            }
+            fprintf(f, "}");
+        }
+        fprintf(f, "}");
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+bool trace_stop(const char* path, TraceResult* out) {
+    if (out) memset(out, 0, sizeof(*out));
+    if (!atomic_load_explicit(&g_tr_on, memory_order_acquire)) return false;
+    atomic_store_explicit(&g_tr_on, false, memory_order_relaxed);
+
+    uint64_t claimed = atomic_load_explicit(&g_tr_n, memory_order_relaxed);
+    uint64_t n = claimed < g_tr.cap ? claimed : g_tr.cap;
+    int threads = (int)atomic_load_explicit(&g_tr_tids, memory_order_relaxed);
+    if (threads > TRACE_THREADS) threads = TRACE_THREADS;
+    if (out) {
+        out->events = n;
+        out->dropped = claimed - n;
+        out->threads = threads;
+    }
+    bool ok = path ? trace_write(path, n, threads) : true;
+    free(g_tr.ev);
+    free(g_tr.str);
+    memset(&g_tr, 0, sizeof(g_tr));
+    return ok;
+}
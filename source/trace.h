@@ -0,0 +1,51 @@
+#pragma once
+#include "app.h"
+#include "latency.h"
+
+/*
+ * Trace mode (trace_mib > 0): a Deep Check records one event per directory open and read, stat,
+ * file open, read, close, CRC and content-hash pass, UI redraw and pad poll, with its thread,
+ * start and duration, and writes them at the end as Chrome Trace Event JSON (load it in Perfetto
+ * or chrome://tracing). Events go into one buffer allocated at the start; a writer claims a slot
+ * with an atomic add, so recording takes no lock. A full buffer drops further events (counted).
+ */
+#ifndef TRACE_DIR
+#define TRACE_DIR "sdmc:"
+#endif
+#define TRACE_PATH TRACE_DIR "/sdcheck_trace.json"
+
+#define TRACE_MIB_MAX 256
+
+/* The first OP_KIND_COUNT kinds are the tracked file-system operations (OpKind). */
+typedef enum {
+    TRACE_CRC = OP_KIND_COUNT,
+    TRACE_HASH,
+    TRACE_UI,             /* running-screen redraw */
+    TRACE_PAD,            /* input polling */
+    TRACE_KIND_COUNT
+} TraceKind;
+
+typedef struct {
+    uint64_t events;
+    uint64_t dropped;     /* buffer full */
+    int      threads;
+} TraceResult;
+
+/* mib 0 or out of memory: false, nothing is recorded. Names the calling thread "main". */
+bool trace_start(uint32_t mib);
+/* Stops recording; path non-NULL: writes the JSON (false if that failed). Frees the buffer.
+   Every thread that records must have been joined. */
+bool trace_stop(const char* path, TraceResult* out);
+
+/* True while a run records. */
+bool trace_active(void);
+
+/* Names the calling thread in the trace (call at thread start; no-op when off). */
+void trace_thread(const char* name);
+
+/* 0 when tracing is off; pass to trace_end(). */
+uint64_t trace_begin(void);
+/* One event from t0 to now. path (optional) is copied; off/len are shown when len > 0. */
+void trace_end(int kind, uint64_t t0, const char* path, uint64_t off, uint64_t len);
+/* Same, with the end time already taken. */
+void trace_span(int kind, uint64_t t0, uint64_t t1, const char* path, uint64_t off, uint64_t len);
@@ -17,4 +17,8 @@ static inline uint64_t now_ms(void) {
     return armTicksToNs(armGetSystemTick()) / 1000000ULL;
 }
 
+static inline uint64_t now_us(void) {
+    return armTicksToNs(armGetSystemTick()) / 1000ULL;
+}
+
 double ticks_to_seconds(uint64_t ticks);
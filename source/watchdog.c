@@ -0,0 +1,199 @@
+#include "watchdog.h"
+#include "log.h"
+#include "util.h"
+#include "worker.h"
+
+#include <stdatomic.h>
+
+#define WD_SLOTS     32     /* walker, readers, range helpers and the UI thread at most */
+#define WD_PERIOD_MS 100
+#define WD_LOG_MAX   64     /* stalls logged one by one; later ones are only counted */
+
+struct WdOp {
+    bool     busy;
+    bool     flagged;       /* seen in flight past stall_ms */
+    OpKind   kind;
+    uint64_t off;
+    uint64_t len;
+    uint64_t start_us;
+    char     path[256];
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cv;             /* wakes the thread to stop */
+    bool            quit;
+    WorkerThread    thread;
+    uint32_t        stall_ms;
+    WdOp            ops[WD_SLOTS];
+    bool            live_set;
+    StallLive       live;
+    uint64_t        live_start_us;
+    StallStats      stats;
+    uint32_t        logged;
+} g_wd = { .lock = PTHREAD_MUTEX_INITIALIZER, .cv = PTHREAD_COND_INITIALIZER };
+
+static atomic_bool g_wd_on;
+
+const char* stall_bucket_name(int b) {
+    static const char* names[STALL_BUCKETS] = { "<1s", "1-2s", "2-5s", "5-10s", "10-30s", ">=30s" };
+    return (b >= 0 && b < STALL_BUCKETS) ? names[b] : "?";
+}
+
+static int stall_bucket(uint64_t ms) {
+    if (ms < 1000) return 0;
+    if (ms < 2000) return 1;
+    if (ms < 5000) return 2;
+    if (ms < 10000) return 3;
+    if (ms < 30000) return 4;
+    return 5;
+}
+
+static void watchdog_main(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_wd.lock);
+    while (!g_wd.quit) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t ns = (uint64_t)ts.tv_nsec + (uint64_t)WD_PERIOD_MS * 1000000ull;
+        ts.tv_sec += (time_t)(ns / 1000000000ull);
+        ts.tv_nsec = (long)(ns % 1000000000ull);
+        pthread_cond_timedwait(&g_wd.cv, &g_wd.lock, &ts);
+        if (g_wd.quit) break;
+
+        uint64_t now = now_us();
+        uint64_t limit = (uint64_t)g_wd.stall_ms * 1000u;
+        const WdOp* oldest = NULL;
+        int stalled = 0;
+        for (int i = 0; i < WD_SLOTS; i++) {
+            WdOp* op = &g_wd.ops[i];
+            if (!op->busy || now - op->start_us < limit) continue;
+            op->flagged = true;
+            stalled++;
+            if (!oldest || op->start_us < oldest->start_us) oldest = op;
+        }
+        g_wd.live_set = (oldest != NULL);
+        if (oldest) {
+            g_wd.live.stalled = stalled;
+            g_wd.live.kind = oldest->kind;
+            g_wd.live.off = oldest->off;
+            g_wd.live.len = oldest->len;
+            g_wd.live_start_us = oldest->start_us;
+            memcpy(g_wd.live.path, oldest->path, sizeof(g_wd.live.path));
+        }
+    }
+    pthread_mutex_unlock(&g_wd.lock);
+}
+
+bool watchdog_start(uint32_t stall_ms) {
+    pthread_mutex_lock(&g_wd.lock);
+    memset(g_wd.ops, 0, sizeof(g_wd.ops));
+    memset(&g_wd.stats, 0, sizeof(g_wd.stats));
+    g_wd.live_set = false;
+    g_wd.logged = 0;
+    g_wd.stall_ms = stall_ms;
+    g_wd.quit = false;
+    pthread_mutex_unlock(&g_wd.lock);
+    if (stall_ms == 0) return true;
+
+    if (!worker_start(&g_wd.thread, watchdog_main, NULL, WORKER_CORE_DEFAULT, 0x8000)) {
+        log_push("WARN", "Stall watchdog: thread start failed; stalls are not tracked.");
+        return false;
+    }
+    atomic_store_explicit(&g_wd_on, true, memory_order_release);
+    return true;
+}
+
+void watchdog_stop(StallStats* out) {
+    if (atomic_load_explicit(&g_wd_on, memory_order_acquire)) {
+        atomic_store_explicit(&g_wd_on, false, memory_order_relaxed);
+        pthread_mutex_lock(&g_wd.lock);
+        g_wd.quit = true;
+        pthread_cond_broadcast(&g_wd.cv);
+        pthread_mutex_unlock(&g_wd.lock);
+        worker_join(&g_wd.thread);
+    }
+    pthread_mutex_lock(&g_wd.lock);
+    if (out) *out = g_wd.stats;
+    g_wd.live_set = false;
+    pthread_mutex_unlock(&g_wd.lock);
+}
+
+WdOp* wd_begin(OpKind kind, const char* path, uint64_t off, uint64_t len) {
+    if (!atomic_load_explicit(&g_wd_on, memory_order_relaxed)) return NULL;
+    WdOp* op = NULL;
+    pthread_mutex_lock(&g_wd.lock);
+    for (int i = 0; i < WD_SLOTS; i++) {
+        if (g_wd.ops[i].busy) continue;
+        op = &g_wd.ops[i];
+        op->busy = true;
+        op->flagged = false;
+        op->kind = kind;
+        op->off = off;
+        op->len = len;
+        snprintf(op->path, sizeof(op->path), "%s", path ? path : "");
+        op->start_us = now_us();
+        break;
+    }
+    pthread_mutex_unlock(&g_wd.lock);
+    return op;
+}
+
+void wd_end(WdOp* op) {
+    if (!op) return;
+    pthread_mutex_lock(&g_wd.lock);
+    uint64_t ms = (now_us() - op->start_us) / 1000u;
+    bool stall = op->flagged || ms >= g_wd.stall_ms;
+    bool log_it = false;
+    bool log_last = false;
+    char path[256];
+    OpKind kind = op->kind;
+    uint64_t off = op->off;
+    uint64_t len = op->len;
+    if (stall) {
+        StallStats* s = &g_wd.stats;
+        s->count++;
+        s->total_ms += ms;
+        s->hist[stall_bucket(ms)]++;
+        if (ms > s->max_ms) {
+            s->max_ms = ms;
+            s->max_kind = op->kind;
+            memcpy(s->max_path, op->path, sizeof(s->max_path));
+        }
+        uint32_t n = g_wd.logged++;
+        log_it = (n < WD_LOG_MAX);
+        log_last = (n == WD_LOG_MAX - 1);
+        if (log_it) memcpy(path, op->path, sizeof(path));
+    }
+    op->busy = false;
+    pthread_mutex_unlock(&g_wd.lock);
+
+    if (!log_it) return;
+    char disp[96];
+    tail_ellipsize(disp, sizeof(disp), path, 80);
+    if (kind == OP_READ)
+        log_pushf("WARN", "Stall: %s took %llu ms @ %llu (+%llu KiB) %s", op_kind_name(kind), (unsigned long long)ms,
+                  (unsigned long long)off, (unsigned long long)(len / 1024), disp);
+    else
+        log_pushf("WARN", "Stall: %s took %llu ms %s", op_kind_name(kind), (unsigned long long)ms, disp);
+    if (log_last) log_pushf("WARN", "Stall: %d logged; further stalls are only counted.", WD_LOG_MAX);
+}
+
+bool watchdog_live(StallLive* out) {
+    if (!atomic_load_explicit(&g_wd_on, memory_order_relaxed)) return false;
+    pthread_mutex_lock(&g_wd.lock);
+    bool set = g_wd.live_set;
+    if (set) {
+        *out = g_wd.live;
+        out->age_ms = (now_us() - g_wd.live_start_us) / 1000u;
+    }
+    pthread_mutex_unlock(&g_wd.lock);
+    return set;
+}
+
+uint64_t watchdog_stall_count(void) {
+    pthread_mutex_lock(&g_wd.lock);
+    uint64_t n = g_wd.stats.count;
+    pthread_mutex_unlock(&g_wd.lock);
+    return n;
+}
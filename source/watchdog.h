@@ -0,0 +1,82 @@
+#pragma once
+#include "app.h"
+#include "latency.h"
+#include "trace.h"
+#include "util.h"
+
+/*
+ * Stall watchdog for Deep Check. Every file-system operation of the engine registers itself
+ * while it is in flight (kind, path, offset, size, start time). A watchdog thread looks at the
+ * registry every 100 ms and flags operations older than stall_ms, so a hung card shows on the
+ * running screen while the read is still blocked, not after it returns. A flagged operation is
+ * logged with its duration when it completes, and counted in a distribution of stall durations.
+ * Stopped (or stall_ms 0), wd_begin() returns NULL and costs one atomic load.
+ */
+#define STALL_BUCKETS 6   /* < 1 s, 1-2 s, 2-5 s, 5-10 s, 10-30 s, >= 30 s */
+
+typedef struct {
+    uint64_t count;                  /* completed operations that were flagged */
+    uint64_t total_ms;
+    uint64_t max_ms;
+    OpKind   max_kind;
+    char     max_path[256];
+    uint64_t hist[STALL_BUCKETS];
+} StallStats;
+
+/* Oldest flagged operation still in flight, for the running screen. */
+typedef struct {
+    int      stalled;                /* flagged operations in flight */
+    OpKind   kind;
+    uint64_t off;
+    uint64_t len;
+    uint64_t age_ms;
+    char     path[256];
+} StallLive;
+
+typedef struct WdOp WdOp;
+
+/* Starts the thread for a run (clears the stall statistics). stall_ms 0: tracking off. */
+bool watchdog_start(uint32_t stall_ms);
+/* Joins the thread; out (optional) gets the run's statistics. */
+void watchdog_stop(StallStats* out);
+
+/* NULL when tracking is off or all slots are in use; wd_end(NULL) does nothing. */
+WdOp* wd_begin(OpKind kind, const char* path, uint64_t off, uint64_t len);
+void wd_end(WdOp* op);
+
+/* False when nothing is flagged right now. */
+bool watchdog_live(StallLive* out);
+/* Flagged operations that completed so far this run. */
+uint64_t watchdog_stall_count(void);
+
+const char* stall_bucket_name(int b);
+
+/* One file-system operation: registered with the watchdog, its latency recorded into
+   lat[kind] (lat NULL: not recorded) and, in trace mode, an event (path kept for all but reads
+   and closes; path must stay valid until op_leave). op_leave() keeps errno. */
+typedef struct {
+    WdOp*       wd;
+    uint64_t    t0;
+    OpKind      kind;
+    const char* path;
+    uint64_t    off;
+    uint64_t    len;
+} OpScope;
+
+static inline void op_enter(OpScope* s, OpKind kind, const char* path, uint64_t off, uint64_t len) {
+    s->kind = kind;
+    s->path = path;
+    s->off = off;
+    s->len = len;
+    s->wd = wd_begin(kind, path, off, len);
+    s->t0 = now_us();
+}
+
+static inline void op_leave(OpScope* s, LatHist* lat) {
+    int e = errno;
+    uint64_t t1 = now_us();
+    if (lat) lat_record(&lat[s->kind], t1 - s->t0);
+    trace_span(s->kind, s->t0, t1, (s->kind == OP_READ || s->kind == OP_CLOSE) ? NULL : s->path, s->off, s->len);
+    wd_end(s->wd);
+    errno = e;
+}
@@ -0,0 +1,85 @@
+#include "worker.h"
+
+#ifdef __SWITCH__
+
+bool worker_start(WorkerThread* w, WorkerFn fn, void* arg, int core, size_t stack_size) {
+    if (!w || !fn) return false;
+    memset(w, 0, sizeof(*w));
+    if (stack_size < 0x4000) stack_size = 0x4000;
+
+    Result rc = threadCreate(&w->thr, fn, arg, NULL, stack_size, 0x2C, core);
+    if (R_FAILED(rc) && core != WORKER_CORE_DEFAULT) {
+        /* Core not available to this process (applet mode): let the kernel pick. */
+        rc = threadCreate(&w->thr, fn, arg, NULL, stack_size, 0x2C, WORKER_CORE_DEFAULT);
+    }
+    if (R_FAILED(rc)) return false;
+
+    if (R_FAILED(threadStart(&w->thr))) {
+        threadClose(&w->thr);
+        return false;
+    }
+    w->running = true;
+    return true;
+}
+
+void worker_join(WorkerThread* w) {
+    if (!w || !w->running) return;
+    threadWaitForExit(&w->thr);
+    threadClose(&w->thr);
+    w->running = false;
+}
+
+void worker_detach(WorkerThread* w) {
+    if (w) w->running = false;
+}
+
+#else
+
+typedef struct {
+    WorkerFn fn;
+    void* arg;
+} WorkerTrampoline;
+
+static void* worker_trampoline(void* p) {
+    WorkerTrampoline t = *(WorkerTrampoline*)p;
+    free(p);
+    t.fn(t.arg);
+    return NULL;
+}
+
+bool worker_start(WorkerThread* w, WorkerFn fn, void* arg, int core, size_t stack_size) {
+    (void)core;
+    if (!w || !fn) return false;
+    memset(w, 0, sizeof(*w));
+
+    WorkerTrampoline* t = (WorkerTrampoline*)malloc(sizeof(*t));
+    if (!t) return false;
+    t->fn = fn;
+    t->arg = arg;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (stack_size >= 0x4000) pthread_attr_setstacksize(&attr, stack_size);
+    int e = pthread_create(&w->thr, &attr, worker_trampoline, t);
+    pthread_attr_destroy(&attr);
+    if (e != 0) {
+        free(t);
+        return false;
+    }
+    w->running = true;
+    return true;
+}
+
+void worker_join(WorkerThread* w) {
+    if (!w || !w->running) return;
+    pthread_join(w->thr, NULL);
+    w->running = false;
+}
+
+void worker_detach(WorkerThread* w) {
+    if (!w || !w->running) return;
+    pthread_detach(w->thr);
+    w->running = false;
+}
+
+#endif
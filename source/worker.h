@@ -0,0 +1,29 @@
+#pragma once
+#include "app.h"
+
+#include <pthread.h>
+
+/*
+ * Background thread helper.
+ * On Switch threads are created through libnx so they can be placed on a specific core
+ * (newlib's pthread_create always uses the default core). Host builds use pthreads.
+ * Synchronization uses pthread mutex/cond on both (libnx implements them).
+ */
+typedef void (*WorkerFn)(void* arg);
+
+typedef struct {
+#ifdef __SWITCH__
+    Thread   thr;
+#else
+    pthread_t thr;
+#endif
+    bool     running;
+} WorkerThread;
+
+#define WORKER_CORE_DEFAULT (-2)
+
+bool worker_start(WorkerThread* w, WorkerFn fn, void* arg, int core, size_t stack_size);
+void worker_join(WorkerThread* w);
+/* Lets a thread that may never return run on unjoined (a read blocked in a hung card).
+   On Switch its stack and Thread object stay allocated. */
+void worker_detach(WorkerThread* w);